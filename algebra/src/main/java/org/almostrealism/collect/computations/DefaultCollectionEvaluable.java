@@ -20,10 +20,10 @@ import io.almostrealism.scope.ArrayVariable;
 import org.almostrealism.collect.PackedCollection;
 import org.almostrealism.collect.TraversalPolicy;
 import org.almostrealism.hardware.AcceleratedComputationEvaluable;
+import org.almostrealism.hardware.KernelOperator;
 import org.almostrealism.hardware.MemoryBank;
 import org.almostrealism.hardware.MemoryData;
 import io.almostrealism.code.Computation;
-import org.almostrealism.hardware.cl.HardwareOperator;
 
 import java.util.function.BiFunction;
 import java.util.function.Consumer;
@@ -41,10 +41,7 @@ public class DefaultCollectionEvaluable<T extends PackedCollection> extends Acce
 
 	@Override
 	public T evaluate(Object... args) {
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+		compileIfNecessary();
 
 		ArrayVariable outputVariable = (ArrayVariable) getComputation().getOutputVariable();
 
@@ -66,31 +63,34 @@ public class DefaultCollectionEvaluable<T extends PackedCollection> extends Acce
 	}
 
 	@Override
-	public synchronized Object[] apply(Object[] args) {
+	public Object[] apply(Object[] args) {
 		throw new UnsupportedOperationException();
 	}
 
-	public synchronized Object[] apply(int outputArgIndex, Object[] args) {
+	public Object[] apply(int outputArgIndex, Object[] args) {
 		if (!isKernel() || !enableKernel) return super.apply(args);
 
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+		compileIfNecessary();
 
 		MemoryData memArgs[] = Stream.of(args).toArray(MemoryData[]::new);
 
-		Consumer<Object[]> operator = getOperator();
+		beginInvocation();
 
-		if (enableKernelLog) System.out.println("AcceleratedOperation: Preparing " + getName() + " kernel...");
-		MemoryData input[] = getKernelArgs(null, memArgs);
-		((HardwareOperator) operator).setGlobalWorkOffset(0);
-		((HardwareOperator) operator).setGlobalWorkSize(workSize(input[outputArgIndex]));
+		try {
+			Consumer<Object[]> operator = getOperator();
 
-		if (enableKernelLog) System.out.println("AcceleratedOperation: Evaluating " + getName() + " kernel...");
+			if (enableKernelLog) System.out.println("AcceleratedOperation: Preparing " + getName() + " kernel...");
+			MemoryData input[] = getKernelArgs(null, memArgs);
+			((KernelOperator) operator).setGlobalWorkOffset(0);
+			((KernelOperator) operator).setGlobalWorkSize(workSize(input[outputArgIndex]));
 
-		operator.accept(input);
-		return input;
+			if (enableKernelLog) System.out.println("AcceleratedOperation: Evaluating " + getName() + " kernel...");
+
+			operator.accept(input);
+			return input;
+		} finally {
+			endInvocation();
+		}
 	}
 
 	private int workSize(MemoryData data) {
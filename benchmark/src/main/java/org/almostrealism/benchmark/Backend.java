@@ -0,0 +1,88 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.hardware.Hardware;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+
+/**
+ * Selects the hardware backend for a benchmark fork. The properties are set before
+ * anything refers to {@link org.almostrealism.hardware.Hardware}, which reads them
+ * once when it is initialized, so every benchmark state that uses the hardware must
+ * accept a {@link Backend} in its {@link Setup} method to be initialized after it.
+ * JMH runs each combination of parameters in a separate fork, so one run can compare
+ * several backends (for example, "-p backend=native,external,cl,gpu -p precision=64,32").
+ * With the value "default", the AR_HARDWARE_* properties given to the JVM, or the
+ * environment, are used unchanged. Otherwise the properties take precedence over the
+ * environment, and the trial fails if the hardware does not end up with the requested
+ * precision.
+ */
+@State(Scope.Benchmark)
+public class Backend {
+	public static final String DEFAULT = "default";
+
+	/** One of "default", "jvm", "native", "external", "cl" or "gpu". */
+	@Param(DEFAULT)
+	public String backend;
+
+	/** One of "default", "64" or "32". */
+	@Param(DEFAULT)
+	public String precision;
+
+	@Setup(Level.Trial)
+	public void select() {
+		switch (backend) {
+			case DEFAULT:
+				break;
+			case "jvm":
+				System.setProperty("AR_HARDWARE_MEMORY_PROVIDER", "jvm");
+				break;
+			case "native":
+				System.setProperty("AR_HARDWARE_MEMORY_PROVIDER", "native");
+				System.setProperty("AR_HARDWARE_NATIVE_EXECUTION", "jni");
+				break;
+			case "external":
+				System.setProperty("AR_HARDWARE_MEMORY_PROVIDER", "native");
+				System.setProperty("AR_HARDWARE_NATIVE_EXECUTION", "external");
+				break;
+			case "cl":
+				System.setProperty("AR_HARDWARE_MEMORY_PROVIDER", "cl");
+				System.setProperty("AR_HARDWARE_PLATFORM", "cpu");
+				break;
+			case "gpu":
+				System.setProperty("AR_HARDWARE_MEMORY_PROVIDER", "cl");
+				System.setProperty("AR_HARDWARE_PLATFORM", "gpu");
+				break;
+			default:
+				throw new IllegalArgumentException("Unknown backend " + backend);
+		}
+
+		if (!DEFAULT.equals(precision)) {
+			System.setProperty("AR_HARDWARE_PRECISION", precision);
+
+			boolean dp = Hardware.getLocalHardware().isDoublePrecision();
+			if (dp != "64".equals(precision)) {
+				throw new IllegalStateException("Requested precision " + precision +
+						" but the hardware uses " + (dp ? "64" : "32") + " bit precision");
+			}
+		}
+	}
+}
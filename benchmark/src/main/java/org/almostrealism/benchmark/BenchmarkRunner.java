@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.io.SystemUtils;
+import org.openjdk.jmh.results.format.ResultFormatType;
+import org.openjdk.jmh.runner.Runner;
+import org.openjdk.jmh.runner.RunnerException;
+import org.openjdk.jmh.runner.options.CommandLineOptionException;
+import org.openjdk.jmh.runner.options.CommandLineOptions;
+import org.openjdk.jmh.runner.options.Options;
+import org.openjdk.jmh.runner.options.OptionsBuilder;
+
+/**
+ * Runs the benchmarks, accepting the same arguments as the JMH command line, and
+ * writes the results as JSON so that they can be compared between runs. The file
+ * is AR_BENCHMARK_RESULTS, or benchmark-results.json by default, unless the
+ * arguments include "-rf" or "-rff". For example:
+ *
+ * <pre>
+ *     java -jar benchmark/target/benchmarks.jar Dispatch -p backend=native,external,cl
+ * </pre>
+ */
+public class BenchmarkRunner {
+	public static void main(String args[]) throws RunnerException, CommandLineOptionException {
+		CommandLineOptions cmd = new CommandLineOptions(args);
+
+		OptionsBuilder builder = new OptionsBuilder();
+		builder.parent(cmd);
+
+		if (!cmd.getResultFormat().hasValue()) {
+			builder.resultFormat(ResultFormatType.JSON);
+		}
+
+		if (!cmd.getResult().hasValue()) {
+			builder.result(SystemUtils.getProperty("AR_BENCHMARK_RESULTS", "benchmark-results.json"));
+		}
+
+		Options options = builder.build();
+		new Runner(options).run();
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.jni.NativeCompiler;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.io.File;
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.Comparator;
+import java.util.concurrent.TimeUnit;
+import java.util.stream.Stream;
+
+/**
+ * Measures the latency of compiling a native library with {@link NativeCompiler}.
+ * The cold benchmark changes the source every time, so that it is never found in
+ * the {@link org.almostrealism.hardware.jni.NativeLibraryCache}, while the cached
+ * benchmark compiles the same source every time. This requires AR_HARDWARE_NATIVE_COMPILER,
+ * and the cached benchmark is only different from the cold one when the cache is enabled.
+ * Libraries are written to a temporary directory, which is removed at the end of the trial.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 2, time = 1)
+@Measurement(iterations = 5, time = 2)
+@Fork(1)
+@State(Scope.Benchmark)
+public class CompileBenchmark {
+	private static final String CODE = "double ar_benchmark_scale(double *values, int count, double factor) {\n" +
+			"\tdouble sum = 0.0;\n" +
+			"\tfor (int i = 0; i < count; i++) {\n" +
+			"\t\tvalues[i] = values[i] * factor;\n" +
+			"\t\tsum += values[i];\n" +
+			"\t}\n" +
+			"\treturn sum;\n" +
+			"}\n";
+
+	private Path libDir;
+	private String previousLibDir;
+	private NativeCompiler compiler;
+	private long version;
+
+	@Setup(Level.Trial)
+	public void setup(Backend backend) throws IOException {
+		libDir = Files.createTempDirectory("ar-compile-benchmark");
+		previousLibDir = System.setProperty("AR_HARDWARE_NATIVE_LIBS", libDir.toString());
+
+		compiler = NativeCompiler.factory(Hardware.getLocalHardware(), false).construct();
+		compiler.compile("ArBenchmarkCached", CODE, true);
+	}
+
+	@TearDown(Level.Trial)
+	public void tearDown() throws IOException {
+		if (previousLibDir == null) {
+			System.clearProperty("AR_HARDWARE_NATIVE_LIBS");
+		} else {
+			System.setProperty("AR_HARDWARE_NATIVE_LIBS", previousLibDir);
+		}
+
+		if (libDir == null) return;
+
+		try (Stream<Path> paths = Files.walk(libDir)) {
+			paths.sorted(Comparator.reverseOrder()).map(Path::toFile).forEach(File::delete);
+		}
+
+		libDir = null;
+	}
+
+	@Benchmark
+	public String cold() {
+		return compiler.compile("ArBenchmarkCold", "/* " + System.nanoTime() + "-" + version++ + " */\n" + CODE, true);
+	}
+
+	@Benchmark
+	public String cached() {
+		return compiler.compile("ArBenchmarkCached", CODE, true);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import io.almostrealism.relation.Evaluable;
+import org.almostrealism.CodeFeatures;
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.algebra.Vector;
+import org.almostrealism.hardware.OperationList;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the cost of a single call to an operation which does almost no work,
+ * which is dominated by the overhead of dispatching it to the backend. With the
+ * "external" backend this is the round trip through the external wrapper.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Benchmark)
+public class DispatchBenchmark implements CodeFeatures {
+	/** The number of operations in the {@link OperationList}. */
+	@Param({ "1", "16" })
+	public int operations;
+
+	private Scalar result;
+	private Runnable assignment;
+	private Runnable list;
+
+	private Vector a, b;
+	private Evaluable<? extends Vector> product;
+
+	@Setup(Level.Trial)
+	public void setup(Backend backend) {
+		result = new Scalar();
+		assignment = a(2, p(result), scalarAdd(v(1.0), v(2.0))).get();
+
+		OperationList ops = new OperationList("DispatchBenchmark");
+		for (int i = 0; i < operations; i++) {
+			ops.add(a(2, p(result), scalarAdd(v(1.0), v((double) i))));
+		}
+
+		list = ops.get();
+
+		a = new Vector(1.0, 2.0, 3.0);
+		b = new Vector(4.0, 5.0, 6.0);
+		product = crossProduct(v(Vector.class, 0), v(Vector.class, 1)).get();
+	}
+
+	@Benchmark
+	public Scalar run() {
+		assignment.run();
+		return result;
+	}
+
+	@Benchmark
+	public Scalar operationList() {
+		list.run();
+		return result;
+	}
+
+	@Benchmark
+	public Vector evaluate() {
+		return product.evaluate(a, b);
+	}
+}
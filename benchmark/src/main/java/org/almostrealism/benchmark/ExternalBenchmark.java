@@ -0,0 +1,95 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.CodeFeatures;
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.algebra.Vector;
+import org.almostrealism.algebra.VectorBank;
+import org.almostrealism.hardware.KernelizedEvaluable;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the round trip through the external wrapper, which writes the arguments
+ * to the data directory, runs the compiled executable and reads the results back.
+ * This always uses native memory with external execution, regardless of the
+ * {@link Backend}, and requires AR_HARDWARE_EXTERNAL_COMPILER, AR_HARDWARE_NATIVE_LIBS
+ * and AR_HARDWARE_DATA.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(value = 1, jvmArgsAppend = {
+		"-DAR_HARDWARE_MEMORY_PROVIDER=native",
+		"-DAR_HARDWARE_NATIVE_EXECUTION=external" })
+@State(Scope.Benchmark)
+public class ExternalBenchmark implements CodeFeatures {
+	/** The number of values in the bank for the batch benchmark. */
+	@Param({ "1", "1024" })
+	public int count;
+
+	private Scalar result;
+	private Runnable assignment;
+
+	private VectorBank a, b, out;
+	private KernelizedEvaluable<Vector> sum;
+
+	@Setup(Level.Trial)
+	public void setup() {
+		result = new Scalar();
+		assignment = a(2, p(result), scalarAdd(v(1.0), v(2.0))).get();
+
+		a = new VectorBank(count);
+		b = new VectorBank(count);
+		out = new VectorBank(count);
+		sum = (KernelizedEvaluable<Vector>) add(v(Vector.class, 0), v(Vector.class, 1)).get();
+	}
+
+	@TearDown(Level.Trial)
+	public void teardown() {
+		a.destroy();
+		b.destroy();
+		out.destroy();
+	}
+
+	@Benchmark
+	public Scalar roundTrip() {
+		assignment.run();
+		return result;
+	}
+
+	@Benchmark
+	public VectorBank batch() {
+		sum.kernelEvaluate(out, a, b);
+		return out;
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.CodeFeatures;
+import org.almostrealism.algebra.Vector;
+import org.almostrealism.algebra.VectorBank;
+import org.almostrealism.color.RGB;
+import org.almostrealism.color.RGBBank;
+import org.almostrealism.color.RGBFeatures;
+import org.almostrealism.geometry.Ray;
+import org.almostrealism.geometry.RayBank;
+import org.almostrealism.hardware.KernelizedEvaluable;
+import org.almostrealism.hardware.MemoryData;
+import org.openjdk.jmh.annotations.AuxCounters;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.Random;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the throughput of kernels for representative {@link Vector}, {@link Ray}
+ * and {@link RGB} computations, evaluated over banks of values. The "elements"
+ * counter reports the number of values computed per second.
+ */
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Benchmark)
+public class KernelBenchmark implements CodeFeatures {
+	/** The number of values in each bank. */
+	@Param({ "1024", "65536" })
+	public int count;
+
+	private VectorBank vectorsA, vectorsB, vectorsOut;
+	private RayBank rays;
+	private RGBBank colorsA, colorsB, colorsOut;
+
+	private KernelizedEvaluable<Vector> crossProduct;
+	private KernelizedEvaluable<Vector> pointAt;
+	private KernelizedEvaluable<RGB> colorSum;
+
+	@Setup(Level.Trial)
+	public void setup(Backend backend) {
+		Random random = new Random(1);
+
+		vectorsA = fill(new VectorBank(count), random);
+		vectorsB = fill(new VectorBank(count), random);
+		vectorsOut = new VectorBank(count);
+		rays = fill(new RayBank(count), random);
+		colorsA = fill(new RGBBank(count), random);
+		colorsB = fill(new RGBBank(count), random);
+		colorsOut = new RGBBank(count);
+
+		RGBFeatures color = new RGBFeatures() { };
+
+		crossProduct = (KernelizedEvaluable<Vector>) crossProduct(v(Vector.class, 0), v(Vector.class, 1)).get();
+		pointAt = (KernelizedEvaluable<Vector>) add(origin(v(Ray.class, 0)), direction(v(Ray.class, 0))).get();
+		colorSum = (KernelizedEvaluable<RGB>) color.cadd(v(RGB.class, 0), v(RGB.class, 1)).get();
+	}
+
+	@TearDown(Level.Trial)
+	public void teardown() {
+		vectorsA.destroy();
+		vectorsB.destroy();
+		vectorsOut.destroy();
+		rays.destroy();
+		colorsA.destroy();
+		colorsB.destroy();
+		colorsOut.destroy();
+	}
+
+	@Benchmark
+	public VectorBank vectorCrossProduct(Elements elements) {
+		crossProduct.kernelEvaluate(vectorsOut, vectorsA, vectorsB);
+		elements.elements += count;
+		return vectorsOut;
+	}
+
+	@Benchmark
+	public VectorBank rayPointAt(Elements elements) {
+		pointAt.kernelEvaluate(vectorsOut, rays);
+		elements.elements += count;
+		return vectorsOut;
+	}
+
+	@Benchmark
+	public RGBBank rgbSum(Elements elements) {
+		colorSum.kernelEvaluate(colorsOut, colorsA, colorsB);
+		elements.elements += count;
+		return colorsOut;
+	}
+
+	private static <T extends MemoryData> T fill(T data, Random random) {
+		double values[] = new double[data.getMemLength()];
+		for (int i = 0; i < values.length; i++) values[i] = random.nextDouble();
+		data.setMem(0, values, 0, values.length);
+		return data;
+	}
+
+	@AuxCounters(AuxCounters.Type.OPERATIONS)
+	@State(Scope.Thread)
+	public static class Elements {
+		public long elements;
+
+		@Setup(Level.Iteration)
+		public void reset() { elements = 0; }
+	}
+}
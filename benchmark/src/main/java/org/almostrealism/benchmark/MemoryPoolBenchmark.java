@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.algebra.ScalarPool;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OperationsPerInvocation;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Threads;
+import org.openjdk.jmh.annotations.Warmup;
+import org.openjdk.jmh.infra.Blackhole;
+import org.openjdk.jmh.infra.ThreadParams;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the cost of {@link org.almostrealism.hardware.mem.MemoryPool#reserveOffset},
+ * from one thread and from several threads sharing the pool. A new pool is created
+ * for every iteration, and each iteration reserves every segment of it once, so that
+ * the result does not depend on when the garbage collector releases earlier owners.
+ */
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations = 20)
+@Measurement(iterations = 50)
+@Fork(1)
+@State(Scope.Benchmark)
+public class MemoryPoolBenchmark {
+	public static final int SIZE = 16384;
+	public static final int THREADS = 4;
+
+	private ScalarPool pool;
+	private Scalar owners[];
+
+	@Setup(Level.Iteration)
+	public void setup(Backend backend) {
+		pool = new ScalarPool(SIZE);
+		owners = new Scalar[SIZE];
+		for (int i = 0; i < SIZE; i++) owners[i] = pool.get(i);
+	}
+
+	@TearDown(Level.Iteration)
+	public void teardown() {
+		pool.destroy();
+		owners = null;
+	}
+
+	@Benchmark
+	@OperationsPerInvocation(SIZE)
+	public void reserve(Blackhole bh) {
+		for (int i = 0; i < SIZE; i++) {
+			bh.consume(pool.reserveOffset(owners[i]));
+		}
+	}
+
+	@Benchmark
+	@Threads(THREADS)
+	@OperationsPerInvocation(SIZE / THREADS)
+	public void reserveContended(ThreadParams thread, Blackhole bh) {
+		int start = thread.getThreadIndex() * (SIZE / THREADS);
+
+		for (int i = start; i < start + SIZE / THREADS; i++) {
+			bh.consume(pool.reserveOffset(owners[i]));
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.benchmark;
+
+import org.almostrealism.collect.PackedCollection;
+import org.almostrealism.hardware.Hardware;
+import org.openjdk.jmh.annotations.AuxCounters;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Measures the bandwidth of copying data between the heap and the memory of the
+ * backend, which is the path through {@link org.almostrealism.c.NativeRead} and
+ * {@link org.almostrealism.c.NativeWrite} for native memory and through the
+ * command queue for OpenCL memory. The "bytes" counter reports the bandwidth.
+ */
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Benchmark)
+public class TransferBenchmark {
+	/** The number of values which are copied. */
+	@Param({ "16", "1024", "65536", "1048576" })
+	public int size;
+
+	private PackedCollection memory;
+	private double data[];
+	private int numberSize;
+
+	@Setup(Level.Trial)
+	public void setup(Backend backend) {
+		memory = new PackedCollection(size);
+		data = new double[size];
+		for (int i = 0; i < size; i++) data[i] = i;
+		numberSize = Hardware.getLocalHardware().getNumberSize();
+	}
+
+	@TearDown(Level.Trial)
+	public void teardown() {
+		memory.destroy();
+	}
+
+	@Benchmark
+	public void write(Bytes bytes) {
+		memory.setMem(0, data, 0, size);
+		bytes.bytes += (long) size * numberSize;
+	}
+
+	@Benchmark
+	public double[] read(Bytes bytes) {
+		memory.getMem(0, data, 0, size);
+		bytes.bytes += (long) size * numberSize;
+		return data;
+	}
+
+	@AuxCounters(AuxCounters.Type.OPERATIONS)
+	@State(Scope.Thread)
+	public static class Bytes {
+		public long bytes;
+
+		@Setup(Level.Iteration)
+		public void reset() { bytes = 0; }
+	}
+}
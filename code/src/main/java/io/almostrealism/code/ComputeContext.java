@@ -18,6 +18,9 @@ package io.almostrealism.code;
 
 import io.almostrealism.scope.Scope;
 
+import java.util.List;
+import java.util.stream.Collectors;
+
 public interface ComputeContext<MEM> {
 	Computer<MEM> getComputer();
 
@@ -29,6 +32,15 @@ public interface ComputeContext<MEM> {
 	 */
 	InstructionSet deliver(Scope scope);
 
+	/**
+	 * Deliver all of the specified {@link Scope}s, which allows a {@link ComputeContext}
+	 * to compile them together. The resulting {@link InstructionSet}s are in the same
+	 * order as the {@link Scope}s.
+	 */
+	default List<InstructionSet> deliver(List<Scope> scopes) {
+		return scopes.stream().map(this::deliver).collect(Collectors.toList());
+	}
+
 	boolean isKernelSupported();
 
 	void destroy();
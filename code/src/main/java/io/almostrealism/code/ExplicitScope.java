@@ -18,13 +18,25 @@ package io.almostrealism.code;
 
 import io.almostrealism.scope.Argument;
 import io.almostrealism.scope.Scope;
+import io.almostrealism.scope.Variable;
 
+import java.util.Collection;
+import java.util.Collections;
+import java.util.HashSet;
 import java.util.List;
+import java.util.Set;
 import java.util.function.Consumer;
 import java.util.function.Function;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
 import java.util.stream.Collectors;
 
 public class ExplicitScope<T> extends Scope<T> {
+	private static final Pattern IDENTIFIER = Pattern.compile("[A-Za-z_][A-Za-z0-9_]*");
+
+	/** Suffixes of the names of the offset and size parameters generated for each argument. */
+	private static final String SUFFIXES[] = { "", "Offset", "Size" };
+
 	private StringBuffer code;
 	private List<Argument<?>> arguments;
 
@@ -59,6 +71,58 @@ public class ExplicitScope<T> extends Scope<T> {
 		return result;
 	}
 
+	/**
+	 * Includes the names of the explicit arguments which appear in the code, either
+	 * on their own or as part of the name of their offset or size.
+	 */
+	@Override
+	public Set<String> getReferencedNames() {
+		Set<String> names = super.getReferencedNames();
+		if (arguments == null) return names;
+
+		Set<String> identifiers = identifiers(code.toString());
+
+		arguments.stream()
+				.map(arg -> names(arg.getVariable()))
+				.filter(n -> n.stream().anyMatch(name -> isReferenced(name, identifiers)))
+				.forEach(names::addAll);
+		return names;
+	}
+
+	@Override
+	protected Set<String> getUnreferencedArguments() {
+		return getUnreferencedArguments(getReferencedNames());
+	}
+
+	/**
+	 * Returns the names of the explicit arguments, other than the first, which
+	 * are not among the specified referenced names. The first argument is the
+	 * output, so it is always retained.
+	 */
+	public Set<String> getUnreferencedArguments(Collection<String> referenced) {
+		if (arguments == null || arguments.size() < 2) return Collections.emptySet();
+
+		String output = arguments.get(0).getName();
+
+		return arguments.stream().skip(1)
+				.map(Argument::getVariable)
+				.filter(v -> names(v).stream().noneMatch(referenced::contains))
+				.map(Variable::getName)
+				.filter(n -> !n.equals(output))
+				.collect(Collectors.toSet());
+	}
+
+	@Override
+	public void removeArguments(Collection<String> names) {
+		super.removeArguments(names);
+		if (arguments == null || arguments.isEmpty()) return;
+
+		Argument<?> output = arguments.get(0);
+		arguments = arguments.stream()
+				.filter(arg -> arg == output || !names.contains(arg.getName()))
+				.collect(Collectors.toList());
+	}
+
 	public Consumer<String> code() { return code::append; }
 
 	@Override
@@ -74,4 +138,19 @@ public class ExplicitScope<T> extends Scope<T> {
 		super.write(w);
 		w.println(code.toString());
 	}
+
+	private static boolean isReferenced(String name, Set<String> identifiers) {
+		for (String suffix : SUFFIXES) {
+			if (identifiers.contains(name + suffix)) return true;
+		}
+
+		return false;
+	}
+
+	private static Set<String> identifiers(String code) {
+		Set<String> identifiers = new HashSet<>();
+		Matcher m = IDENTIFIER.matcher(code);
+		while (m.find()) identifiers.add(m.group());
+		return identifiers;
+	}
 }
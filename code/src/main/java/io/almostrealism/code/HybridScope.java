@@ -23,6 +23,7 @@ import io.almostrealism.scope.Variable;
 import java.util.ArrayList;
 import java.util.Collection;
 import java.util.List;
+import java.util.Set;
 import java.util.function.Consumer;
 import java.util.function.Function;
 import java.util.stream.Collectors;
@@ -49,6 +50,24 @@ public class HybridScope<T> extends Scope<T> {
 		explicit.write(w);
 	}
 
+	@Override
+	public Set<String> getReferencedNames() {
+		Set<String> names = super.getReferencedNames();
+		names.addAll(explicit.getReferencedNames());
+		return names;
+	}
+
+	@Override
+	protected Set<String> getUnreferencedArguments() {
+		return explicit.getUnreferencedArguments(getReferencedNames());
+	}
+
+	@Override
+	public void removeArguments(Collection<String> names) {
+		explicit.removeArguments(names);
+		super.removeArguments(names);
+	}
+
 	public Consumer<String> code() { return explicit.code(); }
 
 	public boolean isInlineable() { return explicit.isInlineable(); }
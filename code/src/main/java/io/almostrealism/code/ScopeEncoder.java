@@ -24,7 +24,12 @@ public class ScopeEncoder implements Function<Scope, String>, PrintWriter {
 		this(generator, access, new ArrayList<>());
 	}
 
-	protected ScopeEncoder(Function<PrintWriter, CodePrintWriter> generator,
+	/**
+	 * Create a {@link ScopeEncoder} which will not write any function in the specified
+	 * {@link List}, and adds each function that it does write, so that encoders sharing
+	 * the {@link List} can produce code for the same compilation unit.
+	 */
+	public ScopeEncoder(Function<PrintWriter, CodePrintWriter> generator,
 						   Accessibility access,
 						   List<String> functionsWritten) {
 		this.generator = generator;
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package io.almostrealism.code;
+
+import io.almostrealism.expression.Expression;
+import io.almostrealism.expression.InstanceReference;
+import io.almostrealism.scope.Scope;
+import io.almostrealism.scope.Variable;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * A {@link ScopeOptimizer} simplifies a {@link Scope} after its arguments have been
+ * converted to required {@link Scope}s, and before it is encoded, so that the same
+ * simplification applies to every backend.
+ *
+ * Declarations which repeat the {@link Expression#isPure() pure} expression of an
+ * earlier declaration in the same {@link Scope}, with no assignment between them,
+ * are replaced with a reference to the earlier {@link Variable}. Arguments of {@link ExplicitScope}s and
+ * {@link HybridScope}s which are never referenced are removed, so that they are
+ * not included in the signature of the generated function or passed to it.
+ * Either of these can be disabled, as pruning arguments does not depend on which
+ * expressions are known to be pure.
+ *
+ * Arguments which share a root delegate are already merged by {@link Scope#getArguments()},
+ * so they are not considered here. Loop invariants are not hoisted, because the body of a
+ * {@link HybridScope} loop is explicit code around a call to the function of a required
+ * {@link Scope}, which may alter any of its arguments; this requires the loop body to be
+ * represented by {@link Variable}s first.
+ */
+public class ScopeOptimizer {
+	public static boolean enableVerbose = false;
+
+	private final boolean eliminate;
+	private final boolean prune;
+
+	private int eliminated;
+	private int pruned;
+
+	public ScopeOptimizer() {
+		this(true, true);
+	}
+
+	/**
+	 * Create a {@link ScopeOptimizer}.
+	 *
+	 * @param eliminate  Whether repeated pure expressions should be combined.
+	 * @param prune  Whether unreferenced arguments should be removed.
+	 */
+	public ScopeOptimizer(boolean eliminate, boolean prune) {
+		this.eliminate = eliminate;
+		this.prune = prune;
+	}
+
+	public <T> Scope<T> optimize(Scope<T> scope) {
+		if (eliminate) eliminate(scope, new ArrayList<>());
+		if (prune) pruned += scope.pruneArguments();
+
+		if (enableVerbose && (eliminated > 0 || pruned > 0)) {
+			System.out.println("ScopeOptimizer: " + scope.getName() + " - " + eliminated +
+					" expressions eliminated, " + pruned + " arguments pruned");
+		}
+
+		return scope;
+	}
+
+	/** The number of declarations which were replaced with a reference to an earlier one. */
+	public int getEliminated() { return eliminated; }
+
+	/** The number of arguments that were removed. */
+	public int getPruned() { return pruned; }
+
+	protected void eliminate(Scope<?> scope, List<Scope<?>> visited) {
+		if (visited.stream().anyMatch(s -> s == scope)) return;
+		visited.add(scope);
+
+		List<Variable<?, ?>> variables = scope.getVariables();
+		Map<String, Variable<?, ?>> available = new HashMap<>();
+
+		for (int i = 0; i < variables.size(); i++) {
+			Variable<?, ?> v = variables.get(i);
+			if (v == null) continue;
+
+			String key = key(v);
+
+			if (key == null) {
+				// An assignment may change the value of any of the available expressions
+				if (!v.isDeclaration()) available.clear();
+				continue;
+			}
+
+			Variable<?, ?> existing = available.get(key);
+
+			if (existing == null) {
+				available.put(key, v);
+			} else if (existing.getName().length() < v.getExpression().getExpression().length()) {
+				variables.set(i, alias(v, existing));
+				eliminated++;
+			}
+		}
+
+		for (Scope<?> s : scope.getChildren()) eliminate(s, visited);
+		for (Scope<?> s : scope.getRequiredScopes()) eliminate(s, visited);
+	}
+
+	/**
+	 * Returns the key which identifies the value of the specified declaration,
+	 * or null if it cannot be replaced with another {@link Variable}.
+	 */
+	protected String key(Variable<?, ?> v) {
+		if (v.getClass() != Variable.class) return null;
+		if (!v.isDeclaration() || v.getDelegate() != null) return null;
+
+		Expression<?> e = v.getExpression();
+		if (e == null || e instanceof InstanceReference || e.getArraySize() > 0 || e.getType() == null) return null;
+		if (!e.isPure()) return null;
+
+		String text = e.getExpression();
+		if (text == null || text.isEmpty()) return null;
+
+		return e.getType().getName() + ":" + text;
+	}
+
+	protected Variable<?, ?> alias(Variable<?, ?> v, Variable<?, ?> existing) {
+		Variable<?, ?> alias = new Variable(v.getName(), true,
+				new Expression(v.getExpression().getType(), existing.getName(), existing), v.getProducer());
+		alias.setPhysicalScope(v.getPhysicalScope());
+		alias.setSortHint(v.getSortHint());
+		return alias;
+	}
+}
@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Exponent extends Expression<Double> {
 	public Exponent(Expression<Double> base, Expression<Double> exponent) {
 		super(Double.class, "pow((" + base.getExpression() + "), (" + exponent.getExpression() + "))", base, exponent);
+		setPure(allPure(base, exponent));
 	}
 }
@@ -25,12 +25,24 @@ import java.util.List;
 import java.util.Objects;
 import java.util.Set;
 import java.util.function.Supplier;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+import java.util.stream.Stream;
 
 public class Expression<T> {
+	private static final Pattern TOKEN = Pattern.compile("\\s*(?:(\\+\\+|--)|([A-Za-z_][A-Za-z0-9_]*)|" +
+			"((?:\\d+\\.?\\d*|\\.\\d+)(?:[eE][+-]?\\d+)?[fF]?)|(==|!=|<=|>=|&&|\\|\\||[-+*/%<>!?:(),\\[\\]]))\\s*");
+
+	/** Functions which have no side effects, and which may be called by a pure {@link Expression}. */
+	private static final Set<String> PURE_FUNCTIONS = Set.of(
+			"pow", "sqrt", "exp", "log", "sin", "cos", "tan", "asin", "acos", "atan", "atan2",
+			"fabs", "fmin", "fmax", "fmod", "floor", "ceil", "min", "max", "abs", "get_global_id");
+
 	private Class<T> type;
 	private Supplier<String> expression;
 	private List<Variable<?, ?>> dependencies = new ArrayList<>();
 	private int arraySize = -1;
+	private Boolean pure;
 
 	public Expression(Class<T> type) {
 		setType(type);
@@ -95,6 +107,20 @@ public class Expression<T> {
 	public int getArraySize() { return arraySize; }
 	public void setArraySize(int arraySize) { this.arraySize = arraySize; }
 
+	/**
+	 * Returns true if this {@link Expression} has no side effects, and always has the same
+	 * value while its dependencies are unchanged, so that it only needs to be computed once.
+	 * Unless it has been marked with {@link #setPure(boolean)}, an {@link Expression} is pure
+	 * if its code only reads values and combines them with operators and common math
+	 * functions, because any other function it calls could change something.
+	 */
+	public boolean isPure() {
+		if (pure != null) return pure;
+		return isPure(getExpression());
+	}
+
+	public void setPure(boolean pure) { this.pure = pure; }
+
 	public T getValue() {
 		if (expression != null) {
 			return (T) expression.get();
@@ -121,6 +147,37 @@ public class Expression<T> {
 	@Override
 	public int hashCode() { return getValue().hashCode(); }
 
+	/** Returns true if every one of the specified {@link Expression}s is pure. */
+	protected static boolean allPure(Expression<?>... expressions) {
+		return Stream.of(expressions).allMatch(Expression::isPure);
+	}
+
+	/**
+	 * Returns true if the specified code consists only of names, numbers, array access,
+	 * arithmetic, comparison and conditional operators, casts, and calls to common math
+	 * functions. Assignment, increment and decrement are not permitted.
+	 */
+	protected static boolean isPure(String code) {
+		if (code == null || code.isEmpty()) return false;
+
+		Matcher m = TOKEN.matcher(code);
+		int pos = 0;
+
+		while (pos < code.length()) {
+			m.region(pos, code.length());
+			if (!m.lookingAt() || m.group(1) != null) return false;
+
+			pos = m.end();
+
+			if (m.group(2) != null && pos < code.length() && code.charAt(pos) == '('
+					&& !PURE_FUNCTIONS.contains(m.group(2))) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	private static Variable[] dependencies(Expression expressions[]) {
 		Set<Variable<?, ?>> dependencies = new HashSet<>();
 		for (Expression e : expressions) dependencies.addAll(e.getDependencies());
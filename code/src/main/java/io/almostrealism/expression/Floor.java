@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Floor extends Expression<Double> {
 	public Floor(Expression<Double> input) {
 		super(Double.class, "floor(" + input.getExpression() + ")", input);
+		setPure(allPure(input));
 	}
 }
@@ -43,6 +43,7 @@ public class InstanceReference<T> extends Expression<T> {
 
 	public InstanceReference(Class<T> type, String varName, Variable... dependencies) {
 		super(type, varName, dependencies);
+		setPure(true);
 	}
 
 	public Variable<T, ?> getReferent() { return var; }
@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Max extends Expression<Double> {
 	public Max(Expression<Double> a, Expression<Double> b) {
 		super(Double.class, "max(" + a.getExpression() + ", " + b.getExpression() + ")", a, b);
+		setPure(allPure(a, b));
 	}
 }
@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Min extends Expression<Double> {
 	public Min(Expression<Double> a, Expression<Double> b) {
 		super(Double.class, "min(" + a.getExpression() + ", " + b.getExpression() + ")", a, b);
+		setPure(allPure(a, b));
 	}
 }
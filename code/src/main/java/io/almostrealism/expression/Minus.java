@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Minus extends UnaryExpression<Double> {
 	public Minus(Expression<Double> value) {
 		super(Double.class, "-", value);
+		setPure(value.isPure());
 	}
 }
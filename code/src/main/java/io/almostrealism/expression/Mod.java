@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Mod extends Expression<Double> {
 	public Mod(Expression<Double> a, Expression<Double> b) {
 		super(Double.class, "fmod(" + a.getExpression() + ", " + b.getExpression() + ")", a, b);
+		setPure(allPure(a, b));
 	}
 }
@@ -26,6 +26,7 @@ public class NAryExpression<T> extends Expression<T> {
 
 	public NAryExpression(Class<T> type, String operator, Expression<?>... values) {
 		super(type, concat(operator, Stream.of(values).map(Expression::getExpression).map(s -> "(" + s + ")")), values);
+		setPure(allPure(values));
 	}
 
 	private static String concat(String separator, Stream<String> values) {
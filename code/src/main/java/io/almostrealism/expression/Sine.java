@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class Sine extends Expression<Double> {
 	public Sine(Expression<Double> input) {
 		super(Double.class, "sin(" + input.getExpression() + ")", input);
+		setPure(allPure(input));
 	}
 }
@@ -19,5 +19,6 @@ package io.almostrealism.expression;
 public class UnaryExpression<T> extends Expression<T> {
 	public UnaryExpression(Class<T> type, String operator, Expression<?> value) {
 		super(type, operator + "(" + value.getExpression() + ")", value);
+		setPure(value.isPure() && isPure(getExpression()));
 	}
 }
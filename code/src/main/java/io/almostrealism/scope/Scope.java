@@ -39,9 +39,11 @@ import java.util.ArrayList;
 import java.util.Collection;
 import java.util.Collections;
 import java.util.Comparator;
+import java.util.HashSet;
 import java.util.List;
 import java.util.Objects;
 import java.util.Optional;
+import java.util.Set;
 import java.util.function.Function;
 import java.util.function.Supplier;
 import java.util.stream.Collectors;
@@ -184,6 +186,158 @@ public class Scope<T> extends ArrayList<Scope<T>> implements ParameterizedGraph<
 				.collect(Collectors.toList());
 	}
 
+	/**
+	 * Returns the subset of {@link #getArgumentVariables()} which may be assigned
+	 * to by this {@link Scope}, its children, or its required {@link Scope}s. When
+	 * this cannot be determined, because the {@link Scope} includes code that is
+	 * not described by its {@link Variable}s, all argument variables are returned.
+	 */
+	public <A> List<ArrayVariable<? extends A>> getAlteredArgumentVariables() {
+		List<ArrayVariable<? extends A>> all = getArgumentVariables();
+
+		List<String> altered = new ArrayList<>();
+		if (!alteredArguments(altered)) return all;
+
+		return all.stream()
+				.filter(v -> altered.contains(v.getName()))
+				.collect(Collectors.toList());
+	}
+
+	/**
+	 * Adds the names of the root array variables that may be assigned to by this
+	 * {@link Scope} to the specified list, returning false if that is not possible.
+	 */
+	protected boolean alteredArguments(List<String> altered) {
+		// Subclasses may render code that is not described by the variables
+		if (getClass() != Scope.class) return false;
+
+		for (Variable<?, ?> v : getVariables()) {
+			if (v == null || v.isDeclaration()) continue;
+			if (!alteredVariable(v, altered)) return false;
+		}
+
+		List<String> requiredNames = getRequiredScopes().stream()
+				.map(Scope::getName).filter(Objects::nonNull).collect(Collectors.toList());
+
+		for (Method<?> m : getMethods()) {
+			// Calls to required scopes are covered by inspecting those scopes
+			if (requiredNames.contains(m.getName())) continue;
+
+			for (Expression<?> e : m.getArguments()) {
+				if (e instanceof InstanceReference && !alteredVariable(((InstanceReference<?>) e).getReferent(), altered)) {
+					return false;
+				}
+			}
+		}
+
+		for (Metric m : getMetrics()) {
+			for (InstanceReference<?> r : m.getArguments()) {
+				if (!alteredVariable(r.getReferent(), altered)) return false;
+			}
+		}
+
+		for (Scope<T> s : getChildren()) {
+			if (!s.alteredArguments(altered)) return false;
+		}
+
+		for (Scope<?> s : getRequiredScopes()) {
+			if (!s.alteredArguments(altered)) return false;
+		}
+
+		return true;
+	}
+
+	private static boolean alteredVariable(Variable<?, ?> v, List<String> altered) {
+		Variable<?, ?> root = v.getRootDelegate();
+
+		if (root instanceof ArrayVariable) {
+			if (!altered.contains(root.getName())) altered.add(root.getName());
+			return true;
+		}
+
+		return v.isDeclaration() && v.getDelegate() == null;
+	}
+
+	/**
+	 * Returns the names of the {@link Variable}s, and of their delegates, which are
+	 * referenced by the {@link Variable}s, {@link Method}s and {@link Metric}s of
+	 * this {@link Scope} and its children.
+	 */
+	public Set<String> getReferencedNames() {
+		Set<String> names = new HashSet<>();
+		extractArgumentDependencies(variables).forEach(arg -> names.addAll(names(arg.getVariable())));
+
+		for (Method<?> m : methods) {
+			for (Expression<?> e : m.getArguments()) {
+				if (e instanceof InstanceReference) names.addAll(names(((InstanceReference<?>) e).getReferent()));
+			}
+		}
+
+		for (Metric m : metrics) {
+			m.getArguments().forEach(r -> names.addAll(names(r.getReferent())));
+		}
+
+		for (Scope<T> s : getChildren()) {
+			names.addAll(s.getReferencedNames());
+		}
+
+		return names;
+	}
+
+	/**
+	 * Remove the arguments of this {@link Scope} and its children which none of them
+	 * reference, returning the number of arguments that were removed. Required
+	 * {@link Scope}s are not changed, because the calls to them have already been
+	 * generated with all of their arguments.
+	 */
+	public int pruneArguments() {
+		int count = 0;
+
+		for (Scope<T> s : getChildren()) {
+			count += s.pruneArguments();
+		}
+
+		Set<String> unused = getUnreferencedArguments();
+		if (!unused.isEmpty()) removeArguments(unused);
+		return count + unused.size();
+	}
+
+	/**
+	 * Returns the names of the arguments of this {@link Scope} which are not referenced
+	 * by it. The arguments of a {@link Scope} are derived from what it references,
+	 * so there are none, but subclasses which render other code may have some.
+	 */
+	protected Set<String> getUnreferencedArguments() {
+		return Collections.emptySet();
+	}
+
+	/**
+	 * Remove the arguments with the specified names from the arguments that were
+	 * determined by {@link #convertArgumentsToRequiredScopes()}.
+	 */
+	public void removeArguments(Collection<String> names) {
+		if (arguments == null) return;
+
+		arguments = arguments.stream()
+				.filter(arg -> !names.contains(arg.getName()))
+				.collect(Collectors.toList());
+	}
+
+	/**
+	 * Returns the name of the specified {@link Variable}, followed by the names of
+	 * each of its delegates.
+	 */
+	protected static List<String> names(Variable<?, ?> v) {
+		List<String> names = new ArrayList<>();
+
+		while (v != null) {
+			if (v.getName() != null) names.add(v.getName());
+			v = v.getDelegate();
+		}
+
+		return names;
+	}
+
 	protected List<Argument<?>> arguments() { return arguments(Function.identity()); }
 
 	protected <A> List<A> arguments(Function<Argument<?>, A> mapper) {
@@ -0,0 +1,469 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.graph;
+
+import org.almostrealism.hardware.MemoryBank;
+
+import java.util.Arrays;
+import java.util.List;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.RecursiveAction;
+
+/**
+ * A static kd-tree for squared Euclidean nearest neighbor queries. The points are
+ * stored in one contiguous array, with all of the coordinates for each dimension
+ * together, in the order of the leaves of the tree. The nodes are not objects:
+ * node i has the children 2i + 1 and 2i + 2, every split is at the median of the
+ * points of the node, and so the range of points covered by a node is implied by
+ * its position, leaving only the dimension and value of each split to be stored.
+ *
+ * Queries are answered into arrays provided by the caller, and batches of queries
+ * are divided into blocks which are answered in parallel, so that nothing needs
+ * to be allocated for each query. The results for each query are the indices of
+ * the nearest points, in the order they were provided to the constructor, and
+ * their squared distances, nearest first.
+ *
+ * @see  KdTree.SqrEuclid#flatten()
+ */
+public class FlatKdTree<T> {
+	/** The maximum number of points in a leaf. */
+	public static final int LEAF_SIZE = 16;
+
+	/** The number of queries answered by each parallel task. */
+	public static final int BLOCK_SIZE = 256;
+
+	private final int dimensions;
+	private final int count;
+	private final int depth;
+
+	private final double coordinates[];
+	private final int index[];
+	private final List<T> values;
+
+	private final int splitDimension[];
+	private final double splitValue[];
+
+	/**
+	 * Build a tree for the specified locations, each of which has the same number
+	 * of dimensions, and the values associated with them, which may be null.
+	 */
+	public FlatKdTree(double locations[][], List<T> values) {
+		this(locations.length == 0 ? 0 : locations[0].length, flatten(locations), values);
+	}
+
+	/**
+	 * Build a tree for the specified locations, which are stored one after the other
+	 * with the specified number of dimensions each, and the values associated with
+	 * them, which may be null.
+	 */
+	public FlatKdTree(int dimensions, double locations[], List<T> values) {
+		if (dimensions <= 0 && locations.length > 0) {
+			throw new IllegalArgumentException("At least one dimension is required");
+		}
+
+		if (dimensions > 0 && locations.length % dimensions != 0) {
+			throw new IllegalArgumentException("Locations must have " + dimensions + " values each");
+		}
+
+		this.dimensions = dimensions;
+		this.count = dimensions == 0 ? 0 : locations.length / dimensions;
+
+		if (values != null && values.size() != count) {
+			throw new IllegalArgumentException(values.size() + " values provided for " + count + " locations");
+		}
+
+		int d = 0;
+		while ((count >> d) > LEAF_SIZE) d++;
+		this.depth = d;
+
+		this.values = values;
+		this.splitDimension = new int[(1 << depth) - 1];
+		this.splitValue = new double[(1 << depth) - 1];
+
+		this.index = new int[count];
+		for (int i = 0; i < count; i++) index[i] = i;
+		if (depth > 0) build(locations, 0, 0, count, 0);
+
+		this.coordinates = new double[count * dimensions];
+
+		for (int i = 0; i < count; i++) {
+			for (int j = 0; j < dimensions; j++) {
+				coordinates[j * count + i] = locations[index[i] * dimensions + j];
+			}
+		}
+	}
+
+	public int getDimensions() { return dimensions; }
+
+	/** The number of points in the tree. */
+	public int size() { return count; }
+
+	/** Returns the value associated with the point at the specified index. */
+	public T getValue(int index) {
+		return values == null || index < 0 ? null : values.get(index);
+	}
+
+	/**
+	 * Find the nearest k points to the specified location, storing their indices
+	 * and squared distances in the first k positions of the specified arrays.
+	 * When there are fewer than k points, the remaining indices are -1 and the
+	 * remaining distances are infinite.
+	 */
+	public void nearestNeighbors(double location[], int k, int indices[], double distances[]) {
+		nearestNeighbors(location, 1, k, indices, distances);
+	}
+
+	/**
+	 * Find the nearest k points to each of the specified number of query locations,
+	 * which are stored one after the other. The results for query q are stored in
+	 * positions q * k through q * k + k - 1 of the specified arrays.
+	 *
+	 * @see  #nearestNeighbors(double[], int, int[], double[])
+	 */
+	public void nearestNeighbors(double queries[], int queryCount, int k, int indices[], double distances[]) {
+		nearestNeighbors(queries, dimensions, queryCount, k, indices, distances);
+	}
+
+	/**
+	 * Find the nearest k points to the location of each of the members of the specified
+	 * {@link MemoryBank}, whose first values are the coordinates. The bank is read in a
+	 * single transfer, rather than one member at a time.
+	 *
+	 * @see  #nearestNeighbors(double[], int, int, int[], double[])
+	 */
+	public void nearestNeighbors(MemoryBank<?> queries, int k, int indices[], double distances[]) {
+		int queryCount = queries.getCount();
+		if (queryCount == 0) return;
+
+		int stride = queries.getMemLength() / queryCount;
+		if (stride < dimensions) {
+			throw new IllegalArgumentException("Members of the bank have fewer than " + dimensions + " values");
+		}
+
+		nearestNeighbors(queries.toArray(0, queryCount * stride), stride, queryCount, k, indices, distances);
+	}
+
+	protected void nearestNeighbors(double queries[], int stride, int queryCount, int k, int indices[], double distances[]) {
+		if (k <= 0) throw new IllegalArgumentException("At least one neighbor must be requested");
+
+		if (queries.length < queryCount * stride) {
+			throw new IllegalArgumentException("Locations for " + queryCount + " queries are required");
+		}
+
+		if (indices.length < queryCount * k || distances.length < queryCount * k) {
+			throw new IllegalArgumentException("Results for " + queryCount + " queries require " + queryCount * k + " positions");
+		}
+
+		Query query = new Query(queries, stride, k, indices, distances, 0, queryCount);
+
+		if (queryCount <= BLOCK_SIZE) {
+			query.compute();
+		} else {
+			ForkJoinPool.commonPool().invoke(query);
+		}
+	}
+
+	/**
+	 * Answer the query whose location starts at the specified position, using
+	 * the specified {@link Scratch} space.
+	 */
+	private void query(double queries[], int offset, int k, int indices[], double distances[], int out, Scratch s) {
+		s.size = 0;
+		s.stack = 0;
+		if (count > 0) s.push(0, 0, count, 0, 0.0);
+
+		while (s.stack > 0) {
+			s.stack--;
+			int node = s.node[s.stack];
+			int lo = s.lo[s.stack];
+			int hi = s.hi[s.stack];
+			int level = s.level[s.stack];
+			double bound = s.bound[s.stack];
+			if (bound > s.worst()) continue;
+
+			// Descend to the leaf on the side of each split that includes
+			// the query, leaving the other side to be searched later
+			while (level < depth) {
+				double diff = queries[offset + splitDimension[node]] - splitValue[node];
+				double far = Math.max(bound, diff * diff);
+				int mid = (lo + hi) >>> 1;
+
+				if (diff < 0) {
+					if (far <= s.worst()) s.push(2 * node + 2, mid, hi, level + 1, far);
+					node = 2 * node + 1;
+					hi = mid;
+				} else {
+					if (far <= s.worst()) s.push(2 * node + 1, lo, mid, level + 1, far);
+					node = 2 * node + 2;
+					lo = mid;
+				}
+
+				level++;
+			}
+
+			scan(queries, offset, lo, hi, s);
+		}
+
+		// Remove the farthest point repeatedly to sort the results
+		int found = s.size;
+		for (int i = found; i < k; i++) {
+			indices[out + i] = -1;
+			distances[out + i] = Double.POSITIVE_INFINITY;
+		}
+
+		for (int i = found - 1; i >= 0; i--) {
+			indices[out + i] = index[s.heapIndex[0]];
+			distances[out + i] = s.heapDistance[0];
+			s.removeLargest();
+		}
+	}
+
+	/**
+	 * Compute the distance to every point of a leaf, one dimension at a time,
+	 * and then keep those that are nearer than the farthest result.
+	 */
+	private void scan(double queries[], int offset, int lo, int hi, Scratch s) {
+		int len = hi - lo;
+		double dist[] = s.distance;
+		Arrays.fill(dist, 0, len, 0.0);
+
+		for (int j = 0; j < dimensions; j++) {
+			double q = queries[offset + j];
+			int base = j * count + lo;
+
+			for (int i = 0; i < len; i++) {
+				double diff = coordinates[base + i] - q;
+				dist[i] += diff * diff;
+			}
+		}
+
+		for (int i = 0; i < len; i++) {
+			s.add(dist[i], lo + i);
+		}
+	}
+
+	private void build(double locations[], int node, int lo, int hi, int level) {
+		int dim = widest(locations, lo, hi);
+		int mid = (lo + hi) >>> 1;
+		select(locations, dim, lo, hi - 1, mid);
+
+		splitDimension[node] = dim;
+		splitValue[node] = locations[index[mid] * dimensions + dim];
+
+		if (level + 1 < depth) {
+			build(locations, 2 * node + 1, lo, mid, level + 1);
+			build(locations, 2 * node + 2, mid, hi, level + 1);
+		}
+	}
+
+	private int widest(double locations[], int lo, int hi) {
+		int widest = 0;
+		double width = -1;
+
+		for (int j = 0; j < dimensions; j++) {
+			double min = Double.POSITIVE_INFINITY;
+			double max = Double.NEGATIVE_INFINITY;
+
+			for (int i = lo; i < hi; i++) {
+				double v = locations[index[i] * dimensions + j];
+				if (v < min) min = v;
+				if (v > max) max = v;
+			}
+
+			if (max - min > width) {
+				widest = j;
+				width = max - min;
+			}
+		}
+
+		return widest;
+	}
+
+	/**
+	 * Reorder the indices from lo to hi, inclusive, so that the point at position n
+	 * is where it would be if they were sorted along the specified dimension, with
+	 * no point before it greater and no point after it less.
+	 */
+	private void select(double locations[], int dim, int lo, int hi, int n) {
+		while (hi > lo) {
+			double pivot = locations[index[(lo + hi) >>> 1] * dimensions + dim];
+			int i = lo, j = hi;
+
+			while (i <= j) {
+				while (locations[index[i] * dimensions + dim] < pivot) i++;
+				while (locations[index[j] * dimensions + dim] > pivot) j--;
+
+				if (i <= j) {
+					int t = index[i];
+					index[i] = index[j];
+					index[j] = t;
+					i++;
+					j--;
+				}
+			}
+
+			if (n <= j) {
+				hi = j;
+			} else if (n >= i) {
+				lo = i;
+			} else {
+				return;
+			}
+		}
+	}
+
+	private static double[] flatten(double locations[][]) {
+		if (locations.length == 0) return new double[0];
+
+		int dimensions = locations[0].length;
+		double result[] = new double[locations.length * dimensions];
+
+		for (int i = 0; i < locations.length; i++) {
+			if (locations[i].length != dimensions) {
+				throw new IllegalArgumentException("All locations must have " + dimensions + " dimensions");
+			}
+
+			System.arraycopy(locations[i], 0, result, i * dimensions, dimensions);
+		}
+
+		return result;
+	}
+
+	/**
+	 * The state of a query, which is reused for every query of a block.
+	 */
+	private class Scratch {
+		private final int k;
+		private final double heapDistance[];
+		private final int heapIndex[];
+		private int size;
+
+		private final int node[], lo[], hi[], level[];
+		private final double bound[];
+		private int stack;
+
+		private final double distance[];
+
+		Scratch(int k) {
+			this.k = k;
+			this.heapDistance = new double[k];
+			this.heapIndex = new int[k];
+
+			// At most one node is deferred for each level of the current path
+			this.node = new int[depth + 2];
+			this.lo = new int[depth + 2];
+			this.hi = new int[depth + 2];
+			this.level = new int[depth + 2];
+			this.bound = new double[depth + 2];
+
+			this.distance = new double[(count >> depth) + 1];
+		}
+
+		void push(int n, int l, int h, int lev, double b) {
+			node[stack] = n;
+			lo[stack] = l;
+			hi[stack] = h;
+			level[stack] = lev;
+			bound[stack] = b;
+			stack++;
+		}
+
+		double worst() {
+			return size < k ? Double.POSITIVE_INFINITY : heapDistance[0];
+		}
+
+		void add(double dist, int i) {
+			if (size < k) {
+				int c = size++;
+				heapDistance[c] = dist;
+				heapIndex[c] = i;
+
+				for (int p = (c - 1) / 2; c != 0 && heapDistance[c] > heapDistance[p]; c = p, p = (c - 1) / 2) {
+					swap(c, p);
+				}
+			} else if (dist < heapDistance[0]) {
+				heapDistance[0] = dist;
+				heapIndex[0] = i;
+				down();
+			}
+		}
+
+		void removeLargest() {
+			size--;
+			heapDistance[0] = heapDistance[size];
+			heapIndex[0] = heapIndex[size];
+			down();
+		}
+
+		private void down() {
+			for (int p = 0, c = 1; c < size; p = c, c = 2 * p + 1) {
+				if (c + 1 < size && heapDistance[c] < heapDistance[c + 1]) c++;
+				if (heapDistance[p] >= heapDistance[c]) return;
+				swap(p, c);
+			}
+		}
+
+		private void swap(int a, int b) {
+			double d = heapDistance[a];
+			heapDistance[a] = heapDistance[b];
+			heapDistance[b] = d;
+
+			int i = heapIndex[a];
+			heapIndex[a] = heapIndex[b];
+			heapIndex[b] = i;
+		}
+	}
+
+	/**
+	 * A block of queries, which is divided in half until it is no larger than
+	 * {@link #BLOCK_SIZE}.
+	 */
+	private class Query extends RecursiveAction {
+		private final double queries[];
+		private final int stride, k;
+		private final int indices[];
+		private final double distances[];
+		private final int start, end;
+
+		Query(double queries[], int stride, int k, int indices[], double distances[], int start, int end) {
+			this.queries = queries;
+			this.stride = stride;
+			this.k = k;
+			this.indices = indices;
+			this.distances = distances;
+			this.start = start;
+			this.end = end;
+		}
+
+		@Override
+		protected void compute() {
+			if (end - start > BLOCK_SIZE) {
+				int mid = (start + end) >>> 1;
+				invokeAll(new Query(queries, stride, k, indices, distances, start, mid),
+						new Query(queries, stride, k, indices, distances, mid, end));
+				return;
+			}
+
+			Scratch s = new Scratch(k);
+
+			for (int q = start; q < end; q++) {
+				query(queries, q * stride, k, indices, distances, q * k, s);
+			}
+		}
+	}
+}
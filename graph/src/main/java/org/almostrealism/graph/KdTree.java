@@ -282,6 +282,23 @@ public abstract class KdTree<T> {
         // If we got here... we couldn't find the value to remove. Weird...
     }
 
+    /**
+     * Add the locations and values of every leaf under this node to the lists
+     */
+    @SuppressWarnings("unchecked")
+    private void collect(List<double[]> locations, List<T> values) {
+        if (this.locations != null) {
+            for (int i = 0; i < this.locationCount; i++) {
+                locations.add(this.locations[i]);
+                values.add((T) this.data[i]);
+            }
+        }
+        else {
+            left.collect(locations, values);
+            right.collect(locations, values);
+        }
+    }
+
     /**
      * Enumeration representing the status of a node during the running
      */
@@ -492,6 +509,17 @@ public abstract class KdTree<T> {
             super(dimensions, sizeLimit);
         }
 
+        /**
+         * Create a {@link FlatKdTree} with the points currently in this tree, to
+         * answer batches of queries without allocating for each of them
+         */
+        public FlatKdTree<T> flatten() {
+            List<double[]> locations = new ArrayList<double[]>();
+            List<T> values = new ArrayList<T>();
+            ((KdTree<T>) this).collect(locations, values);
+            return new FlatKdTree<T>(locations.toArray(new double[0][]), values);
+        }
+
         protected double pointDist(double[] p1, double[] p2) {
             double d = 0;
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+/**
+ * The native side of {@link NativeArena}. A single function is used for every
+ * operation on an arena, so that all of them share the same definition of the
+ * arena structure.
+ *
+ * An arena is one region of address space, reserved once and aligned to 2MB so
+ * that it can be backed by huge pages. The region is divided into 64KB chunks,
+ * and each chunk is assigned to a size class (64 bytes to 64KB, in powers of two)
+ * when it is first needed. Blocks are taken from the free list for their class,
+ * or from the most recent chunk for the class, which means every block is 64 byte
+ * aligned and no per block header is required. Allocations which are larger than
+ * a chunk, or which do not fit in the region, use posix_memalign.
+ */
+public class Arena extends BaseNative {
+	public static final int CREATE = 0;
+	public static final int ALLOCATE = 1;
+	public static final int FREE = 2;
+	public static final int RESET = 3;
+	public static final int DESTROY = 4;
+	public static final int BASE = 5;
+	public static final int SIZE = 6;
+
+	public static final int FLAG_HUGE_PAGES = 1;
+
+	private static final String HEAD = "#include <stdint.h>\n" +
+			"#include <sys/mman.h>\n" +
+			"#define AR_ARENA_ALIGN " + NativeArena.ALIGNMENT + "\n" +
+			"#define AR_ARENA_CHUNK (64 * 1024)\n" +
+			"#define AR_ARENA_CLASSES 11\n" +
+			"#define AR_ARENA_REGION_ALIGN (2 * 1024 * 1024)\n" +
+			"#ifndef MAP_ANONYMOUS\n" +
+			"#define MAP_ANONYMOUS MAP_ANON\n" +
+			"#endif\n" +
+			"#ifndef MAP_NORESERVE\n" +
+			"#define MAP_NORESERVE 0\n" +
+			"#endif\n" +
+			"typedef struct {\n" +
+			"\tchar *reserved;\n" +
+			"\tsize_t reservedSize;\n" +
+			"\tchar *base;\n" +
+			"\tsize_t size;\n" +
+			"\tsize_t chunks;\n" +
+			"\tsize_t next;\n" +
+			"\tuint8_t *chunkClass;\n" +
+			"\tvoid *free[AR_ARENA_CLASSES];\n" +
+			"\tchar *bump[AR_ARENA_CLASSES];\n" +
+			"\tchar *bumpEnd[AR_ARENA_CLASSES];\n" +
+			"\tchar lock;\n" +
+			"} ar_arena;\n" +
+			"static void ar_arena_lock(ar_arena *a) {\n" +
+			"\twhile (__atomic_test_and_set(&a->lock, __ATOMIC_ACQUIRE));\n" +
+			"}\n" +
+			"static void ar_arena_unlock(ar_arena *a) {\n" +
+			"\t__atomic_clear(&a->lock, __ATOMIC_RELEASE);\n" +
+			"}\n" +
+			"static int ar_arena_class(size_t len) {\n" +
+			"\tint c = 0;\n" +
+			"\tsize_t s = AR_ARENA_ALIGN;\n" +
+			"\twhile (s < len) { s <<= 1; c++; }\n" +
+			"\treturn c;\n" +
+			"}\n" +
+			"static void ar_arena_clear(ar_arena *a) {\n" +
+			"\ta->next = 0;\n" +
+			"\tmemset(a->chunkClass, 0xFF, a->chunks);\n" +
+			"\tfor (int i = 0; i < AR_ARENA_CLASSES; i++) {\n" +
+			"\t\ta->free[i] = NULL;\n" +
+			"\t\ta->bump[i] = NULL;\n" +
+			"\t\ta->bumpEnd[i] = NULL;\n" +
+			"\t}\n" +
+			"}\n" +
+			"static ar_arena *ar_arena_create(size_t size, int flags) {\n" +
+			"\tar_arena *a = (ar_arena *) calloc(1, sizeof(ar_arena));\n" +
+			"\tif (a == NULL) return NULL;\n" +
+			"\tsize = (size + AR_ARENA_CHUNK - 1) / AR_ARENA_CHUNK * AR_ARENA_CHUNK;\n" +
+			"\ta->reservedSize = size + AR_ARENA_REGION_ALIGN;\n" +
+			"\tvoid *r = mmap(NULL, a->reservedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);\n" +
+			"\tif (r == MAP_FAILED) { free(a); return NULL; }\n" +
+			"\ta->reserved = (char *) r;\n" +
+			"\ta->base = (char *) (((uintptr_t) r + AR_ARENA_REGION_ALIGN - 1) & ~((uintptr_t) AR_ARENA_REGION_ALIGN - 1));\n" +
+			"\ta->size = size;\n" +
+			"\ta->chunks = size / AR_ARENA_CHUNK;\n" +
+			"\ta->chunkClass = (uint8_t *) malloc(a->chunks > 0 ? a->chunks : 1);\n" +
+			"\tif (a->chunkClass == NULL) { munmap(r, a->reservedSize); free(a); return NULL; }\n" +
+			"#ifdef MADV_HUGEPAGE\n" +
+			"\tif (flags & " + FLAG_HUGE_PAGES + ") madvise(a->base, a->size, MADV_HUGEPAGE);\n" +
+			"#endif\n" +
+			"\tar_arena_clear(a);\n" +
+			"\treturn a;\n" +
+			"}\n" +
+			"static void *ar_arena_allocate(ar_arena *a, size_t len) {\n" +
+			"\tvoid *p = NULL;\n" +
+			"\tif (len == 0) len = 1;\n" +
+			"\tif (len <= AR_ARENA_CHUNK) {\n" +
+			"\t\tint c = ar_arena_class(len);\n" +
+			"\t\tsize_t s = ((size_t) AR_ARENA_ALIGN) << c;\n" +
+			"\t\tar_arena_lock(a);\n" +
+			"\t\tif (a->free[c] != NULL) {\n" +
+			"\t\t\tp = a->free[c];\n" +
+			"\t\t\ta->free[c] = *((void **) p);\n" +
+			"\t\t} else {\n" +
+			"\t\t\tif (a->bump[c] == a->bumpEnd[c] && a->next < a->chunks) {\n" +
+			"\t\t\t\ta->chunkClass[a->next] = (uint8_t) c;\n" +
+			"\t\t\t\ta->bump[c] = a->base + a->next * AR_ARENA_CHUNK;\n" +
+			"\t\t\t\ta->bumpEnd[c] = a->bump[c] + AR_ARENA_CHUNK;\n" +
+			"\t\t\t\ta->next++;\n" +
+			"\t\t\t}\n" +
+			"\t\t\tif (a->bump[c] != a->bumpEnd[c]) {\n" +
+			"\t\t\t\tp = a->bump[c];\n" +
+			"\t\t\t\ta->bump[c] += s;\n" +
+			"\t\t\t}\n" +
+			"\t\t}\n" +
+			"\t\tar_arena_unlock(a);\n" +
+			"\t}\n" +
+			"\tif (p == NULL && posix_memalign(&p, AR_ARENA_ALIGN, len) != 0) p = NULL;\n" +
+			"\treturn p;\n" +
+			"}\n" +
+			"static void ar_arena_free(ar_arena *a, char *p) {\n" +
+			"\tif (p < a->base || p >= a->base + a->size) {\n" +
+			"\t\tfree(p);\n" +
+			"\t\treturn;\n" +
+			"\t}\n" +
+			"\tar_arena_lock(a);\n" +
+			"\tint c = a->chunkClass[(p - a->base) / AR_ARENA_CHUNK];\n" +
+			"\t*((void **) p) = a->free[c];\n" +
+			"\ta->free[c] = p;\n" +
+			"\tar_arena_unlock(a);\n" +
+			"}\n";
+
+	public Arena() {
+		setHead(HEAD);
+		initNative();
+	}
+
+	@Override
+	public String getFunctionDefinition() {
+		return "JNIEXPORT jlong JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jint op, jlong arena, jlong arg) {\n" +
+				(enableVerbose ? "\tprintf(\"arena(%i, %lu, %li)\\n\", op, arena, arg);\n" : "") +
+				"\tar_arena *a = (ar_arena *) arena;\n" +
+				"\tswitch (op) {\n" +
+				"\t\tcase " + CREATE + ": return (jlong) ar_arena_create((size_t) arg, (int) arena);\n" +
+				"\t\tcase " + ALLOCATE + ": return (jlong) ar_arena_allocate(a, (size_t) arg);\n" +
+				"\t\tcase " + FREE + ": ar_arena_free(a, (char *) arg); return 0;\n" +
+				"\t\tcase " + RESET + ": ar_arena_lock(a); ar_arena_clear(a); ar_arena_unlock(a); return 0;\n" +
+				"\t\tcase " + DESTROY + ": munmap(a->reserved, a->reservedSize); free(a->chunkClass); free(a); return 0;\n" +
+				"\t\tcase " + BASE + ": return (jlong) a->base;\n" +
+				"\t\tcase " + SIZE + ": return (jlong) a->size;\n" +
+				"\t\tdefault: return 0;\n" +
+				"\t}\n" +
+				"}\n";
+	}
+
+	public native long apply(int op, long arena, long arg);
+}
@@ -19,7 +19,7 @@ package org.almostrealism.c;
 import io.almostrealism.code.Accessibility;
 import io.almostrealism.scope.ArrayVariable;
 import io.almostrealism.scope.Method;
-import io.almostrealism.scope.Variable;
+import org.almostrealism.hardware.Hardware;
 import org.almostrealism.io.PrintWriter;
 
 import java.util.List;
@@ -35,6 +35,7 @@ public class CJNIPrintWriter extends CPrintWriter {
 		super(p, topLevelMethodName, verbose);
 		setExternalScopePrefix("JNIEXPORT void JNICALL");
 		setEnableArrayVariables(true);
+		setArgumentAlignment(NativeMemoryProvider.getAlignment(Hardware.getLocalHardware().getMemoryProvider()));
 	}
 
 	@Override
@@ -63,18 +64,22 @@ public class CJNIPrintWriter extends CPrintWriter {
 	}
 
 	protected void renderArgumentReads(List<ArrayVariable<?>> arguments) {
-		println(new Variable<>("*argArr", long[].class, "(*env)->GetLongArrayElements(env, arg, 0)"));
-		println(new Variable<>("*offsetArr", int[].class, "(*env)->GetIntArrayElements(env, offset, 0)"));
-		println(new Variable<>("*sizeArr", int[].class, "(*env)->GetIntArrayElements(env, size, 0)"));
-
+		renderArgumentArrays();
 		super.renderArgumentReads(arguments);
 	}
 
-	protected void renderArgumentWrites(List<ArrayVariable<?>> arguments) {
-		super.renderArgumentWrites(arguments);
-
-		println("free(argArr);");
-		println("free(offsetArr);");
-		println("free(sizeArr);");
+	/**
+	 * Copy the argument, offset and size arrays into arrays on the stack. They
+	 * only have one element per argument, so this is much cheaper than pinning
+	 * or copying them with Get*ArrayElements, and nothing needs to be released.
+	 */
+	protected void renderArgumentArrays() {
+		println("jint argCount = count > 0 ? count : 1;");
+		println("jlong argArr[argCount];");
+		println("jint offsetArr[argCount];");
+		println("jint sizeArr[argCount];");
+		println("(*env)->GetLongArrayRegion(env, arg, 0, count, argArr);");
+		println("(*env)->GetIntArrayRegion(env, offset, 0, count, offsetArr);");
+		println("(*env)->GetIntArrayRegion(env, size, 0, count, sizeArr);");
 	}
 }
@@ -29,6 +29,7 @@ import io.almostrealism.expression.InstanceReference;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.io.PrintStreamPrintWriter;
 import org.almostrealism.io.PrintWriter;
+import org.almostrealism.io.SystemUtils;
 import org.jocl.cl_event;
 
 import java.io.OutputStream;
@@ -40,12 +41,32 @@ import java.util.function.Consumer;
 import java.util.stream.IntStream;
 
 public class CPrintWriter extends CodePrintWriterAdapter {
+	/**
+	 * If enabled, the pointers for the arguments are declared restrict, which allows
+	 * the compiler to vectorize more loops. This is only correct when no two arguments
+	 * to an operation share the same memory, which is not true in general for
+	 * arguments that are part of the same bank.
+	 */
+	public static boolean enableRestrict = SystemUtils.isEnabled("AR_HARDWARE_C_RESTRICT").orElse(false);
+
+	/**
+	 * If enabled, external functions are compiled for several instruction sets (when
+	 * the compiler supports it), and the best one for the CPU is selected when the
+	 * library is loaded.
+	 */
+	public static boolean enableTargetClones = SystemUtils.isEnabled("AR_HARDWARE_C_TARGET_CLONES").orElse(false);
+
+	public static final String TARGET_CLONES = "#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)\n" +
+			"__attribute__((target_clones(\"avx512f\", \"avx2\", \"default\")))\n" +
+			"#endif";
+
 	private final String topLevelMethodName;
 	private final Stack<Accessibility> accessStack;
 	private final Stack<List<ArrayVariable<?>>> argumentStack;
 	private final boolean verbose;
 	private boolean log;
 	private int logCount;
+	private int argumentAlignment;
 
 	public CPrintWriter(OutputStream out, String topLevelMethodName) {
 		this(new PrintStreamPrintWriter(new PrintStream(out)), topLevelMethodName, false);
@@ -67,6 +88,14 @@ public class CPrintWriter extends CodePrintWriterAdapter {
 
 	public String getTopLevelMethodName() { return topLevelMethodName; }
 
+	/**
+	 * The alignment, in bytes, that the memory for every argument is known to have,
+	 * or zero if it is unknown. If this is specified, it is provided to the compiler.
+	 */
+	public int getArgumentAlignment() { return argumentAlignment; }
+
+	public void setArgumentAlignment(int argumentAlignment) { this.argumentAlignment = argumentAlignment; }
+
 	@Override
 	public void beginScope(String name, OperationMetadata metadata, List<ArrayVariable<?>> arguments, Accessibility access) {
 		if (arguments.size() > 100) {
@@ -81,6 +110,7 @@ public class CPrintWriter extends CodePrintWriterAdapter {
 		}
 
 		if (access == Accessibility.EXTERNAL && getTopLevelMethodName() != null) {
+			if (enableTargetClones) println(TARGET_CLONES, false);
 			super.beginScope(getTopLevelMethodName(), metadata, arguments, access);
 		} else {
 			super.beginScope(name, metadata, arguments, access);
@@ -137,10 +167,13 @@ public class CPrintWriter extends CodePrintWriterAdapter {
 	}
 
 	protected void copyInline(int index, ArrayVariable<?> variable, boolean write) {
-		String o = "((double *) argArr[" + index + "])";
+		String type = Hardware.getLocalHardware().getNumberTypeName();
+		String o = argumentAlignment > 0 ?
+				"((" + type + " *) __builtin_assume_aligned((void *) argArr[" + index + "], " + argumentAlignment + "))" :
+				"((" + type + " *) argArr[" + index + "])";
 		String v = new InstanceReference<>(variable).getExpression();
 
-		if (!write) println("double *" + v + " = " + o + ";");
+		if (!write) println(type + " *" + (enableRestrict ? "restrict " : "") + v + " = " + o + ";");
 	}
 
 	@Override
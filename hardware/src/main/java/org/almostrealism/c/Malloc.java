@@ -24,11 +24,11 @@ public class Malloc extends BaseNative {
 
 	@Override
 	public String getFunctionDefinition() {
-		return "JNIEXPORT jlong JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jint len) {\n" +
-				(enableVerbose ? "\tprintf(\"malloc - %i bytes\\n\", len);\n" : "") +
+		return "JNIEXPORT jlong JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jlong len) {\n" +
+				(enableVerbose ? "\tprintf(\"malloc - %li bytes\\n\", (long) len);\n" : "") +
 				"\treturn (jlong) malloc((size_t) len);\n" +
 				"}\n";
 	}
 
-	public native long apply(int len);
+	public native long apply(long len);
 }
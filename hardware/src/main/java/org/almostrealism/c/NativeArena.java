@@ -0,0 +1,120 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+import org.almostrealism.hardware.HardwareException;
+
+/**
+ * A {@link NativeArena} sub-allocates native memory from a single region, which
+ * is reserved the first time it is needed, so that allocating and freeing blocks
+ * does not require the system allocator. Every block is aligned to 64 bytes.
+ * Pages of the region are only committed when they are first touched, which
+ * also means that they are local to the NUMA node of the thread that first
+ * uses them. All of the blocks in the arena can be released at once using
+ * {@link #reset()}, which makes an arena suitable for scratch memory that
+ * is discarded after each frame.
+ *
+ * @see  Arena
+ */
+public class NativeArena {
+	/** The alignment, in bytes, of every block allocated by a {@link NativeArena}. */
+	public static final int ALIGNMENT = 64;
+
+	private static volatile Arena arena;
+
+	private final long size;
+	private final boolean hugePages;
+
+	private volatile long pointer;
+	private long base, regionSize;
+
+	/**
+	 * Create an arena which will reserve the specified number of bytes.
+	 *
+	 * @param hugePages  If true, the arena will request that the operating system
+	 *                   back it with transparent huge pages, when they are supported.
+	 */
+	public NativeArena(long size, boolean hugePages) {
+		this.size = size;
+		this.hugePages = hugePages;
+	}
+
+	protected long pointer() {
+		if (pointer == 0) {
+			synchronized (this) {
+				if (pointer == 0) {
+					long p = arena().apply(Arena.CREATE, hugePages ? Arena.FLAG_HUGE_PAGES : 0, size);
+					if (p == 0) throw new HardwareException("Unable to reserve " + size + " bytes for arena");
+					base = arena().apply(Arena.BASE, p, 0);
+					regionSize = arena().apply(Arena.SIZE, p, 0);
+					pointer = p;
+				}
+			}
+		}
+
+		return pointer;
+	}
+
+	/** Allocate a block of the specified number of bytes, returning its native pointer. */
+	public long allocate(long len) {
+		long p = arena().apply(Arena.ALLOCATE, pointer(), len);
+		if (p == 0) throw new HardwareException("Unable to allocate " + len + " bytes");
+		return p;
+	}
+
+	/** Return the specified block, which must have been obtained from {@link #allocate(long)}. */
+	public void free(long p) {
+		arena().apply(Arena.FREE, pointer(), p);
+	}
+
+	/**
+	 * Returns true if the specified block is part of the region of this arena.
+	 * Blocks that are not, because they were too large for the region, are not
+	 * released by {@link #reset()} and must be returned using {@link #free(long)}.
+	 */
+	public boolean contains(long p) {
+		if (pointer == 0) return false;
+		return p >= base && p < base + regionSize;
+	}
+
+	/**
+	 * Release every block in the region of this arena at once. None of the
+	 * blocks may be used after this, and this must not be called while the
+	 * arena is being used by another thread.
+	 */
+	public void reset() {
+		if (pointer == 0) return;
+		arena().apply(Arena.RESET, pointer, 0);
+	}
+
+	/** Release the region of this arena, after which it should no longer be used. */
+	public synchronized void destroy() {
+		if (pointer == 0) return;
+		arena().apply(Arena.DESTROY, pointer, 0);
+		pointer = 0;
+	}
+
+	private static Arena arena() {
+		if (arena == null) {
+			synchronized (NativeArena.class) {
+				if (arena == null) arena = new Arena();
+			}
+		}
+
+		return arena;
+	}
+}
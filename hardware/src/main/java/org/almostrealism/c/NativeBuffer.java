@@ -0,0 +1,39 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Provides a direct {@link ByteBuffer} which refers to native memory, so that
+ * the memory can be read and written from Java without any JNI call.
+ */
+public class NativeBuffer extends BaseNative {
+	public NativeBuffer() {
+		initNative();
+	}
+
+	@Override
+	public String getFunctionDefinition() {
+		return "JNIEXPORT jobject JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jlong arg, jlong len) {\n" +
+				(enableVerbose ? "\tprintf(\"nativeBuffer(%lu) - %li bytes\\n\", arg, len);\n" : "") +
+				"\treturn (*env)->NewDirectByteBuffer(env, (void *) arg, len);\n" +
+				"}\n";
+	}
+
+	public native ByteBuffer apply(long arg, long len);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+/**
+ * Invokes a function produced by {@link CPrintWriter}, given its address (see
+ * {@link NativeSymbol}). Because this single JNI entry point can invoke any such
+ * function, the functions themselves do not need to be bound to a Java class.
+ */
+public class NativeDispatch extends BaseNative {
+	public NativeDispatch() {
+		setHead("#include <stdint.h>\n" +
+				"typedef void (*ar_function)(long *, uint32_t *, uint32_t *, uint32_t);\n");
+		initNative();
+	}
+
+	@Override
+	public String getFunctionDefinition() {
+		return "JNIEXPORT void JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jlong function, " +
+				"jlong commandQueue, jlongArray arg, jintArray offset, jintArray size, jint count) {\n" +
+				(enableVerbose ? "\tprintf(\"dispatch(%lu)\\n\", function);\n" : "") +
+				"\tjint argCount = count > 0 ? count : 1;\n" +
+				"\tjlong argArr[argCount];\n" +
+				"\tjint offsetArr[argCount];\n" +
+				"\tjint sizeArr[argCount];\n" +
+				"\t(*env)->GetLongArrayRegion(env, arg, 0, count, argArr);\n" +
+				"\t(*env)->GetIntArrayRegion(env, offset, 0, count, offsetArr);\n" +
+				"\t(*env)->GetIntArrayRegion(env, size, 0, count, sizeArr);\n" +
+				"\t((ar_function) function)((long *) argArr, (uint32_t *) offsetArr, (uint32_t *) sizeArr, (uint32_t) count);\n" +
+				"}\n";
+	}
+
+	public native void apply(long function, long commandQueue, long arg[], int offset[], int size[], int count);
+}
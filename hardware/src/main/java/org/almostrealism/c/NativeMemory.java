@@ -19,15 +19,25 @@ package org.almostrealism.c;
 import io.almostrealism.code.MemoryProvider;
 import org.almostrealism.hardware.RAM;
 
+import java.nio.Buffer;
+import java.nio.DoubleBuffer;
+import java.nio.FloatBuffer;
+
 public class NativeMemory extends RAM {
 	private final MemoryProvider provider;
 	private final long nativePointer;
 	private final long size;
+	private final Buffer buffer;
 
 	public NativeMemory(MemoryProvider provider, long nativePointer, long size) {
+		this(provider, nativePointer, size, null);
+	}
+
+	public NativeMemory(MemoryProvider provider, long nativePointer, long size, Buffer buffer) {
 		this.provider = provider;
 		this.nativePointer = nativePointer;
 		this.size = size;
+		this.buffer = buffer;
 	}
 
 	@Override
@@ -40,4 +50,19 @@ public class NativeMemory extends RAM {
 
 	@Override
 	public long getSize() { return size; }
+
+	/**
+	 * A view of this memory, or null if there is no view available. Because
+	 * the position of the buffer is shared, callers should use a duplicate
+	 * of it rather than the buffer itself.
+	 */
+	public DoubleBuffer getBuffer() { return buffer instanceof DoubleBuffer ? (DoubleBuffer) buffer : null; }
+
+	/**
+	 * A view of this memory, if it holds fp32 values, or null if there
+	 * is no such view available.
+	 *
+	 * @see  #getBuffer()
+	 */
+	public FloatBuffer getFloatBuffer() { return buffer instanceof FloatBuffer ? (FloatBuffer) buffer : null; }
 }
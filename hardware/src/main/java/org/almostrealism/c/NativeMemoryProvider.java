@@ -19,85 +19,315 @@ package org.almostrealism.c;
 import io.almostrealism.code.MemoryProvider;
 import org.almostrealism.hardware.HardwareException;
 import org.almostrealism.hardware.RAM;
+import org.almostrealism.io.SystemUtils;
 
-import java.util.ArrayList;
-import java.util.List;
-import java.util.Objects;
-import java.util.concurrent.atomic.AtomicInteger;
+import java.nio.Buffer;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.DoubleBuffer;
+import java.nio.FloatBuffer;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicLong;
 
+/**
+ * A {@link MemoryProvider} for memory allocated on the native heap. The set of
+ * allocations is maintained without a global lock, so that reads and writes to
+ * different {@link NativeMemory} blocks, from different threads, do not contend
+ * with one another. Callers are still responsible for not deallocating memory
+ * while it is being used by another thread.
+ *
+ * Values are stored either as fp64 or, for single precision {@link org.almostrealism.hardware.Hardware},
+ * as fp32, in which case they are converted when they are copied to or from a
+ * double array.
+ */
 public class NativeMemoryProvider implements MemoryProvider<RAM> {
-	private Malloc malloc;
-	private Free free;
-	private NativeRead read;
-	private NativeWrite write;
+	/**
+	 * If enabled, each {@link NativeMemory} is given a direct buffer view
+	 * (see {@link NativeBuffer}), which is used to read and write it without
+	 * any JNI call.
+	 */
+	public static boolean enableDirectBuffers = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_BUFFERS").orElse(true);
+
+	/**
+	 * If enabled, memory is sub-allocated from a {@link NativeArena} sized to the
+	 * memory max, rather than obtaining each block from the system allocator.
+	 */
+	public static boolean enableArena = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_ARENA").orElse(false);
+
+	/** If enabled, the {@link NativeArena} will request transparent huge pages. */
+	public static boolean enableHugePages = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_HUGE_PAGES").orElse(false);
+
+	private volatile Malloc malloc;
+	private volatile Free free;
+	private volatile NativeRead read;
+	private volatile NativeWrite write;
+	private volatile NativeBuffer buffer;
 
 	private final int numberSize;
 	private final long memoryMax;
-	private long memoryUsed;
+	private final AtomicLong memoryUsed;
+	private final NativeArena arena;
 
-	private List<NativeMemory> allocated;
+	private final Set<NativeMemory> allocated;
 
 	public NativeMemoryProvider(long memoryMax) {
-		this.numberSize = 8;
+		this(memoryMax, 8);
+	}
+
+	/**
+	 * Create a provider for values of the specified number of bytes, which
+	 * must be either 8 (fp64) or 4 (fp32).
+	 */
+	public NativeMemoryProvider(long memoryMax, int numberSize) {
+		this(memoryMax, numberSize, enableArena ? new NativeArena(memoryMax, enableHugePages) : null);
+	}
+
+	/**
+	 * Create a provider which allocates from the specified {@link NativeArena},
+	 * or from the system allocator if it is null. A provider with its own arena
+	 * can be used for scratch memory, which is released all at once using
+	 * {@link #reset()}.
+	 */
+	public NativeMemoryProvider(long memoryMax, NativeArena arena) {
+		this(memoryMax, 8, arena);
+	}
+
+	public NativeMemoryProvider(long memoryMax, int numberSize, NativeArena arena) {
+		if (numberSize != 8 && numberSize != 4)
+			throw new IllegalArgumentException("Unsupported number size " + numberSize);
+
+		this.numberSize = numberSize;
 		this.memoryMax = memoryMax;
-		this.allocated = new ArrayList<>();
+		this.memoryUsed = new AtomicLong();
+		this.arena = arena;
+		this.allocated = ConcurrentHashMap.newKeySet();
+	}
+
+	/** The number of bytes used for each value, 8 for fp64 or 4 for fp32. */
+	public int getNumberSize() { return numberSize; }
+
+	public long getMemoryUsed() { return memoryUsed.get(); }
+
+	/**
+	 * The alignment, in bytes, that generated code may assume for every block
+	 * from this provider, or zero if no alignment is guaranteed.
+	 */
+	public int getAlignment() { return arena == null ? 0 : NativeArena.ALIGNMENT; }
+
+	/**
+	 * The alignment, in bytes, that generated code may assume for the memory
+	 * of the specified {@link MemoryProvider}, or zero if it is not a
+	 * {@link NativeMemoryProvider} which guarantees an alignment.
+	 */
+	public static int getAlignment(MemoryProvider<?> provider) {
+		return provider instanceof NativeMemoryProvider ? ((NativeMemoryProvider) provider).getAlignment() : 0;
 	}
 
 	@Override
-	public synchronized NativeMemory allocate(int size) {
-		if (malloc == null) malloc = new Malloc();
+	public NativeMemory allocate(int size) {
+		long bytes = (long) numberSize * size;
 
-		if (memoryUsed + (long) numberSize * size > memoryMax) {
+		if (memoryUsed.getAndUpdate(used -> used + bytes > memoryMax ? used : used + bytes) + bytes > memoryMax) {
 			throw new HardwareException("Memory max reached");
-		} else {
-			memoryUsed += (long) numberSize * size;
-			NativeMemory mem = new NativeMemory(this, malloc.apply(numberSize * size), numberSize * (long) size);
-			allocated.add(mem);
-			return mem;
 		}
+
+		long pointer;
+
+		try {
+			pointer = arena == null ? malloc().apply(bytes) : arena.allocate(bytes);
+			if (pointer == 0 && bytes > 0) throw new HardwareException("Unable to allocate " + bytes + " bytes");
+		} catch (RuntimeException e) {
+			memoryUsed.addAndGet(-bytes);
+			throw e;
+		}
+
+		NativeMemory mem = new NativeMemory(this, pointer, bytes, buffer(pointer, size));
+		allocated.add(mem);
+		return mem;
 	}
 
 	@Override
-	public synchronized void deallocate(int size, RAM mem) {
-		if (!allocated.contains(mem)) return;
+	public void deallocate(int size, RAM mem) {
+		if (!allocated.remove(mem)) return;
 
-		if (free == null) free = new Free();
+		release(mem.getNativePointer());
+		memoryUsed.addAndGet(-(long) size * numberSize);
+	}
 
-		free.apply(mem.getNativePointer());
-		memoryUsed -= (long) size * numberSize;
-		allocated.remove(mem);
+	private void release(long pointer) {
+		if (arena == null) {
+			free().apply(pointer);
+		} else {
+			arena.free(pointer);
+		}
 	}
 
 	@Override
-	public synchronized void setMem(RAM mem, int offset, RAM source, int srcOffset, int length) {
+	public void setMem(RAM mem, int offset, RAM source, int srcOffset, int length) {
 		if (!allocated.contains(mem))
 			throw new HardwareException(mem + " not available");
+
+		if (source instanceof NativeMemory && allocated.contains(source)) {
+			NativeMemory m = (NativeMemory) mem;
+			NativeMemory s = (NativeMemory) source;
+
+			if (m.getBuffer() != null && s.getBuffer() != null) {
+				DoubleBuffer src = s.getBuffer().duplicate();
+				src.position(srcOffset);
+				src.limit(srcOffset + length);
+
+				DoubleBuffer buf = m.getBuffer().duplicate();
+				buf.position(offset);
+				buf.put(src);
+				return;
+			} else if (m.getFloatBuffer() != null && s.getFloatBuffer() != null) {
+				FloatBuffer src = s.getFloatBuffer().duplicate();
+				src.position(srcOffset);
+				src.limit(srcOffset + length);
+
+				FloatBuffer buf = m.getFloatBuffer().duplicate();
+				buf.position(offset);
+				buf.put(src);
+				return;
+			}
+		}
+
 		double value[] = new double[length];
 		getMem(source, srcOffset, value, 0, length);
 		setMem(mem, offset, value, 0, length);
 	}
 
 	@Override
-	public synchronized void setMem(RAM mem, int offset, double[] source, int srcOffset, int length) {
+	public void setMem(RAM mem, int offset, double[] source, int srcOffset, int length) {
 		if (!allocated.contains(mem))
 			throw new HardwareException(mem + " not available");
-		if (write == null) write = new NativeWrite();
-		write.apply((NativeMemory) mem, offset, source, srcOffset, length);
+
+		DoubleBuffer buf = ((NativeMemory) mem).getBuffer();
+		FloatBuffer fbuf = ((NativeMemory) mem).getFloatBuffer();
+
+		if (buf != null) {
+			buf = buf.duplicate();
+			buf.position(offset);
+			buf.put(source, srcOffset, length);
+			return;
+		} else if (fbuf != null) {
+			for (int i = 0; i < length; i++) {
+				fbuf.put(offset + i, (float) source[srcOffset + i]);
+			}
+
+			return;
+		}
+
+		write().apply((NativeMemory) mem, offset, source, srcOffset, length);
 	}
 
 	@Override
-	public synchronized void getMem(RAM mem, int sOffset, double[] out, int oOffset, int length) {
+	public void getMem(RAM mem, int sOffset, double[] out, int oOffset, int length) {
 		if (!allocated.contains(mem))
 			throw new HardwareException(mem + " not available");
-		if (read == null) read = new NativeRead();
-		read.apply((NativeMemory) mem, sOffset, out, oOffset, length);
+
+		DoubleBuffer buf = ((NativeMemory) mem).getBuffer();
+		FloatBuffer fbuf = ((NativeMemory) mem).getFloatBuffer();
+
+		if (buf != null) {
+			buf = buf.duplicate();
+			buf.position(sOffset);
+			buf.get(out, oOffset, length);
+			return;
+		} else if (fbuf != null) {
+			for (int i = 0; i < length; i++) {
+				out[oOffset + i] = fbuf.get(sOffset + i);
+			}
+
+			return;
+		}
+
+		read().apply((NativeMemory) mem, sOffset, out, oOffset, length);
+	}
+
+	protected Buffer buffer(long pointer, int size) {
+		if (!enableDirectBuffers || pointer == 0 || size <= 0) return null;
+		if (numberSize * (long) size > Integer.MAX_VALUE) return null;
+
+		ByteBuffer buf = nativeBuffer().apply(pointer, numberSize * (long) size).order(ByteOrder.nativeOrder());
+		return numberSize == 4 ? buf.asFloatBuffer() : buf.asDoubleBuffer();
+	}
+
+	private Malloc malloc() {
+		if (malloc == null) {
+			synchronized (this) {
+				if (malloc == null) malloc = new Malloc();
+			}
+		}
+
+		return malloc;
+	}
+
+	private Free free() {
+		if (free == null) {
+			synchronized (this) {
+				if (free == null) free = new Free();
+			}
+		}
+
+		return free;
+	}
+
+	private NativeRead read() {
+		if (read == null) {
+			synchronized (this) {
+				if (read == null) read = new NativeRead();
+			}
+		}
+
+		return read;
+	}
+
+	private NativeWrite write() {
+		if (write == null) {
+			synchronized (this) {
+				if (write == null) write = new NativeWrite();
+			}
+		}
+
+		return write;
+	}
+
+	private NativeBuffer nativeBuffer() {
+		if (buffer == null) {
+			synchronized (this) {
+				if (buffer == null) buffer = new NativeBuffer();
+			}
+		}
+
+		return buffer;
+	}
+
+	/**
+	 * Deallocate all of the memory obtained from this provider. When the provider
+	 * uses a {@link NativeArena}, the blocks in its region are released at once,
+	 * and any others, which the arena obtained with posix_memalign, are freed one
+	 * at a time, as is all memory obtained without an arena. This must not be
+	 * called while the memory is in use by another thread.
+	 */
+	public void reset() {
+		for (NativeMemory mem : allocated) {
+			if (allocated.remove(mem)) {
+				if (arena == null || !arena.contains(mem.getNativePointer())) {
+					release(mem.getNativePointer());
+				}
+
+				memoryUsed.addAndGet(-mem.getSize());
+			}
+		}
+
+		if (arena != null) arena.reset();
 	}
 
 	@Override
-	public synchronized void destroy() {
-		if (free == null) free = new Free();
-		allocated.stream().mapToLong(NativeMemory::getNativePointer).forEach(free::apply);
-		allocated.clear();
-		memoryUsed = 0;
+	public void destroy() {
+		reset();
+		if (arena != null) arena.destroy();
 	}
 }
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+/**
+ * Invokes a sequence of functions produced by {@link CPrintWriter}, given their
+ * addresses (see {@link NativeSymbol}), with a single JNI call. The arguments for
+ * all of the functions are concatenated, and count identifies how many of them
+ * belong to each function. The arrays are copied before any of the functions
+ * are invoked, as they may run for a long time and the garbage collector must
+ * not be blocked by a critical region while they do.
+ */
+public class NativeProgram extends BaseNative {
+	public NativeProgram() {
+		setHead("#include <stdint.h>\n" +
+				"typedef void (*ar_function)(long *, uint32_t *, uint32_t *, uint32_t);\n");
+		initNative();
+	}
+
+	@Override
+	public String getFunctionDefinition() {
+		return "JNIEXPORT void JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jlongArray function, " +
+				"jlongArray arg, jintArray offset, jintArray size, jintArray count, jint n) {\n" +
+				(enableVerbose ? "\tprintf(\"program(%i)\\n\", n);\n" : "") +
+				"\tjsize total = (*env)->GetArrayLength(env, arg);\n" +
+				"\tjsize argCount = total > 0 ? total : 1;\n" +
+				"\tjsize functionCount = n > 0 ? n : 1;\n" +
+				"\tjlong functionArr[functionCount];\n" +
+				"\tjint countArr[functionCount];\n" +
+				"\tjlong argArr[argCount];\n" +
+				"\tjint offsetArr[argCount];\n" +
+				"\tjint sizeArr[argCount];\n" +
+				"\t(*env)->GetLongArrayRegion(env, function, 0, n, functionArr);\n" +
+				"\t(*env)->GetIntArrayRegion(env, count, 0, n, countArr);\n" +
+				"\t(*env)->GetLongArrayRegion(env, arg, 0, total, argArr);\n" +
+				"\t(*env)->GetIntArrayRegion(env, offset, 0, total, offsetArr);\n" +
+				"\t(*env)->GetIntArrayRegion(env, size, 0, total, sizeArr);\n" +
+				"\tint pos = 0;\n" +
+				"\tfor (int i = 0; i < n; i++) {\n" +
+				"\t\t((ar_function) functionArr[i])((long *) argArr + pos, (uint32_t *) offsetArr + pos, (uint32_t *) sizeArr + pos, (uint32_t) countArr[i]);\n" +
+				"\t\tpos += countArr[i];\n" +
+				"\t}\n" +
+				"}\n";
+	}
+
+	public native void apply(long function[], long arg[], int offset[], int size[], int count[], int n);
+}
@@ -25,15 +25,18 @@ public class NativeRead extends BaseNative {
 
 	@Override
 	public String getFunctionDefinition() {
-		return "JNIEXPORT jdoubleArray JNICALL " + getFunctionName() +
-				" (JNIEnv* env, jobject thisObject, jlong arg, jint offset, jint len) {\n" +
+		return "JNIEXPORT void JNICALL " + getFunctionName() +
+				" (JNIEnv* env, jobject thisObject, jlong arg, jint offset, jdoubleArray target, jint toffset, jint len, jint numberSize) {\n" +
 				(enableVerbose ? "\tprintf(\"nativeRead(%lu) - %i values\\n\", arg, len);\n" : "") +
-				"\tdouble* input = (double *) arg;\n" +
-				"\tjdoubleArray output = (*env)->NewDoubleArray(env, (jsize) len);\n" +
-				"\tfor (int i = 0; i < len; i++) {\n" +
-				"\t\t(*env)->SetDoubleArrayRegion(env, output, i, 1, (const jdouble*)&input[offset + i]);\n" +
+				"\tif (numberSize == 4) {\n" +
+				"\t\tfloat* input = (float *) arg;\n" +
+				"\t\tjdouble* out = (jdouble*) (*env)->GetPrimitiveArrayCritical(env, target, NULL);\n" +
+				"\t\tfor (jint i = 0; i < len; i++) out[toffset + i] = (jdouble) input[offset + i];\n" +
+				"\t\t(*env)->ReleasePrimitiveArrayCritical(env, target, out, 0);\n" +
+				"\t} else {\n" +
+				"\t\tdouble* input = (double *) arg;\n" +
+				"\t\t(*env)->SetDoubleArrayRegion(env, target, (jsize) toffset, (jsize) len, (const jdouble*) &input[offset]);\n" +
 				"\t}\n" +
-				"return output;\n" +
 				"}\n";
 	}
 
@@ -50,9 +53,17 @@ public class NativeRead extends BaseNative {
 	}
 
 	public void apply(NativeMemory mem, int offset, double target[], int toffset, int length) {
-		double out[] = apply(mem.getNativePointer(), offset, length);
-		if (length >= 0) System.arraycopy(out, 0, target, toffset, length);
+		if (length > 0) apply(mem.getNativePointer(), offset, target, toffset, length, numberSize(mem));
 	}
 
-	public native double[] apply(long arg, int offset, int length);
+	private static int numberSize(NativeMemory mem) {
+		return mem.getProvider() instanceof NativeMemoryProvider ?
+				((NativeMemoryProvider) mem.getProvider()).getNumberSize() : 8;
+	}
+
+	/**
+	 * Copy values from native memory directly into the target array, using a single JNI call.
+	 * Native values of 4 bytes are converted to or from double.
+	 */
+	public native void apply(long arg, int offset, double[] target, int toffset, int length, int numberSize);
 }
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.c;
+
+/**
+ * Resolves the address of a function in a shared library, loading the library
+ * if it has not already been loaded. The address can be invoked using
+ * {@link NativeDispatch}.
+ */
+public class NativeSymbol extends BaseNative {
+	public NativeSymbol() {
+		setHead("#include <dlfcn.h>\n");
+		initNative();
+	}
+
+	@Override
+	public String getFunctionDefinition() {
+		return "JNIEXPORT jlong JNICALL " + getFunctionName() + " (JNIEnv* env, jobject thisObject, jstring library, jstring symbol) {\n" +
+				"\tconst char *lib = (*env)->GetStringUTFChars(env, library, 0);\n" +
+				"\tconst char *sym = (*env)->GetStringUTFChars(env, symbol, 0);\n" +
+				(enableVerbose ? "\tprintf(\"dlsym(%s, %s)\\n\", lib, sym);\n" : "") +
+				"\tvoid *handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);\n" +
+				"\tvoid *f = handle == NULL ? NULL : dlsym(handle, sym);\n" +
+				"\tif (f == NULL) printf(\"%s\\n\", dlerror());\n" +
+				"\t(*env)->ReleaseStringUTFChars(env, library, lib);\n" +
+				"\t(*env)->ReleaseStringUTFChars(env, symbol, sym);\n" +
+				"\treturn (jlong) f;\n" +
+				"}\n";
+	}
+
+	public native long apply(String library, String symbol);
+}
@@ -26,14 +26,17 @@ public class NativeWrite extends BaseNative {
 	@Override
 	public String getFunctionDefinition() {
 		return "JNIEXPORT void JNICALL " + getFunctionName() +
-				" (JNIEnv* env, jobject thisObject, jlong arg, jint offset, jdoubleArray target, jint toffset, jint len) {\n" +
+				" (JNIEnv* env, jobject thisObject, jlong arg, jint offset, jdoubleArray target, jint toffset, jint len, jint numberSize) {\n" +
 				(enableVerbose ? "\tprintf(\"nativeWrite(%lu) - %i values\\n\", arg, len);\n" : "") +
-				"\tdouble* input = (*env)->GetDoubleArrayElements(env, target, 0);\n" +
-				"\tdouble* output = (double *) arg;\n" +
-				"\tfor (int i = 0; i < len; i++) {\n" +
-				"\t\toutput[offset + i] = input[toffset + i];\n" +
-				"\t}" +
-				"\tfree(input);\n" +
+				"\tif (numberSize == 4) {\n" +
+				"\t\tfloat* output = (float *) arg;\n" +
+				"\t\tjdouble* in = (jdouble*) (*env)->GetPrimitiveArrayCritical(env, target, NULL);\n" +
+				"\t\tfor (jint i = 0; i < len; i++) output[offset + i] = (float) in[toffset + i];\n" +
+				"\t\t(*env)->ReleasePrimitiveArrayCritical(env, target, in, JNI_ABORT);\n" +
+				"\t} else {\n" +
+				"\t\tdouble* output = (double *) arg;\n" +
+				"\t\t(*env)->GetDoubleArrayRegion(env, target, (jsize) toffset, (jsize) len, (jdouble*) &output[offset]);\n" +
+				"\t}\n" +
 				"}\n";
 	}
 
@@ -50,8 +53,17 @@ public class NativeWrite extends BaseNative {
 	}
 
 	public void apply(NativeMemory mem, int offset, double target[], int toffset, int length) {
-		apply(mem.getNativePointer(), offset, target, toffset, length);
+		if (length > 0) apply(mem.getNativePointer(), offset, target, toffset, length, numberSize(mem));
 	}
 
-	public native void apply(long arg, int offset, double[] target, int toffset, int length);
+	private static int numberSize(NativeMemory mem) {
+		return mem.getProvider() instanceof NativeMemoryProvider ?
+				((NativeMemoryProvider) mem.getProvider()).getNumberSize() : 8;
+	}
+
+	/**
+	 * Copy values from the target array directly into native memory, using a single JNI call.
+	 * Native values of 4 bytes are converted to or from double.
+	 */
+	public native void apply(long arg, int offset, double[] target, int toffset, int length, int numberSize);
 }
@@ -32,10 +32,7 @@ public class AcceleratedComputationEvaluable<T extends MemoryData> extends Accel
 
 	@Override
 	public T evaluate(Object... args) {
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+		compileIfNecessary();
 
 		ArrayVariable outputVariable = (ArrayVariable) getComputation().getOutputVariable();
 
@@ -18,24 +18,47 @@ package org.almostrealism.hardware;
 
 import io.almostrealism.code.ArgumentMap;
 import io.almostrealism.code.Computation;
+import io.almostrealism.code.InstructionSet;
 import io.almostrealism.code.NameProvider;
 import io.almostrealism.code.ScopeInputManager;
+import io.almostrealism.code.ScopeOptimizer;
 import io.almostrealism.relation.Compactable;
 import io.almostrealism.relation.Named;
 import io.almostrealism.scope.ArrayVariable;
 import io.almostrealism.code.OperationAdapter;
 import io.almostrealism.scope.Scope;
 import io.almostrealism.scope.Variable;
+import org.almostrealism.hardware.jni.AsyncInstructionSet;
+import org.almostrealism.io.SystemUtils;
 
+import java.util.Collection;
 import java.util.List;
-import java.util.function.Consumer;
+import java.util.stream.Collectors;
 
 public class AcceleratedComputationOperation<T> extends DynamicAcceleratedOperation<MemoryData> implements NameProvider {
 	public static boolean enableRequiredScopes = true;
 
+	/**
+	 * If enabled, repeated expressions in each {@link Scope} are combined by a
+	 * {@link ScopeOptimizer} before it is delivered to a backend. Only
+	 * {@link io.almostrealism.expression.Expression#isPure() pure} expressions
+	 * are combined.
+	 */
+	public static boolean enableScopeOptimization = SystemUtils.isEnabled("AR_HARDWARE_SCOPE_OPTIMIZATION").orElse(false);
+
+	/**
+	 * If enabled, arguments which a {@link Scope} never references are removed
+	 * by a {@link ScopeOptimizer} before its arguments are determined, so that
+	 * they are not passed to the generated function.
+	 */
+	public static boolean enableArgumentPruning = SystemUtils.isEnabled("AR_HARDWARE_ARGUMENT_PRUNING").orElse(true);
+
 	private Computation<T> computation;
 	private Scope<T> scope;
 
+	private int invocations;
+	private boolean releasePending;
+
 	public AcceleratedComputationOperation(Computation<T> c, boolean kernel) {
 		super(kernel, new ArrayVariable[0]);
 		this.computation = c;
@@ -120,6 +143,9 @@ public class AcceleratedComputationOperation<T> extends DynamicAcceleratedOperat
 		if (outputVariable != null) c.setOutputVariable(outputVariable);
 		scope = c.getScope();
 		if (enableRequiredScopes) scope.convertArgumentsToRequiredScopes();
+		if (enableScopeOptimization || enableArgumentPruning) {
+			new ScopeOptimizer(enableScopeOptimization, enableArgumentPruning).optimize(scope);
+		}
 		postCompile();
 		return scope;
 	}
@@ -132,17 +158,88 @@ public class AcceleratedComputationOperation<T> extends DynamicAcceleratedOperat
 	}
 
 	@Override
-	public synchronized Consumer<Object[]> getOperator() {
-		if (operators == null || operators.isDestroyed()) {
-			operators = Hardware.getLocalHardware().getComputeContext().deliver(scope);
-		}
-
-		return operators.get(getFunctionName(), getArgsCount());
+	protected synchronized InstructionSet deliverInstructions() {
+		return Hardware.getLocalHardware().getComputeContext().deliver(scope);
 	}
 
 	@Override
 	public Variable getOutputVariable() { return computation.getOutputVariable(); }
 
+	/**
+	 * The {@link InstructionSet} this operation was delivered to, or null if it
+	 * has not been delivered yet.
+	 */
+	public synchronized InstructionSet getInstructionSet() { return operators; }
+
+	@Override
+	protected synchronized void beginInvocation() { invocations++; }
+
+	@Override
+	protected synchronized void endInvocation() {
+		invocations--;
+
+		if (invocations == 0 && releasePending) {
+			releasePending = false;
+			releaseInstructions();
+		}
+	}
+
+	/**
+	 * Destroy the {@link InstructionSet} this operation was delivered to, if any,
+	 * along with the operators obtained from it. The scope is kept, so the operation
+	 * will be delivered again if it is used. If any thread is running the operation,
+	 * the instructions are destroyed when the last of them has finished instead.
+	 */
+	public synchronized void releaseInstructions() {
+		if (invocations > 0) {
+			releasePending = true;
+			return;
+		}
+
+		if (operators != null && !operators.isDestroyed()) operators.destroy();
+		setInstructions(null);
+	}
+
+	/**
+	 * Compile each of the specified operations ahead of time, rather than when
+	 * they are first used. When the compute context compiles in the background,
+	 * all of the compilations run concurrently, and this method waits for all
+	 * of them to finish.
+	 */
+	public static void precompile(Collection<? extends AcceleratedComputationOperation<?>> operations) {
+		deliver(operations);
+
+		for (AcceleratedComputationOperation<?> op : operations) {
+			InstructionSet instructions = op.operators;
+			if (instructions instanceof AsyncInstructionSet) ((AsyncInstructionSet) instructions).await();
+		}
+	}
+
+	/**
+	 * Deliver the scopes of all of the specified operations which have not already
+	 * been delivered to the compute context together, so that it can compile them
+	 * as a group (see {@link io.almostrealism.code.ComputeContext#deliver(List)}).
+	 */
+	public static void deliver(Collection<? extends AcceleratedComputationOperation<?>> operations) {
+		List<AcceleratedComputationOperation<?>> pending = operations.stream()
+				.filter(op -> op.operators == null || op.operators.isDestroyed())
+				.distinct().collect(Collectors.toList());
+		if (pending.isEmpty()) return;
+
+		for (AcceleratedComputationOperation<?> op : pending) {
+			if (op.getArgumentVariables() == null) op.compile();
+		}
+
+		List<InstructionSet> instructions = Hardware.getLocalHardware().getComputeContext()
+				.deliver(pending.stream().map(op -> (Scope) op.scope).collect(Collectors.toList()));
+
+		for (int i = 0; i < pending.size(); i++) {
+			AcceleratedComputationOperation<?> op = pending.get(i);
+
+			op.setInstructions(instructions.get(i));
+		}
+	}
+
 	@Override
 	public void compact() {
 		if (getComputation() instanceof Compactable) {
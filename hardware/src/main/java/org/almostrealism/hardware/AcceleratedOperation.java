@@ -178,32 +178,52 @@ public abstract class AcceleratedOperation<T extends MemoryData> extends Operati
 	@Override
 	public void run() { apply(new Object[0]); }
 
+	/**
+	 * Run this operation. Each thread uses its own operator, so threads
+	 * which run the same operation at the same time do not wait for each
+	 * other.
+	 */
 	@Override
-	public synchronized Object[] apply(Object[] args) {
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+	public Object[] apply(Object[] args) {
+		compileIfNecessary();
 
-		Consumer<Object[]> op = getOperator();
+		beginInvocation();
 
-		Object allArgs[] = getAllArgs(args);
+		try {
+			Consumer<Object[]> op = getOperator();
 
-		for (int i = 0; i < allArgs.length; i++) {
-			if (allArgs[i] == null) return new Object[] { handleNull(i) };
-		}
+			Object allArgs[] = getAllArgs(args);
+
+			for (int i = 0; i < allArgs.length; i++) {
+				if (allArgs[i] == null) return new Object[] { handleNull(i) };
+			}
 
-		String before = null;
-		if (enableInputLogging) before = Arrays.toString(allArgs);
+			String before = null;
+			if (enableInputLogging) before = Arrays.toString(allArgs);
 
-		op.accept(allArgs);
+			op.accept(allArgs);
 
-		if (enableInputLogging) {
-			System.out.println(getName() + ": " + before + " -> " + Arrays.toString(allArgs));
+			if (enableInputLogging) {
+				System.out.println(getName() + ": " + before + " -> " + Arrays.toString(allArgs));
+			}
+			return allArgs;
+		} finally {
+			endInvocation();
 		}
-		return allArgs;
 	}
 
+	/**
+	 * Indicate that the current thread is about to use the operator for this
+	 * operation. Every call must be followed by {@link #endInvocation()}.
+	 */
+	protected void beginInvocation() { }
+
+	/**
+	 * Indicate that the current thread has finished using the operator for
+	 * this operation.
+	 */
+	protected void endInvocation() { }
+
 	protected Object[] getAllArgs(Object args[]) {
 		List<Argument<? extends T>> arguments = getArguments();
 		Object allArgs[] = new Object[arguments.size()];
@@ -258,6 +278,36 @@ public abstract class AcceleratedOperation<T extends MemoryData> extends Operati
 		return allArgs;
 	}
 
+	/**
+	 * If every argument to this operation is a fixed value, rather than one that
+	 * must be evaluated each time the operation is run, return the arguments.
+	 * Otherwise, return null.
+	 */
+	public MemoryData[] getFixedArguments() {
+		List<Argument<? extends T>> arguments = getArguments();
+		if (arguments == null) return null;
+
+		for (Argument<? extends T> arg : arguments) {
+			if (arg == null || arg.getVariable().getProducer() == null) return null;
+			if (getProducerArgumentReferenceIndex(arg.getVariable()) >= 0) return null;
+
+			// Arguments which getAllArgs evaluates for each invocation are not fixed
+			if (arg.getExpectation() == Expectation.EVALUATE_AHEAD) return null;
+
+			Supplier producer = arg.getVariable().getProducer();
+			boolean fixed = producer instanceof Delegated && ((Delegated) producer).getDelegate() instanceof Provider;
+			if (!fixed && !(producer instanceof Delegated) && !(producer instanceof ProducerComputation)) {
+				fixed = producer.get() instanceof Provider;
+			}
+
+			if (!fixed) return null;
+		}
+
+		Object args[] = getAllArgs(new Object[0]);
+		if (Arrays.stream(args).anyMatch(arg -> !(arg instanceof MemoryData))) return null;
+		return Arrays.stream(args).map(arg -> (MemoryData) arg).toArray(MemoryData[]::new);
+	}
+
 	private static int getProducerArgumentReferenceIndex(Variable<?, ?> arg) {
 		if (arg.getProducer() instanceof ProducerArgumentReference) {
 			return ((ProducerArgumentReference) arg.getProducer()).getReferencedArgumentIndex();
@@ -298,16 +348,14 @@ public abstract class AcceleratedOperation<T extends MemoryData> extends Operati
 
 	@Override
 	public void kernelOperate(MemoryBank output, MemoryData[] args) {
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+		compileIfNecessary();
+		beginInvocation();
 
 		try {
 			if (isKernel() && enableKernel) {
 				Consumer<Object[]> operator = getOperator();
-				((HardwareOperator) operator).setGlobalWorkOffset(0);
-				((HardwareOperator) operator).setGlobalWorkSize(Optional.ofNullable(output).map(MemoryBank::getCount).orElseGet(() -> ((MemoryBank) args[0]).getCount()));
+				((KernelOperator) operator).setGlobalWorkOffset(0);
+				((KernelOperator) operator).setGlobalWorkSize(Optional.ofNullable(output).map(MemoryBank::getCount).orElseGet(() -> ((MemoryBank) args[0]).getCount()));
 
 				if (enableKernelLog) System.out.println("AcceleratedOperation: Preparing " + getName() + " kernel...");
 				MemoryData input[] = getKernelArgs(output, args);
@@ -320,21 +368,21 @@ public abstract class AcceleratedOperation<T extends MemoryData> extends Operati
 			}
 		} catch (CLException e) {
 			throw new HardwareException("Could not evaluate AcceleratedOperation", e);
+		} finally {
+			endInvocation();
 		}
 	}
 
 	@Override
 	public void kernelOperate(MemoryData... args) {
-		if (getArgumentVariables() == null) {
-			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
-			compile();
-		}
+		compileIfNecessary();
+		beginInvocation();
 
 		try {
 			if (isKernel() && enableKernel) {
 				Consumer<Object[]> operator = getOperator();
-				((HardwareOperator) operator).setGlobalWorkOffset(0);
-				((HardwareOperator) operator).setGlobalWorkSize(((MemoryBank) args[0]).getCount());
+				((KernelOperator) operator).setGlobalWorkOffset(0);
+				((KernelOperator) operator).setGlobalWorkSize(((MemoryBank) args[0]).getCount());
 
 				if (enableKernelLog) System.out.println("AcceleratedOperation: Preparing " + getName() + " kernel...");
 				MemoryData input[] = getKernelArgs(null, args);
@@ -347,6 +395,20 @@ public abstract class AcceleratedOperation<T extends MemoryData> extends Operati
 			}
 		} catch (CLException e) {
 			throw new HardwareException("Could not evaluate AcceleratedOperation", e);
+		} finally {
+			endInvocation();
+		}
+	}
+
+	/**
+	 * Compile this operation if it was not compiled ahead of time. The operator
+	 * used to run it is obtained separately by each thread, so this is the only
+	 * part of running the operation which requires the lock.
+	 */
+	protected synchronized void compileIfNecessary() {
+		if (getArgumentVariables() == null) {
+			System.out.println("WARN: " + getName() + " was not compiled ahead of time");
+			compile();
 		}
 	}
 
@@ -29,6 +29,14 @@ import java.util.function.Supplier;
 public abstract class DynamicAcceleratedOperation<T extends MemoryData> extends AcceleratedOperation<T> implements ExplictBody<T> {
 	protected InstructionSet operators;
 
+	/**
+	 * The operator obtained from {@link #operators} by each thread, which is kept so
+	 * that any state it reuses between invocations is not discarded. Each thread has
+	 * its own, so that threads can use the operation at the same time without sharing
+	 * the work range of a kernel. It is replaced whenever {@link #operators} is.
+	 */
+	private ThreadLocal<Consumer<Object[]>> operator = new ThreadLocal<>();
+
 	@SafeVarargs
 	public DynamicAcceleratedOperation(boolean kernel, Supplier<Evaluable<? extends T>>... args) {
 		super(kernel, args);
@@ -40,12 +48,44 @@ public abstract class DynamicAcceleratedOperation<T extends MemoryData> extends
 	}
 
 	@Override
-	public synchronized Consumer<Object[]> getOperator() {
-		if (operators == null || operators.isDestroyed()) {
-			operators = Hardware.getLocalHardware().getClComputeContext().deliver(Scope.verbatim(getFunctionDefinition()));
+	public Consumer<Object[]> getOperator() {
+		InstructionSet instructions;
+		ThreadLocal<Consumer<Object[]>> local;
+
+		synchronized (this) {
+			if (operators == null || operators.isDestroyed()) {
+				setInstructions(deliverInstructions());
+			}
+
+			instructions = operators;
+			local = operator;
+		}
+
+		Consumer<Object[]> op = local.get();
+
+		if (op == null) {
+			op = instructions.get(getFunctionName(), getArgsCount());
+			local.set(op);
 		}
 
-		return operators.get(getFunctionName(), getArgsCount());
+		return op;
+	}
+
+	/**
+	 * Deliver this operation to the compute context, returning the
+	 * {@link InstructionSet} which can be used to run it.
+	 */
+	protected InstructionSet deliverInstructions() {
+		return Hardware.getLocalHardware().getClComputeContext().deliver(Scope.verbatim(getFunctionDefinition()));
+	}
+
+	/**
+	 * Replace the {@link InstructionSet} for this operation, discarding the
+	 * operators every thread obtained from the previous one.
+	 */
+	protected synchronized void setInstructions(InstructionSet instructions) {
+		operators = instructions;
+		operator = new ThreadLocal<>();
 	}
 
 	/**
@@ -131,7 +171,8 @@ public abstract class DynamicAcceleratedOperation<T extends MemoryData> extends
 
 		if (operators != null) {
 			operators.destroy();
-			operators = null;
 		}
+
+		setInstructions(null);
 	}
 }
@@ -49,6 +49,7 @@ public final class Hardware {
 
 	protected static final int MEMORY_SCALE;
 	protected static final boolean ENABLE_POOLING;
+	protected static final long POOL_BUDGET;
 
 	protected static final long timeSeriesSize;
 	protected static final int timeSeriesCount;
@@ -56,8 +57,7 @@ public final class Hardware {
 	private static final Hardware local;
 
 	static {
-		boolean gpu = "gpu".equalsIgnoreCase(System.getenv("AR_HARDWARE_PLATFORM")) ||
-				"gpu".equalsIgnoreCase(System.getProperty("AR_HARDWARE_PLATFORM"));
+		boolean gpu = "gpu".equalsIgnoreCase(SystemUtils.getProperty("AR_HARDWARE_PLATFORM"));
 
 		boolean enableKernels = SystemUtils.isEnabled("AR_ENABLE_KERNELS").orElse(true);
 		enableKernelOps = SystemUtils.isEnabled("AR_HARDWARE_KERNEL_OPS").orElse(true);
@@ -66,8 +66,7 @@ public final class Hardware {
 				"enabled".equalsIgnoreCase(System.getenv("AR_HARDWARE_DESTINATION_CONSOLIDATION")) ||
 						"enabled".equalsIgnoreCase(System.getProperty("AR_HARDWARE_DESTINATION_CONSOLIDATION"));
 
-		boolean sp = "32".equalsIgnoreCase(System.getenv("AR_HARDWARE_PRECISION")) ||
-				"32".equalsIgnoreCase(System.getProperty("AR_HARDWARE_PRECISION"));
+		boolean sp = "32".equalsIgnoreCase(SystemUtils.getProperty("AR_HARDWARE_PRECISION"));
 
 		String memScale = System.getProperty("AR_HARDWARE_MEMORY_SCALE");
 		if (memScale == null) memScale = System.getenv("AR_HARDWARE_MEMORY_SCALE");
@@ -77,6 +76,17 @@ public final class Hardware {
 		if (pooling == null) pooling = System.getenv("AR_HARDWARE_MEMORY_MODE");
 		ENABLE_POOLING = "pool".equalsIgnoreCase(pooling);
 
+		String poolBudget = SystemUtils.getProperty("AR_HARDWARE_POOL_BUDGET", "0").trim();
+		long poolBudgetMb = 0;
+
+		try {
+			poolBudgetMb = Math.max(0, Long.parseLong(poolBudget));
+		} catch (NumberFormatException e) {
+			System.out.println("WARN: Ignoring invalid AR_HARDWARE_POOL_BUDGET (" + poolBudget + ")");
+		}
+
+		POOL_BUDGET = poolBudgetMb * 1024L * 1024L;
+
 		String memLocation = System.getProperty("AR_HARDWARE_MEMORY_LOCATION");
 		if (memLocation == null) memLocation = System.getenv("AR_HARDWARE_MEMORY_LOCATION");
 		Location location = Location.DEVICE;
@@ -103,7 +113,7 @@ public final class Hardware {
 		if (memProvider == null) memProvider = "cl";
 		if (memProvider.equalsIgnoreCase("native") || memProvider.equalsIgnoreCase("jvm")) {
 			gpu = false;
-			sp = false;
+			if (memProvider.equalsIgnoreCase("jvm")) sp = false;
 		}
 
 		timeSeriesSize = Optional.ofNullable(tsSize).map(size -> (int) (200000 * Double.parseDouble(size))).orElse(-1);
@@ -197,6 +207,7 @@ public final class Hardware {
 			if (location == CLMemoryProvider.Location.HEAP) System.out.println("Hardware[" + name + "]: Heap RAM enabled");
 			if (location == CLMemoryProvider.Location.HOST) System.out.println("Hardware[" + name + "]: Host RAM enabled");
 			if (ENABLE_POOLING) System.out.println("Hardware[" + name + "]: Pooling enabled");
+			if (POOL_BUDGET > 0) System.out.println("Hardware[" + name + "]: Pool budget is " + POOL_BUDGET / 1024 / 1024 + " Megabytes");
 
 			start(context);
 			contextListeners.forEach(l -> l.contextStarted(context));
@@ -347,6 +358,12 @@ public final class Hardware {
 
 	public int getDefaultPoolSize() { return ENABLE_POOLING ? 6250 * (int) Math.pow(2, MEMORY_SCALE) : -1; }
 
+	/**
+	 * The number of bytes which the {@link org.almostrealism.hardware.mem.MemoryPoolAllocator}
+	 * may reserve for memory that is shared by many {@link MemoryData}s, or zero if it is disabled.
+	 */
+	public long getPoolBudget() { return POOL_BUDGET; }
+
 	public int getTimeSeriesSize() { return (int) timeSeriesSize; }
 
 	public int getTimeSeriesCount() { return timeSeriesCount; }
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware;
+
+import java.util.function.Consumer;
+
+/**
+ * A {@link KernelOperator} is an operator which can be applied over a range of
+ * global ids, as is required for evaluation of a kernel.
+ *
+ * @author  Michael Murray
+ */
+public interface KernelOperator extends Consumer<Object[]> {
+	long getGlobalWorkSize();
+
+	void setGlobalWorkSize(long globalWorkSize);
+
+	long getGlobalWorkOffset();
+
+	void setGlobalWorkOffset(long globalWorkOffset);
+}
@@ -27,6 +27,8 @@ import io.almostrealism.code.ScopeInputManager;
 import io.almostrealism.code.ScopeLifecycle;
 import io.almostrealism.relation.Compactable;
 import org.almostrealism.hardware.computations.Abort;
+import org.almostrealism.hardware.jni.NativeComputeContext;
+import org.almostrealism.hardware.jni.NativeOperationProgram;
 
 import java.util.ArrayList;
 import java.util.List;
@@ -87,6 +89,16 @@ public class OperationList extends ArrayList<Supplier<Runnable>> implements Oper
 					.map(r -> r instanceof OperationAdapter ? (OperationAdapter) r : null)
 					.filter(Objects::nonNull)
 					.forEach(OperationAdapter::compile);
+
+			if (NativeComputeContext.enableGroups) {
+				AcceleratedComputationOperation.deliver(run.stream()
+						.filter(r -> r instanceof AcceleratedComputationOperation)
+						.map(r -> (AcceleratedComputationOperation<?>) r)
+						.collect(Collectors.toList()));
+
+				if (NativeComputeContext.enablePrograms) run = NativeOperationProgram.fuse(run);
+			}
+
 			return new Runner(getMetadata(), run);
 		}
 	}
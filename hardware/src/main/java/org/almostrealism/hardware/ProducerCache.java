@@ -17,9 +17,16 @@
 package org.almostrealism.hardware;
 
 import io.almostrealism.relation.Evaluable;
+import org.almostrealism.io.SystemUtils;
 
+import java.util.ArrayList;
+import java.util.Comparator;
 import java.util.HashMap;
+import java.util.List;
 import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.LongAdder;
 import java.util.function.Supplier;
 
 /**
@@ -29,17 +36,42 @@ import java.util.function.Supplier;
  * at a time, this allows {@link Evaluable} evaluation to be short circuited
  * when the arguments have not changed.
  *
+ * It also keeps the {@link Evaluable} obtained for each {@link Supplier}, so
+ * that it is only compiled once. By default these are shared by all threads,
+ * and when there are more than {@link #evaluableCacheSize} of them the least
+ * recently used are removed, releasing the instructions they were compiled to.
+ * A shared {@link Evaluable} can be evaluated by several threads at once, as
+ * each thread obtains its own operator from the shared instructions, and the
+ * instructions of an {@link Evaluable} which is removed while a thread is
+ * evaluating it are not released until that evaluation has finished.
+ *
  * @author  Michael Murray
  */
 public class ProducerCache {
 	public static boolean enableResultCache = false;
 	public static boolean enableEvaluableCache = true;
 
+	/**
+	 * If false, each {@link Thread} keeps its own {@link Evaluable} for each
+	 * {@link Supplier}, which was the behaviour before they were shared. The
+	 * per thread caches are not bounded.
+	 */
+	public static boolean enableSharedEvaluableCache = SystemUtils.isEnabled("AR_HARDWARE_SHARED_EVALUABLES").orElse(true);
+
+	/** The maximum number of shared {@link Evaluable}s, or zero for no limit. */
+	public static int evaluableCacheSize = Integer.parseInt(SystemUtils.getProperty("AR_HARDWARE_EVALUABLE_CACHE_SIZE", "10000"));
+
 	private static ThreadLocal<Map<Supplier, Object>> resultCache = new ThreadLocal<>();
 	private static ThreadLocal<Map<Supplier, Evaluable>> evaluableCache = new ThreadLocal<>();
+	private static final Map<Supplier, Entry> sharedEvaluableCache = new ConcurrentHashMap<>();
 
 	private static ThreadLocal<Object[]> lastParameter = new ThreadLocal<>();
 
+	private static final AtomicLong clock = new AtomicLong();
+	private static final LongAdder hits = new LongAdder();
+	private static final LongAdder misses = new LongAdder();
+	private static final LongAdder evictions = new LongAdder();
+
 	/**
 	 * This type is not to be instantiated.
 	 */
@@ -69,24 +101,44 @@ public class ProducerCache {
 
 	/**
 	 * This provides a way to obtain an already available {@link Evaluable} for
-	 * the given {@link Supplier}. The {@link Evaluable} is not to be used with
-	 * other {@link Thread}s and callers of this method can be sure that the
-	 * returned {@link Evaluable} will not have been returned for any other
-	 * {@link Thread} than the current one. If an {@link Evaluable} for this
-	 * {@link Thread} has not already been obtained, the {@link Supplier#get()}
-	 * method will be used to obtain one, and it will be kept to later be
-	 * returned by this method if it is called again.
+	 * the given {@link Supplier}. If one has not already been obtained, the
+	 * {@link Supplier#get()} method will be used to obtain one, and it will be
+	 * kept to later be returned by this method if it is called again. When
+	 * {@link #enableSharedEvaluableCache} is set, the same {@link Evaluable}
+	 * is returned to every {@link Thread}, and {@link Supplier#get()} is only
+	 * called once even if several threads request it at the same time.
+	 * Otherwise, callers can be sure that the returned {@link Evaluable} will
+	 * not have been returned for any other {@link Thread} than the current one.
 	 */
 	public static <T> Evaluable<? extends T> getEvaluableForSupplier(Supplier<Evaluable<? extends T>> producer) {
-		if (enableEvaluableCache && !getEvaluableCache().containsKey(producer)) {
+		if (!enableEvaluableCache) return producer.get();
+
+		if (enableSharedEvaluableCache) {
+			Entry entry = sharedEvaluableCache.get(producer);
+
+			if (entry == null) {
+				Entry created = new Entry();
+				entry = sharedEvaluableCache.putIfAbsent(producer, created);
+
+				if (entry == null) {
+					entry = created;
+					if (evaluableCacheSize > 0 && sharedEvaluableCache.size() > evaluableCacheSize) evict();
+				}
+			}
+
+			return (Evaluable<? extends T>) entry.get(producer);
+		}
+
+		if (!getEvaluableCache().containsKey(producer)) {
 			getEvaluableCache().put(producer, producer.get());
 		}
 
-		return enableEvaluableCache ? getEvaluableCache().get(producer) : producer.get();
+		return getEvaluableCache().get(producer);
 	}
 
 	public static <T> void purgeEvaluableCache(Supplier<Evaluable<? extends T>> producer) {
 		if (enableEvaluableCache) {
+			sharedEvaluableCache.remove(producer);
 			getEvaluableCache().remove(producer);
 		}
 	}
@@ -94,11 +146,56 @@ public class ProducerCache {
 	public static void clear() { getResultCache().clear(); }
 
 	public static void destroyEvaluableCache() {
+		sharedEvaluableCache.clear();
 		getEvaluableCache().clear();
 		evaluableCache.remove();
 		evaluableCache = new ThreadLocal<>();
 	}
 
+	/** The number of requests for a shared {@link Evaluable} which was already available. */
+	public static long getHits() { return hits.sum(); }
+
+	/** The number of requests for a shared {@link Evaluable} which required it to be obtained. */
+	public static long getMisses() { return misses.sum(); }
+
+	/** The number of shared {@link Evaluable}s which have been removed to stay within the limit. */
+	public static long getEvictions() { return evictions.sum(); }
+
+	/** The number of shared {@link Evaluable}s. */
+	public static int getEvaluableCacheSize() { return sharedEvaluableCache.size(); }
+
+	/**
+	 * Remove the least recently used tenth of the shared {@link Evaluable}s, so
+	 * that the cost of finding them is shared by many insertions. The removed
+	 * {@link Evaluable}s are released after the lock is released, as releasing
+	 * one requires its own lock, which may be held by a thread that is waiting
+	 * to evict.
+	 */
+	private static void evict() {
+		List<Entry> removed = new ArrayList<>();
+
+		synchronized (ProducerCache.class) {
+			int excess = sharedEvaluableCache.size() - evaluableCacheSize;
+			if (excess <= 0) return;
+
+			List<Map.Entry<Supplier, Entry>> entries = new ArrayList<>(sharedEvaluableCache.entrySet());
+			entries.sort(Comparator.comparingLong(e -> e.getValue().used));
+
+			int count = Math.min(entries.size(), Math.max(excess, evaluableCacheSize / 10));
+
+			for (int i = 0; i < count; i++) {
+				Map.Entry<Supplier, Entry> e = entries.get(i);
+
+				if (sharedEvaluableCache.remove(e.getKey(), e.getValue())) {
+					evictions.increment();
+					removed.add(e.getValue());
+				}
+			}
+		}
+
+		removed.forEach(Entry::release);
+	}
+
 	private static void checkArgs(Object args[]) {
 		if (lastParameter.get() != args) {
 			lastParameter.set(args);
@@ -121,4 +218,46 @@ public class ProducerCache {
 
 		return evaluableCache.get();
 	}
+
+	/**
+	 * A shared {@link Evaluable}, which is obtained by the first thread that
+	 * requests it while any others wait for it to be available.
+	 */
+	private static class Entry {
+		private volatile Evaluable evaluable;
+		private volatile long used = clock.incrementAndGet();
+
+		public Evaluable get(Supplier<? extends Evaluable> producer) {
+			used = clock.incrementAndGet();
+
+			Evaluable e = evaluable;
+			if (e != null) {
+				hits.increment();
+				return e;
+			}
+
+			synchronized (this) {
+				if (evaluable == null) {
+					misses.increment();
+					evaluable = producer.get();
+				} else {
+					hits.increment();
+				}
+
+				return evaluable;
+			}
+		}
+
+		/**
+		 * Release the instructions that the {@link Evaluable} was compiled to,
+		 * once no thread is evaluating it. If it is used again, it will be
+		 * compiled again.
+		 */
+		public void release() {
+			Evaluable e = evaluable;
+			if (e instanceof AcceleratedComputationOperation) {
+				((AcceleratedComputationOperation) e).releaseInstructions();
+			}
+		}
+	}
 }
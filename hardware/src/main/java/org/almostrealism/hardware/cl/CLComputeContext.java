@@ -19,13 +19,16 @@ package org.almostrealism.hardware.cl;
 import io.almostrealism.code.Accessibility;
 import io.almostrealism.code.InstructionSet;
 import io.almostrealism.code.Memory;
+import io.almostrealism.code.OperationMetadata;
 import io.almostrealism.scope.Scope;
 import io.almostrealism.code.ScopeEncoder;
 import org.almostrealism.c.OpenCLPrintWriter;
 import org.almostrealism.hardware.ctx.AbstractComputeContext;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.profile.ProfileData;
+import org.almostrealism.hardware.profile.Profiler;
 import org.almostrealism.hardware.profile.RunData;
+import org.almostrealism.io.SystemUtils;
 import org.jocl.CL;
 import org.jocl.Pointer;
 import org.jocl.Sizeof;
@@ -34,6 +37,7 @@ import org.jocl.cl_context;
 import org.jocl.cl_device_id;
 import org.jocl.cl_event;
 
+import java.io.File;
 import java.util.ArrayList;
 import java.util.Comparator;
 import java.util.HashMap;
@@ -51,10 +55,32 @@ public class CLComputeContext extends AbstractComputeContext {
 	 */
 	public static boolean enableFastQueue = false;
 
+	/**
+	 * If enabled, the host does not wait for each kernel or transfer to complete.
+	 * Instead, every command waits for the events of the earlier commands which
+	 * use the same {@link CLMemory} (see {@link CLMemory#dependencies}), so that
+	 * transfers on the queue of the {@link CLMemoryProvider} overlap with kernels
+	 * on the queues of this context. The host only waits when it reads memory.
+	 * Kernel arguments are all treated as written, since kernels do not declare
+	 * which arguments they assign to.
+	 */
+	public static boolean enableScheduling = SystemUtils.isEnabled("AR_HARDWARE_CL_SCHEDULING").orElse(false);
+
+	/**
+	 * If enabled, and a directory is configured using AR_HARDWARE_CL_CACHE_DIR
+	 * (or AR_HARDWARE_NATIVE_LIBS), the binaries of programs are kept in a
+	 * {@link CLProgramCache} so that they are not built again by later runs.
+	 */
+	public static boolean enableProgramCache = SystemUtils.isEnabled("AR_HARDWARE_CL_CACHE").orElse(true);
+
+	private static CLProgramCache programCache;
+
 	private static final String fp64 = "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
 
 	private boolean enableFp64;
 	private cl_context ctx;
+	private cl_device_id devices[];
+	private List<DeviceInfo> deviceInfo;
 	private cl_command_queue queue;
 	private cl_command_queue fastQueue;
 	private cl_command_queue kernelQueue;
@@ -62,6 +88,7 @@ public class CLComputeContext extends AbstractComputeContext {
 	private Map<String, ProfileData> profiles;
 
 	private List<HardwareOperatorMap> instructionSets;
+	private Map<String, CLProgram> programs;
 
 	public CLComputeContext(Hardware hardware, cl_context ctx) {
 		super(hardware, true, false);
@@ -69,12 +96,16 @@ public class CLComputeContext extends AbstractComputeContext {
 		this.ctx = ctx;
 		this.instructionSets = new ArrayList<>();
 		this.profiles = new HashMap<>();
+		this.programs = new HashMap<>();
 	}
 
 	protected void init(cl_device_id mainDevice, cl_device_id kernelDevice, boolean profiling) {
 		if (queue != null) return;
 
 		this.profiling = profiling;
+		this.devices = kernelDevice == null ? new cl_device_id[] { mainDevice } : new cl_device_id[] { mainDevice, kernelDevice };
+		this.deviceInfo = new ArrayList<>();
+		for (cl_device_id d : devices) deviceInfo.add(new DeviceInfo(d));
 
 		queue = CL.clCreateCommandQueue(ctx, mainDevice, profiling ? CL.CL_QUEUE_PROFILING_ENABLE : 0, null);
 		if (Hardware.enableVerbose) System.out.println("Hardware[" + getName() + "]: OpenCL command queue initialized");
@@ -105,6 +136,63 @@ public class CLComputeContext extends AbstractComputeContext {
 		return instSet;
 	}
 
+	/**
+	 * Obtain a built {@link CLProgram} for the specified source. Programs are
+	 * shared by every {@link HardwareOperatorMap} of this context with the same
+	 * source, and when the {@link CLProgramCache} is available they are created
+	 * from the binaries of an earlier build rather than compiled from source.
+	 */
+	protected synchronized CLProgram program(OperationMetadata metadata, String src) {
+		CLProgram prog = programs.get(src);
+		if (prog != null && prog.retain()) return prog;
+
+		prog = build(metadata, src);
+		programs.put(src, prog);
+		return prog;
+	}
+
+	/**
+	 * Release one use of the specified {@link CLProgram}, which must have been
+	 * obtained from {@link #program(OperationMetadata, String)}. When it has no
+	 * more users, it is no longer kept for sharing.
+	 */
+	protected synchronized void release(CLProgram prog) {
+		prog.destroy();
+		if (prog.isDestroyed()) programs.remove(prog.getSource(), prog);
+	}
+
+	private CLProgram build(OperationMetadata metadata, String src) {
+		CLProgramCache cache = devices == null ? null : getProgramCache();
+		String key = cache == null ? null : cache.key(src, deviceInfo);
+		byte binaries[][] = key == null ? null : cache.restore(key);
+
+		if (binaries != null) {
+			CLProgram prog = null;
+
+			try {
+				prog = CLProgram.create(this, metadata, src, devices, binaries);
+				prog.compile();
+				return prog;
+			} catch (RuntimeException e) {
+				if (Hardware.enableVerbose)
+					System.out.println("Hardware[" + getName() + "]: Unable to use cached program (" + e.getMessage() + ")");
+				if (prog != null) prog.destroy();
+			}
+		}
+
+		CLProgram prog = CLProgram.create(this, metadata, src);
+
+		try {
+			prog.compile();
+		} catch (RuntimeException e) {
+			prog.destroy();
+			throw e;
+		}
+
+		if (key != null) cache.store(key, prog.getBinaries());
+		return prog;
+	}
+
 	@Override
 	public boolean isKernelSupported() { return true; }
 
@@ -121,13 +209,22 @@ public class CLComputeContext extends AbstractComputeContext {
 	public cl_command_queue getKernelClQueue() { return kernelQueue == null ? getClQueue() : kernelQueue; }
 
 	protected Consumer<RunData> profileFor(String name) {
-		if (!profiles.containsKey(name)) profiles.put(name, new ProfileData());
-		return profiles.get(name)::addRun;
+		ProfileData data = profiles.computeIfAbsent(name, n -> Profiler.get(Profiler.Category.CL, n));
+
+		return run -> {
+			data.addRun(run);
+			Profiler.event(Profiler.Category.CL, name, run.getDurationNanos(), run.getBytes());
+		};
 	}
 
 	protected void processEvent(cl_event event) { processEvent(event, null); }
 
 	protected void processEvent(cl_event event, Consumer<RunData> profile) {
+		if (enableScheduling && !profiling) {
+			CL.clReleaseEvent(event);
+			return;
+		}
+
 		CL.clWaitForEvents(1, new cl_event[] { event });
 
 		if (profiling && profile != null) {
@@ -181,6 +278,7 @@ public class CLComputeContext extends AbstractComputeContext {
 	public void destroy() {
 		if (profiling) logProfiles();
 		this.instructionSets.forEach(InstructionSet::destroy);
+		this.programs.clear();
 		if (queue != null) CL.clReleaseCommandQueue(queue);
 		if (fastQueue != null) CL.clReleaseCommandQueue(fastQueue);
 		if (kernelQueue != null) CL.clReleaseCommandQueue(kernelQueue);
@@ -188,4 +286,19 @@ public class CLComputeContext extends AbstractComputeContext {
 		fastQueue = null;
 		kernelQueue = null;
 	}
+
+	protected static synchronized CLProgramCache getProgramCache() {
+		if (!enableProgramCache) return null;
+
+		if (programCache == null) {
+			String libDir = SystemUtils.getProperty("AR_HARDWARE_NATIVE_LIBS");
+			String cacheDir = SystemUtils.getProperty("AR_HARDWARE_CL_CACHE_DIR", libDir == null ? null : libDir + "/cl-cache");
+			if (cacheDir == null) return null;
+
+			long cacheSize = Long.parseLong(SystemUtils.getProperty("AR_HARDWARE_CL_CACHE_SIZE", "256"));
+			programCache = new CLProgramCache(new File(cacheDir), cacheSize * 1024L * 1024L);
+		}
+
+		return programCache;
+	}
 }
@@ -62,9 +62,7 @@ public class CLJNIPrintWriter extends CJNIPrintWriter {
 	}
 
 	protected void renderArgumentReads(List<ArrayVariable<?>> arguments) {
-		println(new Variable<>("*argArr", long[].class, "(*env)->GetLongArrayElements(env, arg, 0)"));
-		println(new Variable<>("*offsetArr", int[].class, "(*env)->GetIntArrayElements(env, offset, 0)"));
-		println(new Variable<>("*sizeArr", int[].class, "(*env)->GetIntArrayElements(env, size, 0)"));
+		renderArgumentArrays();
 
 		String numberType = Hardware.getLocalHardware().getNumberTypeName();
 		int numberSize = Hardware.getLocalHardware().getNumberSize();
@@ -17,17 +17,35 @@
 package org.almostrealism.hardware.cl;
 
 import org.almostrealism.hardware.RAM;
+import org.jocl.CL;
+import org.jocl.Pointer;
+import org.jocl.Sizeof;
+import org.jocl.cl_event;
 import org.jocl.cl_mem;
 
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * A {@link cl_mem} buffer. When {@link CLComputeContext#enableScheduling} is
+ * enabled, commands that use the buffer are not waited for by the host. Instead,
+ * the {@link CLMemory} records the event of the last command which wrote to it and
+ * the events of the commands which have read from it since, so that each new
+ * command can wait for exactly the commands it depends on.
+ */
 public class CLMemory extends RAM {
 	private final cl_mem mem;
 	private final long size;
 	private final CLMemoryProvider provider;
 
+	private cl_event lastWrite;
+	private List<cl_event> reads;
+
 	protected CLMemory(CLMemoryProvider provider, cl_mem mem, long size) {
 		this.provider = provider;
 		this.mem = mem;
 		this.size = size;
+		this.reads = new ArrayList<>();
 	}
 
 	protected cl_mem getMem() { return mem; }
@@ -41,4 +59,77 @@ public class CLMemory extends RAM {
 
 	@Override
 	public CLMemoryProvider getProvider() { return provider; }
+
+	/**
+	 * Add the events that a command using this memory must wait for to the
+	 * specified list. A command which reads must wait for the last write,
+	 * and a command which writes must also wait for all of the reads that
+	 * have happened since. Each event that is added is retained, and must
+	 * be released using {@link #release(List)}.
+	 */
+	protected synchronized void dependencies(List<cl_event> waitList, boolean write) {
+		if (lastWrite != null) add(waitList, lastWrite);
+		if (!write) return;
+
+		for (cl_event e : reads) add(waitList, e);
+	}
+
+	/** Record a command which reads from this memory. */
+	protected synchronized void read(cl_event event) {
+		reads.removeIf(e -> {
+			if (!isComplete(e)) return false;
+			CL.clReleaseEvent(e);
+			return true;
+		});
+
+		CL.clRetainEvent(event);
+		reads.add(event);
+	}
+
+	/** Record a command which writes to this memory, replacing all earlier commands. */
+	protected synchronized void write(cl_event event) {
+		CL.clRetainEvent(event);
+		release();
+		lastWrite = event;
+	}
+
+	/** Wait for every recorded command that uses this memory to complete. */
+	public void await() {
+		List<cl_event> events = new ArrayList<>();
+		dependencies(events, true);
+		if (events.isEmpty()) return;
+
+		CL.clWaitForEvents(events.size(), events.toArray(new cl_event[0]));
+		release(events);
+	}
+
+	protected synchronized void release() {
+		if (lastWrite != null) CL.clReleaseEvent(lastWrite);
+		reads.forEach(CL::clReleaseEvent);
+		lastWrite = null;
+		reads.clear();
+	}
+
+	private static void add(List<cl_event> waitList, cl_event event) {
+		if (waitList.contains(event)) return;
+		CL.clRetainEvent(event);
+		waitList.add(event);
+	}
+
+	/** Release the events of a wait list obtained using {@link #dependencies(List, boolean)}. */
+	protected static void release(List<cl_event> waitList) {
+		waitList.forEach(CL::clReleaseEvent);
+		waitList.clear();
+	}
+
+	/** The wait list in the form required to enqueue a command, or null if it is empty. */
+	protected static cl_event[] waitList(List<cl_event> waitList) {
+		return waitList.isEmpty() ? null : waitList.toArray(new cl_event[0]);
+	}
+
+	protected static boolean isComplete(cl_event event) {
+		int status[] = new int[1];
+		CL.clGetEventInfo(event, CL.CL_EVENT_COMMAND_EXECUTION_STATUS, Sizeof.cl_int, Pointer.to(status), null);
+		return status[0] == CL.CL_COMPLETE;
+	}
 }
@@ -20,17 +20,23 @@ import io.almostrealism.code.MemoryProvider;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.HardwareException;
 import org.almostrealism.hardware.RAM;
+import org.almostrealism.hardware.profile.Profiler;
 import org.almostrealism.io.SystemUtils;
 import org.jocl.CL;
 import org.jocl.CLException;
 import org.jocl.Pointer;
+import org.jocl.Sizeof;
 import org.jocl.cl_command_queue;
 import org.jocl.cl_event;
 import org.jocl.cl_mem;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.IdentityHashMap;
 import java.util.List;
+import java.util.Map;
 import java.util.Optional;
 import java.util.stream.IntStream;
 
@@ -52,6 +58,7 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 	private HashMap<cl_mem, PointerAndObject<?>> heap;
 	private List<CLMemory> allocated;
 	private List<RAM> deallocating;
+	private Map<cl_event, ByteBuffer> staging;
 
 	public CLMemoryProvider(CLDataContext context, cl_command_queue queue, int numberSize, long memoryMax, Location location) {
 		this.context = context;
@@ -62,6 +69,7 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 		if (location == Location.HEAP) heap = new HashMap<>();
 		this.allocated = new ArrayList<>();
 		this.deallocating = new ArrayList<>();
+		this.staging = new IdentityHashMap<>();
 	}
 
 	public int getNumberSize() { return numberSize; }
@@ -95,6 +103,7 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 			CLMemory mem = (CLMemory) ram;
 
 			if (heap != null) heap.remove(mem.getMem());
+			mem.release();
 			CL.clReleaseMemObject(mem.getMem());
 			memoryUsed = memoryUsed - (long) size * getNumberSize();
 
@@ -135,9 +144,25 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 
 	@Override
 	public void setMem(RAM ram, int offset, double[] source, int srcOffset, int length) {
+		long start = Profiler.start();
+		write(ram, offset, source, srcOffset, length);
+		Profiler.record(Profiler.Category.TRANSFER, "write", start, (long) length * getNumberSize());
+	}
+
+	private void write(RAM ram, int offset, double[] source, int srcOffset, int length) {
 		if (!(ram instanceof CLMemory)) throw new IllegalArgumentException();
 		CLMemory mem = (CLMemory) ram;
 
+		if (CLComputeContext.enableScheduling) {
+			try {
+				writeAsync(mem, offset, source, srcOffset, length);
+			} catch (CLException e) {
+				throw CLExceptionProcessor.process(e, this, srcOffset, offset, length);
+			}
+
+			return;
+		}
+
 		try {
 			if (Hardware.getLocalHardware().isDoublePrecision()) {
 				Pointer src = Pointer.to(source).withByteOffset((long) srcOffset * getNumberSize());
@@ -170,12 +195,28 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 		CLMemory src = (CLMemory) srcRam;
 
 		try {
+			List<cl_event> waitList = new ArrayList<>();
+
+			if (CLComputeContext.enableScheduling) {
+				mem.dependencies(waitList, true);
+				src.dependencies(waitList, false);
+			}
+
 			cl_event event = new cl_event();
 			CL.clEnqueueCopyBuffer(queue, src.getMem(), mem.getMem(),
 						(long) srcOffset * getNumberSize(),
 						(long) offset * getNumberSize(), (long) length * getNumberSize(),
-						0, null, event);
-			processEvent(event);
+						waitList.size(), CLMemory.waitList(waitList), event);
+			CLMemory.release(waitList);
+
+			if (CLComputeContext.enableScheduling) {
+				mem.write(event);
+				src.read(event);
+				CL.clReleaseEvent(event);
+				CL.clFlush(queue);
+			} else {
+				processEvent(event);
+			}
 		} catch (CLException e) {
 			throw CLExceptionProcessor.process(e, this, srcOffset, offset, length);
 		}
@@ -184,10 +225,18 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 	@Override
 	public void getMem(RAM mem, int sOffset, double out[], int oOffset, int length) {
 		if (!(mem instanceof CLMemory)) throw new IllegalArgumentException();
+
+		long start = Profiler.start();
 		getMem((CLMemory) mem, sOffset, out, oOffset, length, 1);
+		Profiler.record(Profiler.Category.TRANSFER, "read", start, (long) length * getNumberSize());
 	}
 
 	private void getMem(CLMemory mem, int sOffset, double out[], int oOffset, int length, int retries) {
+		if (CLComputeContext.enableScheduling) {
+			// This is a sync point, so every command that writes to the memory must complete first
+			mem.await();
+		}
+
 		try {
 			IntStream.range(0, retries).mapToObj(r -> getHeapData(mem)).forEach(heapObj -> {
 				if (heapObj instanceof float[]) {
@@ -224,6 +273,48 @@ public class CLMemoryProvider implements MemoryProvider<RAM> {
 		}
 	}
 
+	/**
+	 * Enqueue a write of the specified values without waiting for it to complete.
+	 * The values are copied to a direct buffer, which is kept until the write has
+	 * completed, and the write waits only for the commands which use the memory.
+	 * When the write completes, the buffer and the event are released by the
+	 * callback of the event.
+	 */
+	private void writeAsync(CLMemory mem, int offset, double[] source, int srcOffset, int length) {
+		ByteBuffer buf = ByteBuffer.allocateDirect(length * getNumberSize()).order(ByteOrder.nativeOrder());
+
+		if (getNumberSize() == 8) {
+			buf.asDoubleBuffer().put(source, srcOffset, length);
+		} else {
+			for (int i = 0; i < length; i++) buf.putFloat(i * Sizeof.cl_float, (float) source[srcOffset + i]);
+		}
+
+		List<cl_event> waitList = new ArrayList<>();
+		mem.dependencies(waitList, true);
+
+		cl_event event = new cl_event();
+		CL.clEnqueueWriteBuffer(queue, mem.getMem(), CL.CL_FALSE,
+				(long) offset * getNumberSize(), (long) length * getNumberSize(),
+				Pointer.to(buf), waitList.size(), CLMemory.waitList(waitList), event);
+		CLMemory.release(waitList);
+		mem.write(event);
+
+		synchronized (staging) {
+			staging.put(event, buf);
+		}
+
+		// The callback may be invoked immediately if the write has already completed
+		CL.clSetEventCallback(event, CL.CL_COMPLETE, (e, status, data) -> {
+			synchronized (staging) {
+				staging.remove(event);
+			}
+
+			CL.clReleaseEvent(event);
+		}, null);
+
+		CL.clFlush(queue);
+	}
+
 	private void processEvent(cl_event event) {
 		CL.clWaitForEvents(1, new cl_event[] { event });
 		CL.clReleaseEvent(event);
@@ -22,6 +22,8 @@ import io.almostrealism.scope.Scope;
 import io.almostrealism.code.ScopeEncoder;
 import org.almostrealism.hardware.ctx.AbstractComputeContext;
 import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.jni.AsyncInstructionSet;
+import org.almostrealism.hardware.jni.NativeComputeContext;
 import org.almostrealism.hardware.jni.NativeInstructionSet;
 
 public class CLNativeComputeContext extends AbstractComputeContext {
@@ -37,6 +39,11 @@ public class CLNativeComputeContext extends AbstractComputeContext {
 		StringBuffer buf = new StringBuffer();
 		NativeInstructionSet target = getComputer().getNativeCompiler().reserveLibraryTarget();
 		buf.append(new ScopeEncoder(pw -> new CLJNIPrintWriter(pw, target.getFunctionName()), Accessibility.EXTERNAL).apply(scope));
+
+		if (NativeComputeContext.enableAsync) {
+			return new AsyncInstructionSet(target, getComputer().getNativeCompiler().compileAsync(target, buf.toString()));
+		}
+
 		getComputer().getNativeCompiler().compile(target, buf.toString());
 		return target;
 	}
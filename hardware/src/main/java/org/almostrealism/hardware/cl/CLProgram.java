@@ -20,17 +20,28 @@ import io.almostrealism.code.OperationMetadata;
 import org.almostrealism.hardware.HardwareException;
 import org.jocl.CL;
 import org.jocl.CLException;
+import org.jocl.Pointer;
+import org.jocl.Sizeof;
+import org.jocl.cl_device_id;
 import org.jocl.cl_program;
 
+/**
+ * Wrapper for a {@link cl_program}, which may be shared by several
+ * {@link HardwareOperatorMap}s with identical source. Each user other
+ * than the first must {@link #retain()} the program, and the program
+ * is released when all of its users have called {@link #destroy()}.
+ */
 public class CLProgram {
 	private cl_program prog;
 	private final OperationMetadata metadata;
 	private final String src;
+	private int references;
 
 	private CLProgram(cl_program prog, OperationMetadata metadata, String src) {
 		this.prog = prog;
 		this.metadata = metadata;
 		this.src = src;
+		this.references = 1;
 	}
 
 	public cl_program getProgram() {
@@ -53,7 +64,43 @@ public class CLProgram {
 		}
 	}
 
-	public void destroy() {
+	/**
+	 * Returns the binary for each device the program was built for, in the
+	 * order of the devices of the context.
+	 */
+	public byte[][] getBinaries() {
+		int count[] = new int[1];
+		CL.clGetProgramInfo(prog, CL.CL_PROGRAM_NUM_DEVICES, Sizeof.cl_uint, Pointer.to(count), null);
+
+		long sizes[] = new long[count[0]];
+		CL.clGetProgramInfo(prog, CL.CL_PROGRAM_BINARY_SIZES, (long) count[0] * Sizeof.size_t, Pointer.to(sizes), null);
+
+		byte binaries[][] = new byte[count[0]][];
+		Pointer pointers[] = new Pointer[count[0]];
+
+		for (int i = 0; i < binaries.length; i++) {
+			binaries[i] = new byte[(int) sizes[i]];
+			pointers[i] = Pointer.to(binaries[i]);
+		}
+
+		CL.clGetProgramInfo(prog, CL.CL_PROGRAM_BINARIES, (long) count[0] * Sizeof.POINTER, Pointer.to(pointers), null);
+		return binaries;
+	}
+
+	/**
+	 * Add a user of this program, returning false if the program
+	 * has already been released.
+	 */
+	public synchronized boolean retain() {
+		if (prog == null) return false;
+		references++;
+		return true;
+	}
+
+	public synchronized boolean isDestroyed() { return prog == null; }
+
+	public synchronized void destroy() {
+		if (prog == null || --references > 0) return;
 		CL.clReleaseProgram(prog);
 		prog = null;
 	}
@@ -65,4 +112,26 @@ public class CLProgram {
 
 		return new CLProgram(prog, metadata, src);
 	}
+
+	/**
+	 * Create a program from binaries which were previously obtained using
+	 * {@link #getBinaries()}, for the specified devices. The program must
+	 * still be {@link #compile() built} before it is used.
+	 */
+	public static CLProgram create(CLComputeContext h, OperationMetadata metadata, String src,
+								   cl_device_id devices[], byte binaries[][]) {
+		if (devices.length != binaries.length) {
+			throw new IllegalArgumentException(binaries.length + " binaries for " + devices.length + " devices");
+		}
+
+		long lengths[] = new long[binaries.length];
+		for (int i = 0; i < lengths.length; i++) lengths[i] = binaries[i].length;
+
+		int status[] = new int[binaries.length];
+		int[] result = new int[1];
+		cl_program prog = CL.clCreateProgramWithBinary(h.getCLContext(), devices.length, devices, lengths, binaries, status, result);
+		if (result[0] != 0) throw new RuntimeException("Error creating HardwareOperatorMap from binary: " + result[0]);
+
+		return new CLProgram(prog, metadata, src);
+	}
 }
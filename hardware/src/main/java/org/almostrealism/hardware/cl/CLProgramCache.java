@@ -0,0 +1,158 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.cl;
+
+import org.almostrealism.hardware.HardwareException;
+
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.StandardCopyOption;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.List;
+
+/**
+ * A persistent cache of the binaries produced when a {@link CLProgram} is built,
+ * so that a program which was built by an earlier run for the same devices does
+ * not need to be compiled by the driver again. Entries are identified by a hash
+ * of the source and the {@link DeviceInfo#getIdentity() identity} of each device,
+ * which includes the driver version, so that a driver update invalidates them.
+ * When the total size of the cache exceeds its limit, the least recently used
+ * entries are removed.
+ */
+public class CLProgramCache {
+	public static boolean enableVerbose = false;
+
+	private final File dir;
+	private final long maxSize;
+
+	public CLProgramCache(File dir, long maxSize) {
+		this.dir = dir;
+		this.maxSize = maxSize;
+		if (!dir.exists()) dir.mkdirs();
+	}
+
+	public File getDirectory() { return dir; }
+
+	/**
+	 * Compute the key for the specified source, built for the specified devices.
+	 */
+	public String key(String source, List<DeviceInfo> devices) {
+		try {
+			MessageDigest digest = MessageDigest.getInstance("SHA-256");
+			digest.update(source.getBytes(StandardCharsets.UTF_8));
+
+			for (DeviceInfo d : devices) {
+				digest.update((byte) 0);
+				digest.update(d.getIdentity().getBytes(StandardCharsets.UTF_8));
+			}
+
+			StringBuilder key = new StringBuilder();
+			for (byte b : digest.digest()) key.append(String.format("%02x", b));
+			return key.toString();
+		} catch (NoSuchAlgorithmException e) {
+			throw new HardwareException(e.getMessage(), new UnsupportedOperationException(e));
+		}
+	}
+
+	/**
+	 * Returns the binaries, one for each device, stored for the specified key,
+	 * or null if there is no entry for it.
+	 */
+	public byte[][] restore(String key) {
+		File entry = entry(key);
+		if (!entry.isFile()) return null;
+
+		try (DataInputStream in = new DataInputStream(new FileInputStream(entry))) {
+			byte binaries[][] = new byte[in.readInt()][];
+
+			for (int i = 0; i < binaries.length; i++) {
+				binaries[i] = new byte[in.readInt()];
+				in.readFully(binaries[i]);
+			}
+
+			entry.setLastModified(System.currentTimeMillis());
+			if (enableVerbose) System.out.println("CLProgramCache: Restored " + key);
+			return binaries;
+		} catch (IOException e) {
+			if (enableVerbose) System.out.println("CLProgramCache: Unable to restore " + key + " (" + e.getMessage() + ")");
+			return null;
+		}
+	}
+
+	/**
+	 * Store the specified binaries, one for each device, as the entry for the
+	 * specified key, and then remove entries until the cache is within its
+	 * size limit.
+	 */
+	public void store(String key, byte[][] binaries) {
+		File entry = entry(key);
+
+		try {
+			File tmp = File.createTempFile(entry.getName(), ".tmp", dir);
+
+			try {
+				try (DataOutputStream out = new DataOutputStream(new FileOutputStream(tmp))) {
+					out.writeInt(binaries.length);
+
+					for (byte[] b : binaries) {
+						out.writeInt(b.length);
+						out.write(b);
+					}
+				}
+
+				Files.move(tmp.toPath(), entry.toPath(), StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE);
+			} finally {
+				tmp.delete();
+			}
+		} catch (IOException e) {
+			if (enableVerbose) System.out.println("CLProgramCache: Unable to store " + key + " (" + e.getMessage() + ")");
+			return;
+		}
+
+		evict();
+	}
+
+	protected synchronized void evict() {
+		File entries[] = dir.listFiles(File::isFile);
+		if (entries == null) return;
+
+		long size = Arrays.stream(entries).mapToLong(File::length).sum();
+		if (size <= maxSize) return;
+
+		Arrays.sort(entries, Comparator.comparingLong(File::lastModified));
+
+		for (File f : entries) {
+			if (size <= maxSize) break;
+
+			long len = f.length();
+			if (f.delete()) size -= len;
+		}
+	}
+
+	protected File entry(String key) {
+		return new File(dir, key + ".clbin");
+	}
+}
@@ -14,6 +14,10 @@ public class DeviceInfo {
 	private long workGroupSize;
 	private long maxWorkItemDimensions;
 	private long maxConstantArgs;
+	private String name;
+	private String vendor;
+	private String version;
+	private String driverVersion;
 
 	public DeviceInfo(cl_device_id device) {
 		this(readLong(device, CL.CL_DEVICE_MAX_COMPUTE_UNITS),
@@ -23,11 +27,22 @@ public class DeviceInfo {
 				readLong(device, CL.CL_DEVICE_MAX_MEM_ALLOC_SIZE),
 				readLong(device, CL.CL_DEVICE_MAX_WORK_GROUP_SIZE),
 				readLong(device, CL.CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS),
-				readLong(device, CL.CL_DEVICE_MAX_CONSTANT_ARGS));
+				readLong(device, CL.CL_DEVICE_MAX_CONSTANT_ARGS),
+				readString(device, CL.CL_DEVICE_NAME),
+				readString(device, CL.CL_DEVICE_VENDOR),
+				readString(device, CL.CL_DEVICE_VERSION),
+				readString(device, CL.CL_DRIVER_VERSION));
 	}
 
 	public DeviceInfo(long cores, long clockMhz, long globalMem, long localMem, long maxAlloc,
 					  long workGroupSize, long maxWorkItemDimensions, long maxConstantArgs) {
+		this(cores, clockMhz, globalMem, localMem, maxAlloc, workGroupSize, maxWorkItemDimensions, maxConstantArgs,
+				null, null, null, null);
+	}
+
+	public DeviceInfo(long cores, long clockMhz, long globalMem, long localMem, long maxAlloc,
+					  long workGroupSize, long maxWorkItemDimensions, long maxConstantArgs,
+					  String name, String vendor, String version, String driverVersion) {
 		this.cores = cores;
 		this.clockMhz = clockMhz;
 		this.globalMem = globalMem;
@@ -36,6 +51,10 @@ public class DeviceInfo {
 		this.workGroupSize = workGroupSize;
 		this.maxWorkItemDimensions = maxWorkItemDimensions;
 		this.maxConstantArgs = maxConstantArgs;
+		this.name = name;
+		this.vendor = vendor;
+		this.version = version;
+		this.driverVersion = driverVersion;
 	}
 
 	public long getCores() {
@@ -70,9 +89,34 @@ public class DeviceInfo {
 		return maxConstantArgs;
 	}
 
+	public String getName() { return name; }
+
+	public String getVendor() { return vendor; }
+
+	public String getVersion() { return version; }
+
+	public String getDriverVersion() { return driverVersion; }
+
+	/**
+	 * A description of the device and the driver, which identifies the
+	 * compiler that will be used to build programs for the device.
+	 */
+	public String getIdentity() {
+		return vendor + "/" + name + "/" + version + "/" + driverVersion;
+	}
+
 	private static long readLong(cl_device_id device, int param) {
 		long[] value = new long[1];
 		CL.clGetDeviceInfo(device, param, Sizeof.cl_long, Pointer.to(value), null);
 		return value[0];
 	}
+
+	private static String readString(cl_device_id device, int param) {
+		long[] size = new long[1];
+		CL.clGetDeviceInfo(device, param, 0, null, size);
+
+		byte[] value = new byte[(int) size[0]];
+		CL.clGetDeviceInfo(device, param, value.length, Pointer.to(value), null);
+		return new String(value, 0, Math.max(0, value.length - 1));
+	}
 }
@@ -19,10 +19,13 @@ package org.almostrealism.hardware.cl;
 import io.almostrealism.relation.Factory;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.HardwareException;
+import org.almostrealism.hardware.KernelOperator;
 import org.almostrealism.hardware.MemoryData;
 import org.almostrealism.hardware.profile.RunData;
 import org.jocl.*;
 
+import java.util.ArrayList;
+import java.util.List;
 import java.util.function.BiFunction;
 import java.util.function.Consumer;
 
@@ -31,7 +34,7 @@ import java.util.function.Consumer;
  *
  * @param <T> Return type
  */
-public class HardwareOperator<T extends MemoryData> implements Consumer<Object[]>, Factory<cl_kernel> {
+public class HardwareOperator<T extends MemoryData> implements KernelOperator, Factory<cl_kernel> {
 	public static boolean enableLog;
 	public static boolean enableVerboseLog;
 
@@ -69,12 +72,16 @@ public class HardwareOperator<T extends MemoryData> implements Consumer<Object[]
 		}
 	}
 
+	@Override
 	public long getGlobalWorkSize() { return globalWorkSize; }
 
+	@Override
 	public void setGlobalWorkSize(long globalWorkSize) { this.globalWorkSize = globalWorkSize; }
 
+	@Override
 	public long getGlobalWorkOffset() { return globalWorkOffset; }
 
+	@Override
 	public void setGlobalWorkOffset(long globalWorkOffset) { this.globalWorkOffset = globalWorkOffset; }
 
 	/**
@@ -94,6 +101,7 @@ public class HardwareOperator<T extends MemoryData> implements Consumer<Object[]
 		}
 
 		long totalSize = 0;
+		List<CLMemory> memory = new ArrayList<>();
 
 		try {
 			for (int i = 0; i < argCount; i++) {
@@ -114,6 +122,7 @@ public class HardwareOperator<T extends MemoryData> implements Consumer<Object[]
 				}
 
 				CLMemory mem = (CLMemory) ((MemoryData) args[i]).getMem();
+				if (!memory.contains(mem)) memory.add(mem);
 				totalSize += mem.getSize();
 				CL.clSetKernelArg(kernel, index++, Sizeof.cl_mem, Pointer.to(((CLMemory) ((MemoryData) args[i]).getMem()).getMem()));
 			}
@@ -135,10 +144,23 @@ public class HardwareOperator<T extends MemoryData> implements Consumer<Object[]
 
 		try {
 			if (enableVerboseLog) System.out.println(id + ": clEnqueueNDRangeKernel start");
+			List<cl_event> waitList = new ArrayList<>();
+			if (CLComputeContext.enableScheduling) memory.forEach(m -> m.dependencies(waitList, true));
+
+			cl_command_queue queue = Hardware.getLocalHardware().getClComputeContext().getClQueue(globalWorkSize > 1);
 			cl_event event = new cl_event();
-			CL.clEnqueueNDRangeKernel(Hardware.getLocalHardware().getClComputeContext().getClQueue(globalWorkSize > 1), kernel, 1,
+			CL.clEnqueueNDRangeKernel(queue, kernel, 1,
 					new long[] { globalWorkOffset }, new long[] { globalWorkSize },
-					null, 0, null, event);
+					null, waitList.size(), CLMemory.waitList(waitList), event);
+			CLMemory.release(waitList);
+
+			if (CLComputeContext.enableScheduling) {
+				memory.forEach(m -> m.write(event));
+
+				// Commands on other queues may wait for this one, so it must be submitted
+				CL.clFlush(queue);
+			}
+
 			Hardware.getLocalHardware().getClComputeContext().processEvent(event, profile);
 			if (enableVerboseLog) System.out.println(id + ": clEnqueueNDRangeKernel end");
 		} catch (CLException e) {
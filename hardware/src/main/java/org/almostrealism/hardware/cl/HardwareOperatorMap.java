@@ -38,6 +38,7 @@ import java.util.function.Consumer;
  * @author  Michael Murray
  */
 public class HardwareOperatorMap<T extends MemoryData> implements InstructionSet, BiFunction<String, CLException, HardwareException> {
+	private CLComputeContext context;
 	private CLProgram prog;
 
 	private ThreadLocal<Map<String, HardwareOperator<T>>> operators;
@@ -61,12 +62,11 @@ public class HardwareOperatorMap<T extends MemoryData> implements InstructionSet
 			System.out.println(src);
 		}
 
-		prog = CLProgram.create(h, metadata, src);
-
 		RuntimeException ex = null;
+		context = h;
 
 		try {
-			prog.compile();
+			prog = h.program(metadata, src);
 		} catch (RuntimeException e) {
 			ex = e;
 		}
@@ -120,11 +120,14 @@ public class HardwareOperatorMap<T extends MemoryData> implements InstructionSet
 	 * that stores the {@link HardwareOperator}s, destroying all
 	 * {@link HardwareOperator}s in the process.
 	 *
-	 * @see  CLProgram#destroy()
+	 * @see  CLComputeContext#release(CLProgram)
 	 * @see  HardwareOperator#destroy()
 	 */
 	public void destroy() {
-		if (prog != null) prog.destroy();
+		if (prog != null) {
+			context.release(prog);
+			prog = null;
+		}
 
 		if (operators != null) {
 			operators.remove();
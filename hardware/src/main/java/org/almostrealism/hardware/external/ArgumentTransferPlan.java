@@ -0,0 +1,148 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import io.almostrealism.code.Memory;
+import org.almostrealism.hardware.MemoryData;
+
+import java.util.ArrayList;
+import java.util.Comparator;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * An {@link ArgumentTransferPlan} determines which values need to be shipped to an
+ * external executable for a set of arguments. Arguments that share the same root
+ * {@link Memory} are grouped, and only the union of the ranges they touch is
+ * transferred, as a series of blocks. Arguments with overlapping ranges share a
+ * block, so that they alias each other in the executable just as they do in the
+ * original {@link Memory}. After execution, only the arguments which are known to
+ * be altered are copied back.
+ *
+ * @author  Michael Murray
+ */
+public class ArgumentTransferPlan {
+	private final MemoryData args[];
+	private final boolean altered[];
+
+	private final int blockIndex[];
+	private final int relativeOffsets[];
+
+	private final List<Memory> blockMemory;
+	private final List<Integer> blockStart;
+	private final List<Integer> blockLength;
+
+	/**
+	 * Create a plan for the specified arguments.
+	 *
+	 * @param args  The arguments that will be provided to the executable.
+	 * @param altered  Flags indicating which arguments may be assigned to, or
+	 *                 null if any of the arguments may be assigned to.
+	 */
+	public ArgumentTransferPlan(MemoryData args[], boolean altered[]) {
+		this.args = args;
+		this.altered = altered;
+		this.blockIndex = new int[args.length];
+		this.relativeOffsets = new int[args.length];
+		this.blockMemory = new ArrayList<>();
+		this.blockStart = new ArrayList<>();
+		this.blockLength = new ArrayList<>();
+		init();
+	}
+
+	protected void init() {
+		Map<Memory, List<Integer>> groups = new IdentityHashMap<>();
+		List<Memory> order = new ArrayList<>();
+
+		for (int i = 0; i < args.length; i++) {
+			Memory mem = args[i].getMem();
+			if (!groups.containsKey(mem)) order.add(mem);
+			groups.computeIfAbsent(mem, m -> new ArrayList<>()).add(i);
+		}
+
+		for (Memory mem : order) {
+			List<Integer> members = groups.get(mem);
+			members.sort(Comparator.comparingInt(i -> args[i].getOffset()));
+
+			int start = -1, end = -1;
+
+			for (int i : members) {
+				int offset = args[i].getOffset();
+				int len = args[i].getMemLength();
+
+				if (start < 0 || offset > end) {
+					if (start >= 0) endBlock(mem, start, end);
+					start = offset;
+					end = offset + len;
+				} else {
+					end = Math.max(end, offset + len);
+				}
+
+				blockIndex[i] = blockMemory.size();
+				relativeOffsets[i] = offset - start;
+			}
+
+			if (start >= 0) endBlock(mem, start, end);
+		}
+	}
+
+	private void endBlock(Memory mem, int start, int end) {
+		blockMemory.add(mem);
+		blockStart.add(start);
+		blockLength.add(end - start);
+	}
+
+	public int getCount() { return args.length; }
+
+	public int getBlockCount() { return blockMemory.size(); }
+
+	/** The index of the block which contains the specified argument. */
+	public int getBlockIndex(int arg) { return blockIndex[arg]; }
+
+	/** The offset of the specified argument, relative to the start of its block. */
+	public int getRelativeOffset(int arg) { return relativeOffsets[arg]; }
+
+	public int getSize(int arg) { return args[arg].getMemLength(); }
+
+	public int getAtomicSize(int arg) { return args[arg].getAtomicMemLength(); }
+
+	public int getBlockLength(int block) { return blockLength.get(block); }
+
+	/** The total number of values that will be transferred to the executable. */
+	public long getTransferLength() {
+		return blockLength.stream().mapToLong(Integer::longValue).sum();
+	}
+
+	public boolean isAltered(int arg) { return altered == null || arg >= altered.length || altered[arg]; }
+
+	/**
+	 * Copy the values for the specified block out of the original {@link Memory}.
+	 */
+	public void readBlock(int block, double out[]) {
+		Memory mem = blockMemory.get(block);
+		mem.getProvider().getMem(mem, blockStart.get(block), out, 0, blockLength.get(block));
+	}
+
+	/**
+	 * Copy the values for the specified argument, taken from the data for its
+	 * block, back to the argument.
+	 */
+	public void writeArgument(int arg, double out[]) {
+		args[arg].setMem(0, out, 0, getSize(arg));
+	}
+}
@@ -18,18 +18,40 @@ package org.almostrealism.hardware.external;
 
 import io.almostrealism.code.Accessibility;
 import io.almostrealism.code.InstructionSet;
+import io.almostrealism.scope.ArrayVariable;
 import io.almostrealism.scope.Scope;
 import io.almostrealism.code.ScopeEncoder;
 import org.almostrealism.c.CPrintWriter;
 import org.almostrealism.hardware.ctx.AbstractComputeContext;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.jni.NativeInstructionSet;
+import org.almostrealism.io.SystemUtils;
 
 import java.io.BufferedReader;
 import java.io.IOException;
 import java.io.InputStreamReader;
+import java.util.List;
+import java.util.Queue;
+import java.util.concurrent.ConcurrentLinkedQueue;
 
 public class ExternalComputeContext extends AbstractComputeContext {
+	/**
+	 * If enabled, operations are compiled as CPU kernels, which the external
+	 * wrapper applies over the work range of each invocation using a pool of
+	 * threads (or OpenMP, when the compiler is configured to use it).
+	 */
+	public static boolean enableKernels = SystemUtils.isEnabled("AR_HARDWARE_EXTERNAL_KERNELS").orElse(false);
+
+	/**
+	 * Definitions which allow the generated code to refer to the global id
+	 * in the same way it would for an OpenCL kernel.
+	 */
+	private static final String KERNEL_PRELUDE =
+			"#include <stdint.h>\n" +
+			"#define AR_KERNEL\n" +
+			"static __thread uint64_t ar_global_id;\n" +
+			"#define get_global_id(dim) ar_global_id\n";
+
 	private static final String externalWrapper;
 
 	static {
@@ -50,24 +72,54 @@ public class ExternalComputeContext extends AbstractComputeContext {
 		externalWrapper = buf.toString();
 	}
 
+	private final Queue<ExternalInstructionSet> instructionSets;
+
 	public ExternalComputeContext(Hardware hardware) {
 		super(hardware, false, true);
+		this.instructionSets = new ConcurrentLinkedQueue<>();
 	}
 
 	@Override
 	public InstructionSet deliver(Scope scope) {
 		StringBuffer buf = new StringBuffer();
 		NativeInstructionSet inst = getComputer().getNativeCompiler().reserveLibraryTarget();
+		if (enableKernels) buf.append(KERNEL_PRELUDE);
 		buf.append(new ScopeEncoder(pw -> new CPrintWriter(pw, "apply"), Accessibility.EXTERNAL).apply(scope));
 		buf.append("\n");
+		buf.append("#define AR_NUMBER " + Hardware.getLocalHardware().getNumberTypeName() + "\n");
 		buf.append(externalWrapper);
 		String executable = getComputer().getNativeCompiler().getLibraryDirectory() + "/" + getComputer().getNativeCompiler().compile(inst.getClass().getName(), buf.toString(), false);
-		return new ExternalInstructionSet(executable, getComputer().getNativeCompiler()::reserveDataDirectory);
+		ExternalInstructionSet instSet = new ExternalInstructionSet(executable,
+				getComputer().getNativeCompiler()::reserveDataDirectory, alteredArguments(scope), enableKernels);
+		instructionSets.removeIf(InstructionSet::isDestroyed);
+		instructionSets.add(instSet);
+		return instSet;
+	}
+
+	/**
+	 * Flags, in the order of the arguments to the generated function, indicating
+	 * which arguments may be assigned to by the specified {@link Scope}.
+	 */
+	protected static boolean[] alteredArguments(Scope<?> scope) {
+		List<ArrayVariable<?>> args = scope.getArgumentVariables();
+		List<ArrayVariable<?>> altered = scope.getAlteredArgumentVariables();
+
+		boolean result[] = new boolean[args.size()];
+		for (int i = 0; i < result.length; i++) {
+			result[i] = altered.contains(args.get(i));
+		}
+
+		return result;
 	}
 
 	@Override
-	public boolean isKernelSupported() { return false; }
+	public boolean isKernelSupported() { return enableKernels; }
 
 	@Override
-	public void destroy() { }
+	public void destroy() {
+		ExternalInstructionSet instSet;
+		while ((instSet = instructionSets.poll()) != null) {
+			instSet.destroy();
+		}
+	}
 }
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import org.almostrealism.hardware.HardwareException;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * The header which begins every binary file exchanged with an external executable.
+ * The header is 8 bytes:
+ *
+ * <pre>
+ *     uint32 magic       ("ARXD", in the byte order of the file)
+ *     uint8  version
+ *     uint8  flags       (bit 0 is set if the file is big endian)
+ *     uint8  numberSize  (4 for fp32 or int32 values, 8 for fp64 values)
+ *     uint8  reserved
+ * </pre>
+ *
+ * The values which follow the header are stored in the byte order and size that it
+ * describes, and files are always written in the native byte order so that neither
+ * side needs to reverse the bytes of each value.
+ *
+ * @author  Michael Murray
+ */
+public class ExternalDataFormat {
+	public static final int MAGIC = 0x41525844;
+	public static final int VERSION = 1;
+	public static final int HEADER_SIZE = 8;
+
+	public static final int FLAG_BIG_ENDIAN = 1;
+
+	private final ByteOrder order;
+	private final int numberSize;
+
+	public ExternalDataFormat(ByteOrder order, int numberSize) {
+		if (numberSize != 4 && numberSize != 8) {
+			throw new IllegalArgumentException("Unsupported number size " + numberSize);
+		}
+
+		this.order = order;
+		this.numberSize = numberSize;
+	}
+
+	public ByteOrder getOrder() { return order; }
+
+	public int getNumberSize() { return numberSize; }
+
+	public boolean isDoublePrecision() { return numberSize == 8; }
+
+	/**
+	 * Write the header to the specified buffer, and set the order of the buffer
+	 * to match the format.
+	 */
+	public void write(ByteBuffer buf) {
+		buf.order(order);
+		buf.putInt(MAGIC);
+		buf.put((byte) VERSION);
+		buf.put((byte) (order == ByteOrder.BIG_ENDIAN ? FLAG_BIG_ENDIAN : 0));
+		buf.put((byte) numberSize);
+		buf.put((byte) 0);
+	}
+
+	/**
+	 * The {@link ExternalDataFormat} for values of the specified size,
+	 * in the native byte order.
+	 */
+	public static ExternalDataFormat nativeFormat(int numberSize) {
+		return new ExternalDataFormat(ByteOrder.nativeOrder(), numberSize);
+	}
+
+	/**
+	 * Read the header from the specified buffer, setting the order of the
+	 * buffer to match the format.
+	 *
+	 * @throws  HardwareException  If the header is not valid.
+	 */
+	public static ExternalDataFormat read(ByteBuffer buf) {
+		if (buf.remaining() < HEADER_SIZE) {
+			throw new HardwareException("External data is missing its header");
+		}
+
+		int flags = buf.get(buf.position() + 5);
+		ByteOrder order = (flags & FLAG_BIG_ENDIAN) != 0 ? ByteOrder.BIG_ENDIAN : ByteOrder.LITTLE_ENDIAN;
+		buf.order(order);
+
+		int magic = buf.getInt();
+		int version = buf.get();
+		buf.get();
+		int numberSize = buf.get();
+		buf.get();
+
+		if (magic != MAGIC) {
+			throw new HardwareException("External data has an invalid header");
+		}
+
+		if (version != VERSION) {
+			throw new HardwareException("Unsupported external data version " + version);
+		}
+
+		return new ExternalDataFormat(order, numberSize);
+	}
+}
@@ -17,8 +17,11 @@
 package org.almostrealism.hardware.external;
 
 import io.almostrealism.code.InstructionSet;
+import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.HardwareException;
 import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.profile.Profiler;
+import org.almostrealism.io.SystemUtils;
 
 import java.io.File;
 import java.io.FileInputStream;
@@ -27,57 +30,274 @@ import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
 import java.nio.ByteBuffer;
+import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.List;
+import java.util.Queue;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.LinkedBlockingQueue;
 import java.util.function.Consumer;
 import java.util.function.Supplier;
+import java.util.stream.Collectors;
 import java.util.stream.IntStream;
 import java.util.stream.Stream;
 
 public class ExternalInstructionSet implements InstructionSet {
+	/**
+	 * If enabled, arguments are exchanged with the executable using a single
+	 * memory mapped file (see {@link MappedExchange}) rather than one file
+	 * per argument.
+	 */
+	public static boolean enableMappedExchange = SystemUtils.isEnabled("AR_HARDWARE_EXTERNAL_MMAP").orElse(false);
+
+	/**
+	 * If enabled, invocations are delivered to resident {@link ExternalWorker}s
+	 * instead of starting a new process for each one. This implies the use of
+	 * {@link MappedExchange}, regardless of {@link #enableMappedExchange}.
+	 */
+	public static boolean enableWorkers = SystemUtils.isEnabled("AR_HARDWARE_EXTERNAL_WORKERS").orElse(false);
+
+	/**
+	 * The maximum number of idle {@link ExternalWorker}s that will be kept
+	 * for each {@link ExternalInstructionSet}.
+	 */
+	public static int maxIdleWorkers = Runtime.getRuntime().availableProcessors();
+
+	/**
+	 * The maximum number of invocations submitted via {@link #submit(Object[], int)}
+	 * which will be coalesced into a single {@link MappedBatch}.
+	 */
+	public static int maxBatchSize = 64;
+
+	/**
+	 * The number of threads the executable will use to apply a {@link MappedBatch}.
+	 */
+	public static int batchThreads = Runtime.getRuntime().availableProcessors();
+
+	private static final ExecutorService dispatcher = Executors.newFixedThreadPool(2, r -> {
+		Thread t = new Thread(r, "ExternalInstructionSet Dispatch");
+		t.setDaemon(true);
+		return t;
+	});
+
 	private String executable;
 	private Supplier<File> dataDirectory;
+	private boolean altered[];
+	private boolean kernel;
+	private BlockingQueue<ExternalWorker> workers;
+	private Queue<Invocation> pending;
+	private volatile boolean destroyed;
 
 	public ExternalInstructionSet(String executable, Supplier<File> dataDirectory) {
+		this(executable, dataDirectory, null);
+	}
+
+	/**
+	 * @param altered  Flags indicating which arguments may be assigned to by the
+	 *                 executable, or null if any of them may be. Arguments which
+	 *                 are not altered are never copied back after execution.
+	 */
+	public ExternalInstructionSet(String executable, Supplier<File> dataDirectory, boolean altered[]) {
+		this(executable, dataDirectory, altered, false);
+	}
+
+	/**
+	 * @param altered  Flags indicating which arguments may be assigned to by the
+	 *                 executable, or null if any of them may be. Arguments which
+	 *                 are not altered are never copied back after execution.
+	 * @param kernel  True if the executable was compiled as a CPU kernel, which
+	 *                can be applied over a range of global ids.
+	 */
+	public ExternalInstructionSet(String executable, Supplier<File> dataDirectory, boolean altered[], boolean kernel) {
 		this.executable = executable;
 		this.dataDirectory = dataDirectory;
+		this.altered = altered;
+		this.kernel = kernel;
+		this.workers = new LinkedBlockingQueue<>(Math.max(1, maxIdleWorkers));
+		this.pending = new ConcurrentLinkedQueue<>();
 	}
 
+	public boolean isKernel() { return kernel; }
+
 	@Override
 	public Consumer<Object[]> get(String function, int argCount) {
-		return args -> {
-			File dest = dataDirectory.get();
+		return new ExternalOperator(this, argCount);
+	}
 
-			try {
-				MemoryData data[] = IntStream.range(0, argCount).mapToObj(i -> (MemoryData) args[i]).toArray(MemoryData[]::new);
+	/**
+	 * Apply the executable to the specified arguments, blocking until the results
+	 * have been copied back to them. The work offset and size are the range of
+	 * global ids, which must be a single id unless this is a kernel.
+	 */
+	protected void apply(Object args[], int argCount, long workOffset, long workSize) {
+		if (!kernel && (workOffset != 0 || workSize > 1)) {
+			throw new HardwareException("Kernel not supported");
+		}
 
-				try {
-					LocalExternalMemoryProvider.writeData(dest, data);
-					LocalExternalMemoryProvider.writeSizes(dest, data);
-					LocalExternalMemoryProvider.writeOffsets(dest, data);
-					LocalExternalMemoryProvider.writeCount(dest, argCount);
-				} catch (IOException e) {
-					throw new HardwareException("Unable to write binary", e);
-				}
+		boolean mapped = kernel || enableMappedExchange || enableWorkers;
+		long start = Profiler.start();
+		MemoryData data[] = toMemoryData(args, argCount);
+		File dest = dataDirectory.get();
 
-				run(dest.getAbsolutePath());
+		try {
+			if (mapped) {
+				MappedExchange exchange;
 
 				try {
-					LocalExternalMemoryProvider.readData(dest, data);
+					exchange = MappedExchange.create(dest, data, altered, workOffset, workSize, kernel);
 				} catch (IOException e) {
-					throw new HardwareException("Unable to read binary", e);
+					throw new HardwareException("Unable to map exchange", e);
+				}
+
+				if (enableWorkers) {
+					run(exchange);
+				} else {
+					run(exchange.getFile().getAbsolutePath(), "mmap");
 				}
-			} finally {
-				deleteData(dest);
+
+				exchange.read();
+				return;
 			}
-		};
+
+			try {
+				LocalExternalMemoryProvider.writeData(dest, data);
+				LocalExternalMemoryProvider.writeSizes(dest, data);
+				LocalExternalMemoryProvider.writeOffsets(dest, data);
+				LocalExternalMemoryProvider.writeCount(dest, argCount);
+			} catch (IOException e) {
+				throw new HardwareException("Unable to write binary", e);
+			}
+
+			run(dest.getAbsolutePath());
+
+			try {
+				LocalExternalMemoryProvider.readData(dest, data, altered);
+			} catch (IOException e) {
+				throw new HardwareException("Unable to read binary", e);
+			}
+		} finally {
+			deleteData(dest, !mapped && LocalExternalMemoryProvider.enableLazyReading);
+			if (start != 0) Profiler.record(Profiler.Category.EXTERNAL, getName(), start, bytes(data));
+		}
+	}
+
+	/**
+	 * Submit an invocation for asynchronous execution. Invocations that are
+	 * pending at the same time are coalesced into a {@link MappedBatch}, which
+	 * is applied by a single run of the executable, using up to
+	 * {@link #batchThreads} threads. Because of this, invocations which are
+	 * submitted together must not depend on the results of one another.
+	 * This applies the executable for a single global id.
+	 *
+	 * @return  A {@link CompletableFuture} which completes when the results of the
+	 *          invocation have been copied back to its arguments.
+	 */
+	public CompletableFuture<Void> submit(Object args[], int argCount) {
+		return submit(args, argCount, 0, 1);
+	}
+
+	/**
+	 * Submit an invocation for asynchronous execution over the specified range
+	 * of global ids, as described by {@link #submit(Object[], int)}. The range
+	 * must be a single id unless this is a kernel.
+	 */
+	public CompletableFuture<Void> submit(Object args[], int argCount, long workOffset, long workSize) {
+		CompletableFuture<Void> future = enqueue(args, argCount, workOffset, workSize);
+		dispatcher.submit(this::dispatch);
+		return future;
 	}
 
-	protected void run(String dir) {
+	/**
+	 * Submit many invocations for asynchronous execution, each for a single
+	 * global id, as described by {@link #submit(Object[], int)}.
+	 *
+	 * @return  A {@link CompletableFuture} which completes when all of the
+	 *          invocations are complete.
+	 */
+	public CompletableFuture<Void> submit(List<Object[]> args, int argCount) {
+		CompletableFuture<Void> futures[] = args.stream()
+				.map(a -> enqueue(a, argCount, 0, 1))
+				.toArray(CompletableFuture[]::new);
+
+		int batches = (futures.length + Math.max(1, maxBatchSize) - 1) / Math.max(1, maxBatchSize);
+		for (int i = 0; i < batches; i++) dispatcher.submit(this::dispatch);
+
+		return CompletableFuture.allOf(futures);
+	}
+
+	private CompletableFuture<Void> enqueue(Object args[], int argCount, long workOffset, long workSize) {
+		if (destroyed) throw new HardwareException("Instruction set has been destroyed");
+		if (!kernel && (workOffset != 0 || workSize > 1)) {
+			throw new HardwareException("Kernel not supported");
+		}
+
+		Invocation inv = new Invocation(toMemoryData(args, argCount), workOffset, workSize);
+		pending.add(inv);
+		return inv.future;
+	}
+
+	protected void dispatch() {
+		List<Invocation> batch = new ArrayList<>();
+
+		Invocation inv;
+		while (batch.size() < Math.max(1, maxBatchSize) && (inv = pending.poll()) != null) {
+			batch.add(inv);
+		}
+
+		if (batch.isEmpty()) return;
+
 		try {
-			long start = System.currentTimeMillis();
-			Process process = new ProcessBuilder(new File(executable).getAbsolutePath(), dir).inheritIO().start();
+			runBatch(batch);
+			batch.forEach(i -> i.future.complete(null));
+		} catch (Throwable e) {
+			batch.forEach(i -> i.future.completeExceptionally(e));
+		}
+	}
+
+	protected void runBatch(List<Invocation> batch) {
+		File dest = dataDirectory.get();
+		long start = Profiler.start();
+
+		try {
+			MappedBatch exchange;
+
+			try {
+				exchange = MappedBatch.create(dest,
+						batch.stream().map(i -> i.args).collect(Collectors.toList()), altered,
+						batch.stream().mapToLong(i -> i.workOffset).toArray(),
+						batch.stream().mapToLong(i -> i.workSize).toArray(), kernel);
+			} catch (IOException e) {
+				throw new HardwareException("Unable to map batch", e);
+			}
+
+			if (enableWorkers) {
+				runWorker(worker -> worker.apply(exchange, batchThreads));
+			} else {
+				run(exchange.getFile().getAbsolutePath(), "batch", String.valueOf(batchThreads));
+			}
+
+			exchange.read();
+		} finally {
+			deleteData(dest, false);
+			if (start != 0) {
+				Profiler.record(Profiler.Category.EXTERNAL, getName() + " (batch)", start,
+						batch.stream().mapToLong(i -> bytes(i.args)).sum());
+			}
+		}
+	}
+
+	protected void run(String... args) {
+		List<String> command = new ArrayList<>();
+		command.add(new File(executable).getAbsolutePath());
+		command.addAll(Arrays.asList(args));
+
+		try {
+			Process process = new ProcessBuilder(command).inheritIO().start();
 			process.waitFor();
-			System.out.println("ExternalInstructionSet: " + (System.currentTimeMillis() - start) + " msec");
 
 			if (process.exitValue() != 0) {
 				throw new HardwareException("Native execution failure (" + process.exitValue() + ")");
@@ -87,9 +307,39 @@ public class ExternalInstructionSet implements InstructionSet {
 		}
 	}
 
-	protected void deleteData(File data) {
-		if (data.isDirectory()) Stream.of(data.listFiles()).forEach(this::deleteData);
-		if (LocalExternalMemoryProvider.enableLazyReading) {
+	/** The name of the executable, which identifies this instruction set to the {@link Profiler}. */
+	public String getName() { return new File(executable).getName(); }
+
+	/** The number of bytes of argument data exchanged with the executable. */
+	private static long bytes(MemoryData data[]) {
+		long len = 0;
+		for (MemoryData d : data) len += d.getMemLength();
+		return len * Hardware.getLocalHardware().getNumberSize();
+	}
+
+	protected void run(MappedExchange exchange) {
+		runWorker(worker -> worker.apply(0, exchange));
+	}
+
+	protected void runWorker(Consumer<ExternalWorker> request) {
+		ExternalWorker worker = workers.poll();
+		if (worker == null || !worker.isAlive()) worker = new ExternalWorker(executable);
+
+		boolean success = false;
+
+		try {
+			request.accept(worker);
+			success = true;
+		} finally {
+			if (!success || destroyed || !workers.offer(worker)) {
+				worker.destroy();
+			}
+		}
+	}
+
+	protected void deleteData(File data, boolean lazy) {
+		if (data.isDirectory()) Stream.of(data.listFiles()).forEach(f -> deleteData(f, lazy));
+		if (lazy) {
 			data.deleteOnExit();
 		} else {
 			data.delete();
@@ -97,8 +347,37 @@ public class ExternalInstructionSet implements InstructionSet {
 	}
 
 	@Override
-	public boolean isDestroyed() { return false; }
+	public boolean isDestroyed() { return destroyed; }
 
 	@Override
-	public void destroy() { }
+	public void destroy() {
+		destroyed = true;
+
+		Invocation inv;
+		while ((inv = pending.poll()) != null) {
+			inv.future.completeExceptionally(new HardwareException("Instruction set has been destroyed"));
+		}
+
+		ExternalWorker worker;
+		while ((worker = workers.poll()) != null) {
+			worker.destroy();
+		}
+	}
+
+	protected static MemoryData[] toMemoryData(Object args[], int argCount) {
+		return IntStream.range(0, argCount).mapToObj(i -> (MemoryData) args[i]).toArray(MemoryData[]::new);
+	}
+
+	protected static class Invocation {
+		private final MemoryData args[];
+		private final long workOffset, workSize;
+		private final CompletableFuture<Void> future;
+
+		Invocation(MemoryData args[], long workOffset, long workSize) {
+			this.args = args;
+			this.workOffset = workOffset;
+			this.workSize = workSize;
+			this.future = new CompletableFuture<>();
+		}
+	}
 }
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import org.almostrealism.hardware.KernelOperator;
+
+/**
+ * An {@link ExternalOperator} applies the executable of an {@link ExternalInstructionSet}
+ * to its arguments. A new {@link ExternalOperator} is provided for each call to
+ * {@link ExternalInstructionSet#get(String, int)}, so the work range can be configured
+ * without affecting any other caller.
+ *
+ * @author  Michael Murray
+ */
+public class ExternalOperator implements KernelOperator {
+	private final ExternalInstructionSet instructions;
+	private final int argCount;
+
+	private long globalWorkSize = 1;
+	private long globalWorkOffset;
+
+	public ExternalOperator(ExternalInstructionSet instructions, int argCount) {
+		this.instructions = instructions;
+		this.argCount = argCount;
+	}
+
+	@Override
+	public long getGlobalWorkSize() { return globalWorkSize; }
+
+	@Override
+	public void setGlobalWorkSize(long globalWorkSize) { this.globalWorkSize = globalWorkSize; }
+
+	@Override
+	public long getGlobalWorkOffset() { return globalWorkOffset; }
+
+	@Override
+	public void setGlobalWorkOffset(long globalWorkOffset) { this.globalWorkOffset = globalWorkOffset; }
+
+	@Override
+	public void accept(Object[] args) {
+		instructions.apply(args, argCount, globalWorkOffset, globalWorkSize);
+	}
+}
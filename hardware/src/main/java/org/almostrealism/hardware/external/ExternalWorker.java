@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import org.almostrealism.hardware.HardwareException;
+
+import java.io.BufferedReader;
+import java.io.BufferedWriter;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStreamWriter;
+
+/**
+ * An {@link ExternalWorker} is a resident instance of an external executable,
+ * started in worker mode, which applies any number of {@link MappedExchange}s
+ * (or {@link MappedBatch}es) without the cost of starting a new process for each one. Requests are sent
+ * over the standard input of the process and results are read from its
+ * standard output. An {@link ExternalWorker} can only process one request at
+ * a time.
+ *
+ * @author  Michael Murray
+ */
+public class ExternalWorker {
+	public static final String RESULT_PREFIX = "ar-worker-result ";
+
+	private final Process process;
+	private final BufferedWriter requests;
+	private final BufferedReader results;
+
+	public ExternalWorker(String executable) {
+		try {
+			process = new ProcessBuilder(new File(executable).getAbsolutePath(), "worker")
+					.redirectError(ProcessBuilder.Redirect.INHERIT)
+					.start();
+		} catch (IOException e) {
+			throw new HardwareException("Unable to start external worker", e);
+		}
+
+		requests = new BufferedWriter(new OutputStreamWriter(process.getOutputStream()));
+		results = new BufferedReader(new InputStreamReader(process.getInputStream()));
+	}
+
+	public boolean isAlive() { return process.isAlive(); }
+
+	/**
+	 * Apply the function with the specified id to the values in the
+	 * specified {@link MappedExchange}, blocking until it is complete.
+	 * Any other output from the executable is forwarded to stdout.
+	 */
+	public void apply(int function, MappedExchange exchange) {
+		request(function + " " + exchange.getFile().getAbsolutePath());
+	}
+
+	/**
+	 * Apply the function to every exchange in the specified {@link MappedBatch},
+	 * using up to the specified number of threads, blocking until all of them
+	 * are complete.
+	 */
+	public void apply(MappedBatch batch, int threads) {
+		request("batch " + threads + " " + batch.getFile().getAbsolutePath());
+	}
+
+	protected synchronized void request(String request) {
+		try {
+			requests.write(request);
+			requests.newLine();
+			requests.flush();
+
+			String line;
+
+			while ((line = results.readLine()) != null) {
+				if (!line.startsWith(RESULT_PREFIX)) {
+					System.out.println(line);
+					continue;
+				}
+
+				int status = Integer.parseInt(line.substring(RESULT_PREFIX.length()).trim());
+
+				if (status != 0) {
+					throw new HardwareException("Native execution failure (" + status + ")");
+				}
+
+				return;
+			}
+		} catch (IOException e) {
+			destroy();
+			throw new HardwareException("Unable to communicate with external worker", e);
+		}
+
+		destroy();
+		throw new HardwareException("External worker terminated unexpectedly");
+	}
+
+	public void destroy() {
+		try {
+			requests.close();
+		} catch (IOException e) {
+			// The worker is already gone
+		}
+
+		process.destroy();
+	}
+}
@@ -50,11 +50,28 @@ public class LocalExternalMemory implements Memory {
 		}
 	}
 
+	/**
+	 * Copy a range of values into the specified array. If the full contents of this
+	 * memory have not been loaded, only the requested range is read from the file.
+	 */
+	public void read(int offset, double out[], int oOffset, int length) {
+		if (data != null) {
+			System.arraycopy(data, offset, out, oOffset, length);
+			return;
+		}
+
+		try {
+			LocalExternalMemoryProvider.readBinary(location, offset, out, oOffset, length);
+		} catch (IOException e) {
+			throw new HardwareException("Unable to retrieve external memory", e);
+		}
+	}
+
 	public void write() {
 		if (data == null) return;
 
 		try {
-			LocalExternalMemoryProvider.writeBinary(location, this, len);
+			LocalExternalMemoryProvider.writeBinary(location, data);
 		} catch (IOException e) {
 			throw new HardwareException("Unable to store external memory", e);
 		}
@@ -18,15 +18,15 @@ package org.almostrealism.hardware.external;
 
 import io.almostrealism.code.Memory;
 import io.almostrealism.code.MemoryProvider;
+import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.MemoryData;
 
 import java.io.File;
-import java.io.FileInputStream;
-import java.io.FileOutputStream;
 import java.io.IOException;
-import java.io.InputStream;
-import java.io.OutputStream;
 import java.nio.ByteBuffer;
+import java.nio.FloatBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.file.StandardOpenOption;
 import java.util.function.Supplier;
 import java.util.stream.Stream;
 
@@ -59,10 +59,8 @@ public class LocalExternalMemoryProvider implements MemoryProvider<Memory> {
 	public void setMem(Memory mem, int offset, Memory source, int srcOffset, int length) {
 		LocalExternalMemory src = (LocalExternalMemory) source;
 		LocalExternalMemory dest = (LocalExternalMemory) mem;
-		load(src, dest);
-		for (int i = 0; i < length; i++) {
-			dest.data[offset + i] = src.data[srcOffset + i];
-		}
+		load(dest);
+		src.read(srcOffset, dest.data, offset, length);
 		unload(dest);
 	}
 
@@ -70,19 +68,13 @@ public class LocalExternalMemoryProvider implements MemoryProvider<Memory> {
 	public void setMem(Memory mem, int offset, double[] source, int srcOffset, int length) {
 		LocalExternalMemory dest = (LocalExternalMemory) mem;
 		load(dest);
-		for (int i = 0; i < length; i++) {
-			dest.data[offset + i] = source[srcOffset + i];
-		}
+		System.arraycopy(source, srcOffset, dest.data, offset, length);
 		unload(dest);
 	}
 
 	@Override
 	public void getMem(Memory mem, int sOffset, double[] out, int oOffset, int length) {
-		LocalExternalMemory src = (LocalExternalMemory) mem;
-		load(src);
-		for (int i = 0; i < length; i++) {
-			out[oOffset + i] = src.data[sOffset + i];
-		}
+		((LocalExternalMemory) mem).read(sOffset, out, oOffset, length);
 	}
 
 	@Override
@@ -99,7 +91,16 @@ public class LocalExternalMemoryProvider implements MemoryProvider<Memory> {
 	}
 
 	protected static void readData(File dest, MemoryData[] args) throws IOException {
+		readData(dest, args, null);
+	}
+
+	/**
+	 * Read the data for each argument, skipping any which are not flagged as
+	 * altered. If the flags are null, the data for all arguments is read.
+	 */
+	protected static void readData(File dest, MemoryData[] args, boolean altered[]) throws IOException {
 		for (int i = 0; i < args.length; i++) {
+			if (altered != null && i < altered.length && !altered[i]) continue;
 			readBinary(new File(dest, String.valueOf(i)), args[i]);
 		}
 	}
@@ -126,44 +127,111 @@ public class LocalExternalMemoryProvider implements MemoryProvider<Memory> {
 		if (enableLazyReading) {
 			mem.getRootDelegate().reassign(local.allocate(src, mem.getRootDelegate().getMemLength()));
 		} else {
+			// The file holds the whole root memory, as written by writeBinary
 			double data[] = new double[mem.getMemLength()];
-			readBinary(src, data);
+			readBinary(src, mem.getOffset(), data, 0, data.length);
 			mem.setMem(data, 0);
 		}
 	}
 
+	/**
+	 * Write the values of the root memory of the specified {@link MemoryData},
+	 * up to the end of its range, so that the generated code can index it
+	 * using the offset of the {@link MemoryData}.
+	 */
 	protected static void writeBinary(File dest, MemoryData mem) throws IOException {
-		writeBinary(dest, mem.getMem(), mem.getMemLength());
+		writeBinary(dest, mem.getMem(), Math.max(mem.getOffset() + mem.getMemLength(), mem.getRootDelegate().getMemLength()));
 	}
 
 	protected static void writeBinary(File dest, Memory mem, int length) throws IOException {
-		writeBinary(dest, mem.getBytes(length).array());
+		double data[] = new double[length];
+		mem.getProvider().getMem(mem, 0, data, 0, length);
+		writeBinary(dest, data);
 	}
 
 	protected static void writeBinary(File dest, int data[]) throws IOException {
-		ByteBuffer buf = ByteBuffer.allocate(data.length * 8);
-		for (int i : data) buf.putInt(i);
-		writeBinary(dest, buf.array());
+		ByteBuffer buf = ByteBuffer.allocateDirect(ExternalDataFormat.HEADER_SIZE + 4 * data.length);
+		ExternalDataFormat.nativeFormat(4).write(buf);
+		buf.asIntBuffer().put(data);
+		buf.position(0);
+		writeBinary(dest, buf);
 	}
 
-	protected static void readBinary(File src, double data[]) throws IOException {
-		ByteBuffer buf = ByteBuffer.allocate(8 * data.length);
-		try (InputStream in = new FileInputStream(src)) {
-			for (int i = 0; i < data.length; i++) {
-				buf.put(in.readNBytes(8));
-			}
+	protected static void writeBinary(File dest, double data[]) throws IOException {
+		ExternalDataFormat format = ExternalDataFormat.nativeFormat(getNumberSize());
+
+		ByteBuffer buf = ByteBuffer.allocateDirect(ExternalDataFormat.HEADER_SIZE + format.getNumberSize() * data.length);
+		format.write(buf);
+
+		if (format.isDoublePrecision()) {
+			buf.asDoubleBuffer().put(data);
+		} else {
+			FloatBuffer out = buf.asFloatBuffer();
+			for (double d : data) out.put((float) d);
 		}
 
 		buf.position(0);
+		writeBinary(dest, buf);
+	}
+
+	protected static void readBinary(File src, double data[]) throws IOException {
+		readBinary(src, 0, data, 0, data.length);
+	}
+
+	/**
+	 * Read the specified number of values from the file, starting at the specified
+	 * offset (in values, not bytes), into the array. Only the requested range of the
+	 * file is read, and any values beyond the end of the file are read as zero. The
+	 * byte order and size of the values are determined by the header of the file
+	 * (see {@link ExternalDataFormat}).
+	 */
+	protected static void readBinary(File src, int offset, double data[], int dOffset, int length) throws IOException {
+		if (length <= 0) return;
+
+		try (FileChannel in = FileChannel.open(src.toPath(), StandardOpenOption.READ)) {
+			ByteBuffer header = ByteBuffer.allocate(ExternalDataFormat.HEADER_SIZE);
+			read(in, header, 0);
+			header.flip();
+
+			ExternalDataFormat format = ExternalDataFormat.read(header);
+			int size = format.getNumberSize();
+
+			ByteBuffer buf = ByteBuffer.allocateDirect(size * length);
+			read(in, buf, ExternalDataFormat.HEADER_SIZE + (long) size * offset);
+			buf.clear();
+			buf.order(format.getOrder());
+
+			if (format.isDoublePrecision()) {
+				buf.asDoubleBuffer().get(data, dOffset, length);
+			} else {
+				FloatBuffer values = buf.asFloatBuffer();
+				for (int i = 0; i < length; i++) data[dOffset + i] = values.get();
+			}
+		}
+	}
 
-		for (int i = 0; i < data.length; i++) {
-			data[i] = buf.getDouble();
+	private static void read(FileChannel in, ByteBuffer buf, long position) throws IOException {
+		while (buf.hasRemaining()) {
+			int read = in.read(buf, position);
+			if (read < 0) break;
+			position += read;
 		}
 	}
 
-	protected static void writeBinary(File dest, byte data[]) throws IOException {
-		try (OutputStream out = new FileOutputStream(dest)) {
-			out.write(data);
+	/**
+	 * The size of the values stored in the files exchanged with external
+	 * executables, which matches the precision of the {@link Hardware}.
+	 */
+	protected static int getNumberSize() {
+		return Hardware.getLocalHardware().isDoublePrecision() ? 8 : 4;
+	}
+
+	protected static void writeBinary(File dest, ByteBuffer buf) throws IOException {
+		try (FileChannel out = FileChannel.open(dest.toPath(), StandardOpenOption.CREATE,
+						StandardOpenOption.WRITE, StandardOpenOption.TRUNCATE_EXISTING)) {
+			while (buf.hasRemaining()) {
+				out.write(buf);
+			}
 		}
 	}
 }
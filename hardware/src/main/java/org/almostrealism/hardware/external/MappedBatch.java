@@ -0,0 +1,167 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import org.almostrealism.hardware.HardwareException;
+import org.almostrealism.hardware.MemoryData;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.Arrays;
+import java.util.List;
+import java.util.stream.IntStream;
+
+/**
+ * A {@link MappedBatch} is a single memory mapped file holding any number of
+ * {@link MappedExchange}s, so that many invocations of the same executable can
+ * be applied by one run of it. The layout (all values in native byte order) is:
+ *
+ * <pre>
+ *     header     (see {@link ExternalDataFormat}, with a number size of 8)
+ *     uint32 n
+ *     uint32 (reserved)
+ *     uint64 offsets[n]
+ *     exchange 0 ... exchange n - 1
+ * </pre>
+ *
+ * where each offset is the position of the corresponding exchange, measured
+ * from the start of the file. The executable treats the exchanges as being
+ * independent, and may apply them concurrently.
+ *
+ * @author  Michael Murray
+ */
+public class MappedBatch {
+	public static final String FILE_NAME = "batch";
+
+	private final File file;
+	private final MappedExchange exchanges[];
+	private final long offsets[];
+
+	protected MappedBatch(File file, MappedExchange exchanges[]) {
+		this.file = file;
+		this.exchanges = exchanges;
+		this.offsets = new long[exchanges.length];
+
+		long pos = headerSize(exchanges.length);
+
+		for (int i = 0; i < exchanges.length; i++) {
+			offsets[i] = pos;
+			pos += exchanges[i].getTotalSize();
+		}
+	}
+
+	public File getFile() { return file; }
+
+	public int getCount() { return exchanges.length; }
+
+	protected long getTotalSize() {
+		if (exchanges.length == 0) return headerSize(0);
+		return offsets[exchanges.length - 1] + exchanges[exchanges.length - 1].getTotalSize();
+	}
+
+	protected void write() throws IOException {
+		long size = getTotalSize();
+
+		if (size > Integer.MAX_VALUE) {
+			throw new HardwareException("Batch of " + size + " bytes is too large to be mapped");
+		}
+
+		MappedByteBuffer buffer;
+
+		try (RandomAccessFile raf = new RandomAccessFile(file, "rw");
+			 	FileChannel channel = raf.getChannel()) {
+			buffer = channel.map(FileChannel.MapMode.READ_WRITE, 0, size);
+		}
+
+		ExternalDataFormat.nativeFormat(8).write(buffer);
+		buffer.putInt(exchanges.length);
+		buffer.putInt(0);
+		for (long o : offsets) buffer.putLong(o);
+
+		for (int i = 0; i < exchanges.length; i++) {
+			exchanges[i].write(buffer, offsets[i]);
+		}
+	}
+
+	/**
+	 * Copy the results of every exchange back to the arguments it was created
+	 * from, in the order the exchanges were provided to {@link #create}.
+	 */
+	public void read() {
+		for (MappedExchange exchange : exchanges) {
+			exchange.read();
+		}
+	}
+
+	/**
+	 * Create a new batch file in the specified directory, with one exchange for
+	 * each of the specified argument sets.
+	 *
+	 * @param altered  Flags indicating which arguments may be assigned to, or
+	 *                 null if any of them may be.
+	 */
+	public static MappedBatch create(File dest, List<MemoryData[]> args, boolean altered[]) throws IOException {
+		return create(dest, args, altered, false);
+	}
+
+	/**
+	 * Create a new batch file in the specified directory, with one exchange for
+	 * each of the specified argument sets.
+	 *
+	 * @param altered  Flags indicating which arguments may be assigned to, or
+	 *                 null if any of them may be.
+	 * @param atomicSizes  If true, the size provided to the function for each
+	 *                     argument is its atomic mem length.
+	 */
+	public static MappedBatch create(File dest, List<MemoryData[]> args, boolean altered[], boolean atomicSizes) throws IOException {
+		long offsets[] = new long[args.size()];
+		long sizes[] = new long[args.size()];
+		Arrays.fill(sizes, 1);
+		return create(dest, args, altered, offsets, sizes, atomicSizes);
+	}
+
+	/**
+	 * Create a new batch file in the specified directory, with one exchange for
+	 * each of the specified argument sets, applied over the corresponding range
+	 * of global ids.
+	 *
+	 * @param altered  Flags indicating which arguments may be assigned to, or
+	 *                 null if any of them may be.
+	 * @param atomicSizes  If true, the size provided to the function for each
+	 *                     argument is its atomic mem length.
+	 */
+	public static MappedBatch create(File dest, List<MemoryData[]> args, boolean altered[],
+									 long workOffsets[], long workSizes[], boolean atomicSizes) throws IOException {
+		File file = new File(dest, FILE_NAME);
+
+		MappedExchange exchanges[] = IntStream.range(0, args.size())
+				.mapToObj(i -> new MappedExchange(file, new ArgumentTransferPlan(args.get(i), altered),
+						workOffsets[i], workSizes[i], atomicSizes))
+				.toArray(MappedExchange[]::new);
+
+		MappedBatch batch = new MappedBatch(file, exchanges);
+		batch.write();
+		return batch;
+	}
+
+	protected static long headerSize(int count) {
+		return ExternalDataFormat.HEADER_SIZE + 8L + 8L * count;
+	}
+}
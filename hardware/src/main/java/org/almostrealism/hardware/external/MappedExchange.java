@@ -0,0 +1,233 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.external;
+
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.HardwareException;
+import org.almostrealism.hardware.MemoryData;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+
+/**
+ * A {@link MappedExchange} is a single file, shared with the external executable
+ * by memory mapping it, which holds everything needed for one invocation. The
+ * layout (all values in native byte order) is:
+ *
+ * <pre>
+ *     (header, see {@link ExternalDataFormat})
+ *     uint32 count
+ *     uint32 sizes[count]
+ *     uint32 offsets[count]
+ *     uint32 blocks[count]
+ *     uint32 blockCount
+ *     uint32 lengths[blockCount]
+ *     (padding to 8 bytes)
+ *     uint64 workOffset
+ *     uint64 workSize
+ *     number data[lengths[0]] ... number data[lengths[blockCount - 1]]
+ *     (padding to 8 bytes)
+ * </pre>
+ *
+ * The size and offset of each argument are the values provided to the generated
+ * function, with the offset being relative to the start of the block (identified
+ * by its index in blocks) that holds the values for the argument. Blocks are
+ * determined by an {@link ArgumentTransferPlan}, so that arguments which are views
+ * into a larger bank only require the range they actually use to be transferred.
+ * The work offset and size are the range of global ids, which is only used when
+ * the executable was compiled as a CPU kernel. For kernels, the size of each
+ * argument is its atomic mem length, as it is for OpenCL kernels. Because the
+ * data is used in place by the executable, it is always stored in the native
+ * byte order and at the precision of the {@link Hardware} (fp64, or fp32 when
+ * double precision is disabled), which is the precision the executable is
+ * compiled for.
+ *
+ * @author  Michael Murray
+ */
+public class MappedExchange {
+	public static final String FILE_NAME = "exchange";
+
+	private final File file;
+	private final ArgumentTransferPlan plan;
+	private final long positions[];
+	private final int numberSize;
+
+	private final long workOffset, workSize;
+	private final boolean atomicSizes;
+
+	private MappedByteBuffer buffer;
+	private long base;
+
+	protected MappedExchange(File file, ArgumentTransferPlan plan) {
+		this(file, plan, 0, 1, false);
+	}
+
+	protected MappedExchange(File file, ArgumentTransferPlan plan, long workOffset, long workSize, boolean atomicSizes) {
+		this.file = file;
+		this.plan = plan;
+		this.workOffset = workOffset;
+		this.workSize = workSize;
+		this.atomicSizes = atomicSizes;
+		this.positions = new long[plan.getBlockCount()];
+		this.numberSize = Hardware.getLocalHardware().getNumberSize();
+
+		long pos = headerSize(plan.getCount(), plan.getBlockCount());
+
+		for (int i = 0; i < positions.length; i++) {
+			positions[i] = pos;
+			pos += (long) plan.getBlockLength(i) * numberSize;
+		}
+	}
+
+	public File getFile() { return file; }
+
+	public int getCount() { return plan.getCount(); }
+
+	public ArgumentTransferPlan getPlan() { return plan; }
+
+	/** The number of bytes occupied by this exchange, which is always a multiple of 8. */
+	protected long getTotalSize() {
+		long len = headerSize(plan.getCount(), plan.getBlockCount()) + plan.getTransferLength() * numberSize;
+		return (len + 7) & ~7L;
+	}
+
+	protected void map() throws IOException {
+		long size = getTotalSize();
+
+		if (size > Integer.MAX_VALUE) {
+			throw new HardwareException("Exchange of " + size + " bytes is too large to be mapped");
+		}
+
+		try (RandomAccessFile raf = new RandomAccessFile(file, "rw");
+			 	FileChannel channel = raf.getChannel()) {
+			buffer = channel.map(FileChannel.MapMode.READ_WRITE, 0, size);
+		}
+
+		buffer.order(ByteOrder.nativeOrder());
+	}
+
+	/**
+	 * Write this exchange into the specified buffer, which may be shared with
+	 * other exchanges, starting at the specified position.
+	 */
+	protected void write(MappedByteBuffer buffer, long base) {
+		this.buffer = buffer;
+		this.base = base;
+		writeHeader();
+
+		for (int i = 0; i < positions.length; i++) {
+			writeBlock(i);
+		}
+	}
+
+	protected void writeHeader() {
+		buffer.position((int) base);
+		ExternalDataFormat.nativeFormat(numberSize).write(buffer);
+		buffer.putInt(getCount());
+		for (int i = 0; i < getCount(); i++) buffer.putInt(atomicSizes ? plan.getAtomicSize(i) : plan.getSize(i));
+		for (int i = 0; i < getCount(); i++) buffer.putInt(plan.getRelativeOffset(i));
+		for (int i = 0; i < getCount(); i++) buffer.putInt(plan.getBlockIndex(i));
+		buffer.putInt(plan.getBlockCount());
+		for (int i = 0; i < plan.getBlockCount(); i++) buffer.putInt(plan.getBlockLength(i));
+
+		buffer.position((int) (base + workPosition(getCount(), plan.getBlockCount())));
+		buffer.putLong(workOffset);
+		buffer.putLong(workSize);
+	}
+
+	protected void writeBlock(int block) {
+		if (plan.getBlockLength(block) <= 0) return;
+
+		double data[] = new double[plan.getBlockLength(block)];
+		plan.readBlock(block, data);
+		buffer.position((int) (base + positions[block]));
+
+		if (numberSize == 4) {
+			FloatBuffer out = buffer.asFloatBuffer();
+			for (int i = 0; i < data.length; i++) out.put(i, (float) data[i]);
+		} else {
+			buffer.asDoubleBuffer().put(data);
+		}
+	}
+
+	/**
+	 * Copy the values for each argument that may have been altered out of the
+	 * mapped file, into the {@link MemoryData} it was created from. Only the
+	 * range of each argument (its offset and mem length) is copied back, so
+	 * that arguments which are views into a larger bank do not overwrite the
+	 * rest of the bank.
+	 */
+	public void read() {
+		for (int i = 0; i < getCount(); i++) {
+			if (!plan.isAltered(i) || plan.getSize(i) <= 0) continue;
+
+			double out[] = new double[plan.getSize(i)];
+			buffer.position((int) (base + positions[plan.getBlockIndex(i)] + (long) plan.getRelativeOffset(i) * numberSize));
+
+			if (numberSize == 4) {
+				FloatBuffer in = buffer.asFloatBuffer();
+				for (int j = 0; j < out.length; j++) out[j] = in.get(j);
+			} else {
+				buffer.asDoubleBuffer().get(out);
+			}
+
+			plan.writeArgument(i, out);
+		}
+	}
+
+	/**
+	 * Create a new exchange file in the specified directory, including the
+	 * data for each of the specified arguments.
+	 *
+	 * @param altered  Flags indicating which arguments may be assigned to, or
+	 *                 null if any of them may be.
+	 */
+	public static MappedExchange create(File dest, MemoryData args[], boolean altered[]) throws IOException {
+		return create(dest, args, altered, 0, 1, false);
+	}
+
+	/**
+	 * Create a new exchange file in the specified directory, including the data
+	 * for each of the specified arguments and the range of global ids to use if
+	 * the executable is a CPU kernel.
+	 *
+	 * @param atomicSizes  If true, the size provided to the function for each
+	 *                     argument is its atomic mem length.
+	 */
+	public static MappedExchange create(File dest, MemoryData args[], boolean altered[],
+										long workOffset, long workSize, boolean atomicSizes) throws IOException {
+		MappedExchange exchange = new MappedExchange(new File(dest, FILE_NAME), new ArgumentTransferPlan(args, altered),
+													workOffset, workSize, atomicSizes);
+		exchange.map();
+		exchange.write(exchange.buffer, 0);
+		return exchange;
+	}
+
+	protected static long workPosition(int count, int blockCount) {
+		long len = ExternalDataFormat.HEADER_SIZE + 4L * (2 + 3L * count + blockCount);
+		return (len + 7) & ~7L;
+	}
+
+	protected static long headerSize(int count, int blockCount) {
+		return workPosition(count, blockCount) + 16;
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.jni;
+
+import io.almostrealism.code.InstructionSet;
+import org.almostrealism.hardware.HardwareException;
+
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.CompletionException;
+import java.util.function.Consumer;
+import java.util.function.Supplier;
+
+/**
+ * An {@link InstructionSet} for a {@link NativeInstructionSet} whose library is
+ * still being compiled by {@link NativeCompiler#compileAsync}. Operators can be
+ * obtained immediately, and the first invocation of any of them waits for the
+ * compilation to finish.
+ */
+public class AsyncInstructionSet implements InstructionSet {
+	private final NativeInstructionSet target;
+	private final Supplier<CompletableFuture<Void>> compilation;
+
+	public AsyncInstructionSet(NativeInstructionSet target, CompletableFuture<Void> compilation) {
+		this(target, () -> compilation);
+	}
+
+	/**
+	 * Create an {@link AsyncInstructionSet} for a compilation which may not have
+	 * started yet, obtaining it from the specified {@link Supplier} when needed.
+	 */
+	public AsyncInstructionSet(NativeInstructionSet target, Supplier<CompletableFuture<Void>> compilation) {
+		this.target = target;
+		this.compilation = compilation;
+	}
+
+	public NativeInstructionSet getTarget() { return target; }
+
+	public boolean isReady() { return compilation.get().isDone(); }
+
+	/**
+	 * Wait for the library to be compiled and loaded.
+	 *
+	 * @throws  HardwareException  If the compilation failed.
+	 */
+	public void await() {
+		try {
+			compilation.get().join();
+		} catch (CompletionException e) {
+			if (e.getCause() instanceof HardwareException) throw (HardwareException) e.getCause();
+			throw new HardwareException(e.getMessage(), new UnsupportedOperationException(e.getCause()));
+		}
+	}
+
+	@Override
+	public Consumer<Object[]> get(String function, int argCount) {
+		return new Consumer<>() {
+			private Consumer<Object[]> operator;
+
+			@Override
+			public void accept(Object[] args) {
+				if (operator == null) {
+					await();
+					operator = target.get(function, argCount);
+				}
+
+				operator.accept(args);
+			}
+		};
+	}
+
+	@Override
+	public boolean isDestroyed() { return target.isDestroyed(); }
+
+	@Override
+	public void destroy() { target.destroy(); }
+}
@@ -21,6 +21,8 @@ import io.almostrealism.relation.Factory;
 import org.almostrealism.generated.BaseGeneratedOperation;
 import org.almostrealism.hardware.Hardware;
 import org.almostrealism.hardware.HardwareException;
+import org.almostrealism.hardware.profile.Profiler;
+import org.almostrealism.io.SystemUtils;
 
 import java.io.BufferedWriter;
 import java.io.File;
@@ -31,10 +33,25 @@ import java.lang.reflect.InvocationTargetException;
 import java.util.ArrayList;
 import java.util.List;
 import java.util.Optional;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.atomic.AtomicInteger;
 
 public class NativeCompiler {
 	public static boolean enableVerbose = false;
 
+	/**
+	 * If enabled, compiled libraries and executables are kept in a
+	 * {@link NativeLibraryCache}, so that they are only compiled again
+	 * when the code or the compiler changes.
+	 */
+	public static boolean enableCache = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_CACHE").orElse(true);
+
+	/** The maximum number of compiler processes that {@link #compileAsync} will run at once. */
+	public static int compileThreads = Integer.parseInt(SystemUtils.getProperty("AR_HARDWARE_NATIVE_COMPILE_THREADS",
+			String.valueOf(Runtime.getRuntime().availableProcessors())));
+
 	public static final String LIB_NAME_REPLACE = "%NAME%";
 
 	private static final String STDIO = "#include <stdio.h>\n";
@@ -45,8 +62,10 @@ public class NativeCompiler {
 	private static final String OPENCL = System.getProperty("os.name").toLowerCase().startsWith("mac os") ?
 								"#include <OpenCL/cl.h>\n" : "#include <cl.h>\n";
 
-	private static int runnableCount;
-	private static int dataCount;
+	private static final AtomicInteger runnableCount = new AtomicInteger();
+	private static final AtomicInteger dataCount = new AtomicInteger();
+
+	private static ExecutorService compiler;
 
 	private String libExecutable, exeExecutable;
 	private final String libCompiler, exeCompiler;
@@ -55,6 +74,7 @@ public class NativeCompiler {
 	private final String dataDir;
 
 	private final String header;
+	private NativeLibraryCache cache;
 
 	public NativeCompiler(Hardware hardware, String libCompiler, String exeCompiler, String libDir, String libFormat, String dataDir, boolean cl) {
 		if (libCompiler != null) {
@@ -80,14 +100,22 @@ public class NativeCompiler {
 		this.header = STDIO + STDLIB + STR + MATH + JNI +
 				(cl ? OPENCL : "") +
 				pi + "\n";
+
+		if (enableCache && libDir != null) {
+			String cacheDir = SystemUtils.getProperty("AR_HARDWARE_NATIVE_CACHE_DIR", libDir + "/cache");
+			long cacheSize = Long.parseLong(SystemUtils.getProperty("AR_HARDWARE_NATIVE_CACHE_SIZE", "1024"));
+			this.cache = new NativeLibraryCache(new File(cacheDir), cacheSize * 1024L * 1024L);
+		}
 	}
 
+	public NativeLibraryCache getCache() { return cache; }
+
 	public String getLibraryDirectory() { return libDir; }
 
 	public String getDataDirectory() { return dataDir; }
 
 	public File reserveDataDirectory() {
-		File data = new File(getDataDirectory() + "/" + dataCount++);
+		File data = new File(getDataDirectory() + "/" + dataCount.getAndIncrement());
 		if (!data.exists()) {
 			data.mkdir();
 		}
@@ -117,6 +145,11 @@ public class NativeCompiler {
 		}
 	}
 
+	/** The absolute path of the library that {@link #compile(String, String, boolean)} produces. */
+	public String getLibraryFile(String name) {
+		return new File(getOutputFile(name, true)).getAbsolutePath();
+	}
+
 	protected List<String> getArguments(String name, boolean lib) {
 		List<String> command = new ArrayList<>();
 		if (lib) {
@@ -136,10 +169,10 @@ public class NativeCompiler {
 		return command;
 	}
 
-	public synchronized BaseGeneratedOperation reserveLibraryTarget() {
+	public BaseGeneratedOperation reserveLibraryTarget() {
 		try {
 			BaseGeneratedOperation gen = (BaseGeneratedOperation)
-					Class.forName("org.almostrealism.generated.GeneratedOperation" + runnableCount++)
+					Class.forName("org.almostrealism.generated.GeneratedOperation" + runnableCount.getAndIncrement())
 							.getConstructor(Computation.class).newInstance(new Object[] { null });
 			return gen;
 		} catch (InstantiationException | IllegalAccessException | InvocationTargetException
@@ -152,12 +185,30 @@ public class NativeCompiler {
 		compileAndLoad(target.getClass(), code);
 	}
 
+	/**
+	 * Compile and load the library for the specified target using a shared pool
+	 * of {@link #compileThreads} threads, so that many libraries can be built at
+	 * the same time without blocking the calling thread.
+	 */
+	public CompletableFuture<Void> compileAsync(NativeInstructionSet target, String code) {
+		return CompletableFuture.runAsync(() -> compile(target, code), compiler());
+	}
+
+	/**
+	 * Compile the specified code using the same pool of threads as
+	 * {@link #compileAsync(NativeInstructionSet, String)}, without loading it.
+	 */
+	public CompletableFuture<Void> compileAsync(String name, String code, boolean lib) {
+		return CompletableFuture.runAsync(() -> compile(name, code, lib), compiler());
+	}
+
 	public String compile(Class target, String code) {
 		return compile(target.getName(), code, true);
 	}
 
 	public String compile(String name, String code, boolean lib) {
 		if (enableVerbose) System.out.println("NativeCompiler: Compiling native code for " + name);
+		long start = Profiler.start();
 
 		try (FileOutputStream out = new FileOutputStream(getInputFile(name));
 				BufferedWriter buf = new BufferedWriter(new OutputStreamWriter(out))) {
@@ -167,6 +218,14 @@ public class NativeCompiler {
 			throw new HardwareException(e.getMessage(), new UnsupportedOperationException(e));
 		}
 
+		String key = cache == null ? null : cache.key(header + code, getCommand(name, lib));
+
+		if (key != null && cache.restore(key, new File(getOutputFile(name, lib)))) {
+			if (enableVerbose) System.out.println("NativeCompiler: Using cached native code for " + name);
+			Profiler.record(Profiler.Category.COMPILE, "cached", start, 0);
+			return name;
+		}
+
 		try {
 			Process process = new ProcessBuilder(getCommand(name, lib)).inheritIO().start();
 			process.waitFor();
@@ -178,6 +237,9 @@ public class NativeCompiler {
 			throw new HardwareException(e.getMessage(), new UnsupportedOperationException(e));
 		}
 
+		if (key != null) cache.store(key, new File(getOutputFile(name, lib)));
+		Profiler.record(Profiler.Category.COMPILE, lib ? "library" : "executable", start, 0);
+
 		if (enableVerbose) System.out.println("NativeCompiler: Native code compiled for " + name);
 		return name;
 	}
@@ -189,6 +251,18 @@ public class NativeCompiler {
 		if (enableVerbose) System.out.println("NativeCompiler: Loaded native library " + name);
 	}
 
+	private static synchronized ExecutorService compiler() {
+		if (compiler == null) {
+			compiler = Executors.newFixedThreadPool(Math.max(1, compileThreads), r -> {
+				Thread t = new Thread(r, "NativeCompiler");
+				t.setDaemon(true);
+				return t;
+			});
+		}
+
+		return compiler;
+	}
+
 	public static Factory<NativeCompiler> factory(Hardware hardware, boolean cl) {
 		return () -> {
 			String libFormat = System.getProperty("AR_HARDWARE_LIB_FORMAT");
@@ -23,12 +23,35 @@ import io.almostrealism.code.ScopeEncoder;
 import org.almostrealism.c.CJNIPrintWriter;
 import org.almostrealism.hardware.ctx.AbstractComputeContext;
 import org.almostrealism.hardware.Hardware;
+import org.almostrealism.io.SystemUtils;
+
+import java.util.List;
+import java.util.stream.Collectors;
 
 public class NativeComputeContext extends AbstractComputeContext {
 	public static boolean enableVerbose = false;
-	protected static long totalInvocations = 0;
 
-	private NativeCompiler compiler;
+	/**
+	 * If enabled, {@link #deliver(Scope)} returns as soon as the code has been
+	 * generated, and the library is compiled in the background (see
+	 * {@link AsyncInstructionSet}).
+	 */
+	public static boolean enableAsync = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_ASYNC").orElse(false);
+
+	/**
+	 * If enabled, {@link #deliver(List)} compiles all of the {@link Scope}s it is
+	 * given into one library (see {@link NativeOperationGroup}).
+	 */
+	public static boolean enableGroups = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_GROUPS").orElse(false);
+
+	/**
+	 * If enabled, and {@link #enableGroups} is also enabled, consecutive operations
+	 * in an {@link org.almostrealism.hardware.OperationList} are run with a single
+	 * JNI call whenever possible (see {@link NativeOperationProgram}).
+	 */
+	public static boolean enablePrograms = SystemUtils.isEnabled("AR_HARDWARE_NATIVE_PROGRAMS").orElse(false);
+
+	protected static long totalInvocations = 0;
 
 	public NativeComputeContext(Hardware hardware) {
 		super(hardware, false, true);
@@ -36,13 +59,31 @@ public class NativeComputeContext extends AbstractComputeContext {
 
 	@Override
 	public InstructionSet deliver(Scope scope) {
+		NativeCompiler compiler = getComputer().getNativeCompiler();
+
 		StringBuffer buf = new StringBuffer();
 		NativeInstructionSet target = compiler.reserveLibraryTarget();
 		buf.append(new ScopeEncoder(pw -> new CJNIPrintWriter(pw, target.getFunctionName()), Accessibility.EXTERNAL).apply(scope));
+
+		if (enableAsync) {
+			return new AsyncInstructionSet(target, compiler.compileAsync(target, buf.toString()));
+		}
+
 		compiler.compile(target, buf.toString());
 		return target;
 	}
 
+	@Override
+	public List<InstructionSet> deliver(List<Scope> scopes) {
+		if (!enableGroups || scopes.size() < 2) return super.deliver(scopes);
+
+		NativeOperationGroup group = new NativeOperationGroup(getComputer().getNativeCompiler());
+		List<InstructionSet> result = scopes.stream().map(group::add).collect(Collectors.toList());
+		group.compile();
+		if (!enableAsync) ((AsyncInstructionSet) result.get(0)).await();
+		return result;
+	}
+
 	@Override
 	public boolean isKernelSupported() { return false; }
 
@@ -50,7 +50,7 @@ public class NativeDataContext implements DataContext {
 
 	public void init() {
 		if (ram != null) return;
-		ram = isNativeMem ? new NativeMemoryProvider(memoryMax) : new JVMMemoryProvider();
+		ram = isNativeMem ? new NativeMemoryProvider(memoryMax, isDoublePrecision ? 8 : 4) : new JVMMemoryProvider();
 	}
 
 	public String getName() { return name; }
@@ -23,11 +23,11 @@ import org.almostrealism.hardware.MemoryData;
 import org.almostrealism.hardware.RAM;
 import org.almostrealism.hardware.cl.CLComputeContext;
 import org.almostrealism.hardware.cl.CLDataContext;
+import org.almostrealism.hardware.cl.CLMemory;
+import org.almostrealism.hardware.profile.Profiler;
 import org.jocl.cl_command_queue;
 
-import java.util.Optional;
 import java.util.function.Consumer;
-import java.util.stream.Stream;
 
 public interface NativeInstructionSet extends InstructionSet, KernelSupport {
 	default String getFunctionName() {
@@ -41,7 +41,7 @@ public interface NativeInstructionSet extends InstructionSet, KernelSupport {
 
 	@Override
 	default Consumer<Object[]> get(String function, int argCount) {
-		return args -> apply(Stream.of(args).map(arg -> (MemoryData) arg).toArray(MemoryData[]::new));
+		return new NativeInvocation(this, argCount);
 	}
 
 	@Override
@@ -60,21 +60,48 @@ public interface NativeInstructionSet extends InstructionSet, KernelSupport {
 			System.out.println("NativeInstructionSet: " + id);
 		}
 
-		apply(Stream.of(args).map(MemoryData::getMem).toArray(RAM[]::new),
-					Stream.of(args).mapToInt(MemoryData::getOffset).toArray(),
-					Stream.of(args).mapToInt(MemoryData::getMemLength).toArray());
+		long arg[] = new long[args.length];
+		int offset[] = new int[args.length];
+		int size[] = new int[args.length];
+
+		for (int i = 0; i < args.length; i++) {
+			if (args[i].getMem() instanceof CLMemory) ((CLMemory) args[i].getMem()).await();
+			arg[i] = ((RAM) args[i].getMem()).getNativePointer();
+			offset[i] = args[i].getOffset();
+			size[i] = args[i].getMemLength();
+		}
+
+		long start = Profiler.start();
+		apply(getCommandQueue(), arg, offset, size, args.length);
+		Profiler.record(Profiler.Category.NATIVE, getClass().getSimpleName(), start, 0);
 	}
 
 	default void apply(RAM args[], int offsets[], int sizes[]) {
-		apply(Optional.ofNullable(Hardware.getLocalHardware().getClComputeContext())
-				.map(CLComputeContext::getClQueue)
-				.map(cl_command_queue::getNativePointer).orElse(-1L), args, offsets, sizes);
+		apply(getCommandQueue(), args, offsets, sizes);
 	}
 
 	default void apply(long commandQueue, RAM args[], int offsets[], int sizes[]) {
-		apply(commandQueue,
-				Stream.of(args).mapToLong(RAM::getNativePointer).toArray(),
-				offsets, sizes, args.length);
+		long arg[] = new long[args.length];
+		for (int i = 0; i < args.length; i++) arg[i] = args[i].getNativePointer();
+		apply(commandQueue, arg, offsets, sizes, args.length);
+	}
+
+	/**
+	 * Invoke the native function without a command queue, which is sufficient
+	 * unless the function was generated for use with OpenCL.
+	 */
+	default void apply(long arg[], int offset[], int size[], int count) {
+		apply(-1, arg, offset, size, count);
+	}
+
+	/**
+	 * The pointer to the OpenCL command queue of the local {@link Hardware},
+	 * or -1 if there is none.
+	 */
+	default long getCommandQueue() {
+		CLComputeContext context = Hardware.getLocalHardware().getClComputeContext();
+		cl_command_queue queue = context == null ? null : context.getClQueue();
+		return queue == null ? -1 : queue.getNativePointer();
 	}
 
 	void apply(long commandQueue, long arg[], int offset[], int size[], int count);
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.jni;
+
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.RAM;
+import org.almostrealism.hardware.cl.CLMemory;
+import org.almostrealism.hardware.profile.Profiler;
+
+import java.util.function.Consumer;
+
+/**
+ * An operator for a {@link NativeInstructionSet} which keeps the arrays of pointers,
+ * offsets and sizes from one invocation to the next, rather than creating them each
+ * time. Each thread has its own arrays, so that threads which share an operation
+ * do not wait for each other, and they are refilled in place from the arguments to
+ * each invocation, so that reassigned {@link MemoryData} are always seen. The command
+ * queue is only looked up the first time it is needed. An operation keeps its
+ * {@link NativeInvocation} only for as long as it keeps the {@link NativeInstructionSet}
+ * it was obtained from, so the queue is looked up again whenever the operation is
+ * delivered again.
+ *
+ * Any {@link CLMemory} argument is brought up to date before the native function,
+ * which does not take part in the event scheduling of
+ * {@link org.almostrealism.hardware.cl.CLComputeContext}, is invoked.
+ */
+public class NativeInvocation implements Consumer<Object[]> {
+	private final NativeInstructionSet target;
+	private final String name;
+	private final ThreadLocal<Arguments> arguments;
+
+	private volatile boolean queueResolved;
+	private long commandQueue;
+
+	public NativeInvocation(NativeInstructionSet target, int argCount) {
+		this.target = target;
+		this.name = target.getClass().getSimpleName();
+		this.arguments = ThreadLocal.withInitial(() -> new Arguments(argCount));
+	}
+
+	@Override
+	public void accept(Object[] args) {
+		Arguments a = arguments.get();
+		if (args.length != a.arg.length) {
+			a = new Arguments(args.length);
+			arguments.set(a);
+		}
+
+		for (int i = 0; i < args.length; i++) {
+			MemoryData data = (MemoryData) args[i];
+			if (data.getMem() instanceof CLMemory) ((CLMemory) data.getMem()).await();
+			a.arg[i] = ((RAM) data.getMem()).getNativePointer();
+			a.offset[i] = data.getOffset();
+			a.size[i] = data.getMemLength();
+		}
+
+		if (!queueResolved) {
+			commandQueue = target.getCommandQueue();
+			queueResolved = true;
+		}
+
+		long start = Profiler.start();
+		target.apply(commandQueue, a.arg, a.offset, a.size, args.length);
+		Profiler.record(Profiler.Category.NATIVE, name, start, 0);
+	}
+
+	/** The arrays which are passed to the native function by one thread. */
+	private static class Arguments {
+		private final long arg[];
+		private final int offset[];
+		private final int size[];
+
+		public Arguments(int count) {
+			arg = new long[count];
+			offset = new int[count];
+			size = new int[count];
+		}
+	}
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.jni;
+
+import org.almostrealism.hardware.HardwareException;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.StandardCopyOption;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * A persistent cache of the output of {@link NativeCompiler}, so that libraries
+ * and executables which were produced by an earlier run from identical input do
+ * not need to be compiled again. Entries are identified by a hash of everything
+ * that determines the output: the complete source, the command used to compile
+ * it, and the identity of the compiler, which is its resolved location, size and
+ * modification time along with the output of {@code --version}. When the total size
+ * of the cache exceeds its limit, the least recently used entries are removed.
+ */
+public class NativeLibraryCache {
+	public static boolean enableVerbose = false;
+
+	private static final Map<String, String> compilerIdentities = new ConcurrentHashMap<>();
+
+	private final File dir;
+	private final long maxSize;
+
+	public NativeLibraryCache(File dir, long maxSize) {
+		this.dir = dir;
+		this.maxSize = maxSize;
+		if (!dir.exists()) dir.mkdirs();
+	}
+
+	public File getDirectory() { return dir; }
+
+	/**
+	 * Compute the key for the specified complete source and compile command.
+	 */
+	public String key(String source, List<String> command) {
+		try {
+			MessageDigest digest = MessageDigest.getInstance("SHA-256");
+			digest.update(source.getBytes(StandardCharsets.UTF_8));
+
+			for (String c : command) {
+				digest.update((byte) 0);
+				digest.update(c.getBytes(StandardCharsets.UTF_8));
+			}
+
+			if (!command.isEmpty()) {
+				digest.update((byte) 0);
+				digest.update(compilerIdentity(command.get(0)).getBytes(StandardCharsets.UTF_8));
+			}
+
+			StringBuilder key = new StringBuilder();
+			for (byte b : digest.digest()) key.append(String.format("%02x", b));
+			return key.toString();
+		} catch (NoSuchAlgorithmException e) {
+			throw new HardwareException(e.getMessage(), new UnsupportedOperationException(e));
+		}
+	}
+
+	/**
+	 * Returns a description of the specified compiler which changes whenever it is
+	 * replaced, even if it is invoked by a bare name (such as gcc) that is found
+	 * using the PATH. This is only determined once for each compiler.
+	 */
+	protected static String compilerIdentity(String compiler) {
+		return compilerIdentities.computeIfAbsent(compiler, c -> {
+			StringBuilder identity = new StringBuilder();
+
+			File file = resolve(c);
+			if (file != null) {
+				identity.append(file.getAbsolutePath()).append(":")
+						.append(file.length()).append(":").append(file.lastModified());
+			}
+
+			identity.append("\n").append(version(c));
+			return identity.toString();
+		});
+	}
+
+	private static File resolve(String compiler) {
+		File file = new File(compiler);
+		if (compiler.contains(File.separator)) return file.isFile() ? file : null;
+
+		String path = System.getenv("PATH");
+		if (path == null) return null;
+
+		for (String p : path.split(File.pathSeparator)) {
+			File f = new File(p, compiler);
+			if (f.isFile()) return f;
+		}
+
+		return null;
+	}
+
+	private static String version(String compiler) {
+		try {
+			Process process = new ProcessBuilder(compiler, "--version").redirectErrorStream(true).start();
+
+			byte out[];
+			try (InputStream in = process.getInputStream()) {
+				out = in.readAllBytes();
+			}
+
+			if (!process.waitFor(10, TimeUnit.SECONDS)) {
+				process.destroyForcibly();
+				return "";
+			}
+
+			return new String(out, StandardCharsets.UTF_8);
+		} catch (IOException | InterruptedException e) {
+			if (enableVerbose) System.out.println("NativeLibraryCache: Unable to determine version of " + compiler);
+			return "";
+		}
+	}
+
+	/**
+	 * If there is an entry for the specified key, copy it to the specified output
+	 * file and return true. Otherwise, return false.
+	 */
+	public boolean restore(String key, File output) {
+		File entry = entry(key, output);
+		if (!entry.isFile()) return false;
+
+		try {
+			replace(entry, output);
+			entry.setLastModified(System.currentTimeMillis());
+			if (enableVerbose) System.out.println("NativeLibraryCache: Restored " + output.getName());
+			return true;
+		} catch (IOException e) {
+			if (enableVerbose) System.out.println("NativeLibraryCache: Unable to restore " + output.getName() + " (" + e.getMessage() + ")");
+			return false;
+		}
+	}
+
+	/**
+	 * Store the specified output file as the entry for the specified key, and
+	 * then remove entries until the cache is within its size limit.
+	 */
+	public void store(String key, File output) {
+		if (!output.isFile()) return;
+
+		try {
+			replace(output, entry(key, output));
+		} catch (IOException e) {
+			if (enableVerbose) System.out.println("NativeLibraryCache: Unable to store " + output.getName() + " (" + e.getMessage() + ")");
+			return;
+		}
+
+		evict();
+	}
+
+	protected synchronized void evict() {
+		File entries[] = dir.listFiles(File::isFile);
+		if (entries == null) return;
+
+		long size = Arrays.stream(entries).mapToLong(File::length).sum();
+		if (size <= maxSize) return;
+
+		Arrays.sort(entries, Comparator.comparingLong(File::lastModified));
+
+		for (File f : entries) {
+			if (size <= maxSize) break;
+
+			long len = f.length();
+			if (f.delete()) size -= len;
+		}
+	}
+
+	protected File entry(String key, File output) {
+		return new File(dir, key + "-" + output.getName());
+	}
+
+	/**
+	 * Copy the source to the destination by way of a temporary file, so that
+	 * the destination is replaced with a new file rather than overwritten.
+	 * This means that a process which has the previous file loaded is not
+	 * affected, and it is never possible to observe a partial copy.
+	 */
+	private static void replace(File source, File dest) throws IOException {
+		File tmp = File.createTempFile(dest.getName(), ".tmp", dest.getAbsoluteFile().getParentFile());
+
+		try {
+			Files.copy(source.toPath(), tmp.toPath(), StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.COPY_ATTRIBUTES);
+			if (source.canExecute()) tmp.setExecutable(true);
+			Files.move(tmp.toPath(), dest.toPath(), StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE);
+		} finally {
+			tmp.delete();
+		}
+	}
+}
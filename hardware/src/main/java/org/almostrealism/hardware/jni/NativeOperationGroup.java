@@ -0,0 +1,185 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.jni;
+
+import io.almostrealism.code.Accessibility;
+import io.almostrealism.code.InstructionSet;
+import io.almostrealism.code.ScopeEncoder;
+import io.almostrealism.scope.Scope;
+import org.almostrealism.c.CPrintWriter;
+import org.almostrealism.c.NativeMemoryProvider;
+import org.almostrealism.c.NativeDispatch;
+import org.almostrealism.c.NativeSymbol;
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.HardwareException;
+import org.almostrealism.io.PrintWriter;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * A {@link NativeOperationGroup} compiles any number of {@link Scope}s into a single
+ * shared library, with one exported function for each of them. The functions are
+ * not bound to Java classes: their addresses are resolved using {@link NativeSymbol}
+ * once the library is built, and they are invoked through {@link NativeDispatch}.
+ * This means there is no limit on the number of operations imposed by the set of
+ * generated classes, only one library needs to be loaded for the whole group, and
+ * the compiler is free to inline across the operations in the group.
+ */
+public class NativeOperationGroup {
+	private static final AtomicInteger groupCount = new AtomicInteger();
+
+	private static volatile NativeSymbol symbol;
+	private static volatile NativeDispatch dispatch;
+
+	private final NativeCompiler compiler;
+	private final String name;
+	private final StringBuffer code;
+	private final List<String> functionsWritten;
+	private final List<Entry> entries;
+
+	private CompletableFuture<Void> compilation;
+
+	public NativeOperationGroup(NativeCompiler compiler) {
+		this.compiler = compiler;
+		this.name = "NativeOperationGroup" + groupCount.getAndIncrement();
+		this.code = new StringBuffer();
+		this.code.append("#include <stdint.h>\n");
+		this.functionsWritten = new ArrayList<>();
+		this.entries = new ArrayList<>();
+	}
+
+	public String getName() { return name; }
+
+	/** The source of the library, including every {@link Scope} added so far. */
+	public synchronized String getCode() { return code.toString(); }
+
+	/**
+	 * Include the specified {@link Scope} in the library for this group. The
+	 * resulting {@link InstructionSet} can be used as soon as {@link #compile()}
+	 * has been called, and will wait for the library to be built when it is
+	 * first invoked.
+	 */
+	public synchronized InstructionSet add(Scope<?> scope) {
+		if (compilation != null) {
+			throw new IllegalStateException(name + " has already been compiled");
+		}
+
+		Entry entry = new Entry(name + "_" + entries.size());
+
+		// Required scopes are shared by the whole library, but the scope itself
+		// is written with the name of the entry, so its own name is only kept
+		// if it was already written as a requirement of another scope
+		boolean written = functionsWritten.remove(scope.getName());
+		code.append(new ScopeEncoder(pw -> writer(pw, entry.function), Accessibility.EXTERNAL, functionsWritten).apply(scope));
+		code.append("\n");
+		if (!written) functionsWritten.remove(scope.getName());
+
+		entries.add(entry);
+		return new AsyncInstructionSet(entry, this::getCompilation);
+	}
+
+	/**
+	 * Begin compiling the library for all of the {@link Scope}s that have been added.
+	 */
+	public synchronized CompletableFuture<Void> compile() {
+		if (compilation == null) {
+			compilation = compiler.compileAsync(name, code.toString(), true).thenRun(this::resolve);
+		}
+
+		return compilation;
+	}
+
+	private static CPrintWriter writer(PrintWriter pw, String function) {
+		CPrintWriter writer = new CPrintWriter(pw, function);
+		writer.setArgumentAlignment(NativeMemoryProvider.getAlignment(Hardware.getLocalHardware().getMemoryProvider()));
+		return writer;
+	}
+
+	protected synchronized CompletableFuture<Void> getCompilation() {
+		return compilation == null ? compile() : compilation;
+	}
+
+	protected void resolve() {
+		String library = compiler.getLibraryFile(name);
+
+		for (Entry entry : entries) {
+			entry.pointer = symbol().apply(library, entry.function);
+
+			if (entry.pointer == 0) {
+				throw new HardwareException("Unable to resolve " + entry.function + " in " + library);
+			}
+		}
+	}
+
+	private static NativeSymbol symbol() {
+		if (symbol == null) {
+			synchronized (NativeOperationGroup.class) {
+				if (symbol == null) symbol = new NativeSymbol();
+			}
+		}
+
+		return symbol;
+	}
+
+	private static NativeDispatch dispatch() {
+		if (dispatch == null) {
+			synchronized (NativeOperationGroup.class) {
+				if (dispatch == null) dispatch = new NativeDispatch();
+			}
+		}
+
+		return dispatch;
+	}
+
+	/**
+	 * The address of the function that the specified {@link NativeInstructionSet}
+	 * invokes, if it is part of a {@link NativeOperationGroup} which has been
+	 * compiled, or zero otherwise.
+	 */
+	public static long getFunctionPointer(NativeInstructionSet instructions) {
+		return instructions instanceof Entry ? ((Entry) instructions).pointer : 0;
+	}
+
+	/** Returns true if the specified {@link NativeInstructionSet} is part of a {@link NativeOperationGroup}. */
+	public static boolean isGrouped(NativeInstructionSet instructions) {
+		return instructions instanceof Entry;
+	}
+
+	private static class Entry implements NativeInstructionSet {
+		private final String function;
+		private volatile long pointer;
+
+		Entry(String function) {
+			this.function = function;
+		}
+
+		@Override
+		public String getFunctionName() { return function; }
+
+		@Override
+		public void apply(long commandQueue, long arg[], int offset[], int size[], int count) {
+			if (pointer == 0) {
+				throw new HardwareException(function + " has not been loaded");
+			}
+
+			dispatch().apply(pointer, commandQueue, arg, offset, size, count);
+		}
+	}
+}
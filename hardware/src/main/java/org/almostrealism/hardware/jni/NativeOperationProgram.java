@@ -0,0 +1,173 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.jni;
+
+import io.almostrealism.code.InstructionSet;
+import org.almostrealism.c.NativeProgram;
+import org.almostrealism.hardware.AcceleratedComputationOperation;
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.RAM;
+import org.almostrealism.hardware.profile.Profiler;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.StringJoiner;
+
+/**
+ * A {@link NativeOperationProgram} runs a sequence of operations from a
+ * {@link NativeOperationGroup} with a single JNI call (see {@link NativeProgram}).
+ * This is only possible for operations whose arguments are all fixed (see
+ * {@link AcceleratedComputationOperation#getFixedArguments()}), so that the
+ * arguments never need to be evaluated between the operations. The arrays of
+ * arguments are allocated once, and only refilled from the {@link MemoryData}
+ * before each run, in case any of them has been moved to different memory.
+ * Each run is recorded by the {@link Profiler} as one {@link Profiler.Category#NATIVE}
+ * operation, named after the instruction sets it runs.
+ */
+public class NativeOperationProgram implements Runnable {
+	private static volatile NativeProgram program;
+
+	private final List<AcceleratedComputationOperation<?>> operations;
+	private final MemoryData arguments[][];
+
+	private String name;
+	private long functions[];
+	private long args[];
+	private int offsets[], sizes[], counts[];
+
+	protected NativeOperationProgram(List<AcceleratedComputationOperation<?>> operations, List<MemoryData[]> arguments) {
+		this.operations = operations;
+		this.arguments = arguments.toArray(new MemoryData[0][]);
+	}
+
+	public List<AcceleratedComputationOperation<?>> getOperations() { return operations; }
+
+	protected synchronized void init() {
+		if (functions != null) return;
+
+		long f[] = new long[operations.size()];
+		int c[] = new int[operations.size()];
+		StringJoiner n = new StringJoiner(", ", getClass().getSimpleName() + "(", ")");
+
+		for (int i = 0; i < f.length; i++) {
+			AsyncInstructionSet instructions = (AsyncInstructionSet) operations.get(i).getInstructionSet();
+			instructions.await();
+			f[i] = NativeOperationGroup.getFunctionPointer(instructions.getTarget());
+			c[i] = arguments[i].length;
+			n.add(instructions.getTarget().getClass().getSimpleName());
+		}
+
+		int total = 0;
+		for (int count : c) total += count;
+
+		args = new long[total];
+		offsets = new int[total];
+		sizes = new int[total];
+		counts = c;
+		name = n.toString();
+		functions = f;
+	}
+
+	@Override
+	public synchronized void run() {
+		init();
+
+		int pos = 0;
+
+		for (MemoryData op[] : arguments) {
+			for (MemoryData arg : op) {
+				args[pos] = ((RAM) arg.getMem()).getNativePointer();
+				offsets[pos] = arg.getOffset();
+				sizes[pos] = arg.getMemLength();
+				pos++;
+			}
+		}
+
+		long start = Profiler.start();
+		program().apply(functions, args, offsets, sizes, counts, functions.length);
+		Profiler.record(Profiler.Category.NATIVE, name, start, 0);
+	}
+
+	/**
+	 * Replace every sequence of two or more consecutive operations which can be
+	 * run by a {@link NativeOperationProgram} with a single program, leaving
+	 * the order of everything in the list unchanged.
+	 */
+	public static List<Runnable> fuse(List<Runnable> run) {
+		List<Runnable> result = new ArrayList<>();
+		List<AcceleratedComputationOperation<?>> ops = new ArrayList<>();
+		List<MemoryData[]> args = new ArrayList<>();
+
+		for (Runnable r : run) {
+			MemoryData a[] = fixedArguments(r);
+
+			if (a == null) {
+				end(result, ops, args);
+				result.add(r);
+			} else {
+				ops.add((AcceleratedComputationOperation<?>) r);
+				args.add(a);
+			}
+		}
+
+		end(result, ops, args);
+		return result;
+	}
+
+	private static void end(List<Runnable> result, List<AcceleratedComputationOperation<?>> ops, List<MemoryData[]> args) {
+		if (ops.size() > 1) {
+			result.add(new NativeOperationProgram(new ArrayList<>(ops), new ArrayList<>(args)));
+		} else {
+			result.addAll(ops);
+		}
+
+		ops.clear();
+		args.clear();
+	}
+
+	/**
+	 * The arguments for the specified operation, if it can be included in a
+	 * {@link NativeOperationProgram}, or null otherwise.
+	 */
+	protected static MemoryData[] fixedArguments(Runnable r) {
+		if (!(r instanceof AcceleratedComputationOperation)) return null;
+
+		AcceleratedComputationOperation<?> op = (AcceleratedComputationOperation<?>) r;
+		InstructionSet instructions = op.getInstructionSet();
+		if (!(instructions instanceof AsyncInstructionSet)) return null;
+		if (!NativeOperationGroup.isGrouped(((AsyncInstructionSet) instructions).getTarget())) return null;
+
+		MemoryData args[] = op.getFixedArguments();
+		if (args == null) return null;
+
+		for (MemoryData arg : args) {
+			if (!(arg.getMem() instanceof RAM)) return null;
+		}
+
+		return args;
+	}
+
+	private static NativeProgram program() {
+		if (program == null) {
+			synchronized (NativeOperationProgram.class) {
+				if (program == null) program = new NativeProgram();
+			}
+		}
+
+		return program;
+	}
+}
@@ -34,7 +34,13 @@ public abstract class MemoryDataAdapter implements MemoryData {
 			PooledMem pool = getDefaultDelegate();
 
 			if (pool == null) {
-				mem = Hardware.getLocalHardware().getMemoryProvider().allocate(getMemLength());
+				MemoryPoolAllocator allocator = this instanceof PooledMem ? null : MemoryPoolAllocator.getLocal();
+
+				if (allocator != null && allocator.reserve(this)) {
+					setMem(new double[getMemLength()]);
+				} else {
+					mem = Hardware.getLocalHardware().getMemoryProvider().allocate(getMemLength());
+				}
 			} else {
 				setDelegate(pool, pool.reserveOffset(this));
 				setMem(new double[getMemLength()]);
@@ -62,7 +68,11 @@ public abstract class MemoryDataAdapter implements MemoryData {
 
 	@Override
 	public void destroy() {
-		if (mem == null) return;
+		if (mem == null) {
+			MemoryPoolAllocator.release(this);
+			return;
+		}
+
 		if (delegateMem != null) {
 			System.out.println("WARN: MemoryData has a delegate, but also directly reserved memory");
 		}
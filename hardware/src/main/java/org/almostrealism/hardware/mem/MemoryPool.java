@@ -18,12 +18,17 @@ package org.almostrealism.hardware.mem;
 
 import org.almostrealism.hardware.MemoryData;
 import org.almostrealism.hardware.PooledMem;
+import org.almostrealism.io.SystemUtils;
 
+import java.lang.ref.Reference;
+import java.lang.ref.ReferenceQueue;
 import java.lang.ref.WeakReference;
-import java.util.ArrayList;
-import java.util.Iterator;
-import java.util.List;
-import java.util.concurrent.ArrayBlockingQueue;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicIntegerArray;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.AtomicReferenceArray;
 import java.util.function.Function;
 import java.util.stream.IntStream;
 
@@ -32,15 +37,38 @@ import java.util.stream.IntStream;
  * which uses {@link WeakReference}s to determine if a segment of the reserved
  * memory can be reused.
  *
+ * The segments which are available are kept in a lock free stack, and the
+ * reference to the owner of each reserved segment is registered with a
+ * {@link ReferenceQueue}, so that a segment is returned to the stack as soon
+ * as its owner is collected rather than by searching every reservation.
+ * The queue is shared by every pool, and a single daemon thread waits on it,
+ * while reservations also drain the queue when the stack is empty.
+ * When {@link #enableThreadCache} is set, each thread takes segments from
+ * the stack in small batches to reduce contention between threads. The
+ * segments held by a thread are returned to the stack when the pool is
+ * exhausted and after the thread has ended.
+ *
  * @author  Michael Murray
  */
 public class MemoryPool<T extends MemoryData> extends MemoryBankAdapter<T> implements PooledMem<T> {
 	public static boolean enableLog = false;
+	public static boolean enableThreadCache = SystemUtils.isEnabled("AR_HARDWARE_POOL_THREAD_CACHE").orElse(false);
+
+	/** The number of milliseconds that a reservation will wait for an owner to be collected when the pool is full. */
+	public static long exhaustionTimeout = Long.parseLong(SystemUtils.getProperty("AR_HARDWARE_POOL_TIMEOUT", "100"));
+
+	private static final int THREAD_CACHE_SIZE = 16;
+
+	private static final ReferenceQueue<Object> queue = new ReferenceQueue<>();
+	private static final Set<SlotCache> caches = ConcurrentHashMap.newKeySet();
+	private static Thread reclaimer;
 
-	private ArrayBlockingQueue<Integer> available;
-	private List<Owner> owners;
-	private int defaultGc;
-	private boolean destroying;
+	private SlotStack available;
+	private AtomicReferenceArray<Owner<T>> owners;
+	private ThreadLocal<SlotCache> cache;
+
+	private AtomicLong reserved, peak, reservations, reclaimed, exhaustions;
+	private volatile boolean destroying;
 
 	/**
 	 * Create a {@link MemoryPool}.
@@ -60,18 +88,29 @@ public class MemoryPool<T extends MemoryData> extends MemoryBankAdapter<T> imple
 	 */
 	protected MemoryPool(int memLength, int size, Function<DelegateSpec, T> supply) {
 		super(memLength, size, supply, CacheLevel.NONE);
-		defaultGc = size > 200 ? size / 200 : 1;
 		initQueue();
 	}
 
 	protected void initQueue() {
 		if (available != null) return;
 
-		this.available = new ArrayBlockingQueue<>(getCount());
-		IntStream.range(0, getCount()).map(i -> i * getAtomicMemLength()).forEach(available::add);
-		owners = new ArrayList<>();
+		available = new SlotStack(getCount());
+		owners = new AtomicReferenceArray<>(getCount());
+		reserved = new AtomicLong();
+		peak = new AtomicLong();
+		reservations = new AtomicLong();
+		reclaimed = new AtomicLong();
+		exhaustions = new AtomicLong();
+
+		if (enableThreadCache && getCount() >= THREAD_CACHE_SIZE * 64) {
+			cache = ThreadLocal.withInitial(() -> {
+				SlotCache c = new SlotCache(available);
+				caches.add(c);
+				return c;
+			});
+		}
 
-		startGcThread();
+		startReclaimer();
 	}
 
 	/**
@@ -82,91 +121,321 @@ public class MemoryPool<T extends MemoryData> extends MemoryBankAdapter<T> imple
 	 * @return  The index of the start of the reserved segment.
 	 */
 	@Override
-	public synchronized int reserveOffset(T owner) {
+	public int reserveOffset(T owner) {
 		if (destroying) {
 			throw new UnsupportedOperationException();
 		}
 
-		Owner o = owner(owner);
-		owners.add(o);
-		return o.offset;
+		return reserve(owner, nextSlot(true));
 	}
 
-	protected synchronized Owner owner(T owner) {
-		try {
-			Owner o = new Owner();
-			o.reference = new WeakReference<>(owner);
-
-			Integer next = available.poll();
-			if (next == null) {
-				gc();
-				o.offset = available.remove();
-			} else {
-				o.offset = next;
-			}
+	/**
+	 * Reserve a segment of memory, if one is available without waiting
+	 * for the owner of another segment to be collected.
+	 *
+	 * @return  The index of the start of the reserved segment, or -1 if
+	 *          there is no segment available or the pool is destroyed.
+	 */
+	public int tryReserveOffset(T owner) {
+		if (destroying) return -1;
+
+		int slot = nextSlot(false);
+		return slot < 0 ? -1 : reserve(owner, slot);
+	}
+
+	/**
+	 * Return the segment at the specified offset to the pool before its owner
+	 * is collected, if it is still reserved by the specified owner.
+	 *
+	 * @return  True if the segment was returned.
+	 */
+	public boolean release(T owner, int offset) {
+		int slot = offset / getAtomicMemLength();
+		if (slot < 0 || slot >= owners.length()) return false;
+
+		Owner<T> o = owners.get(slot);
+		if (o == null || o.get() != owner) return false;
+
+		o.clear();
+		return release(o);
+	}
+
+	private int reserve(T owner, int slot) {
+		owners.set(slot, new Owner<>(owner, this, slot));
+
+		long r = reserved.incrementAndGet();
+		if (r > peak.get()) peak.accumulateAndGet(r, Math::max);
+		reservations.incrementAndGet();
+		return slot * getAtomicMemLength();
+	}
+
+	private int nextSlot(boolean wait) {
+		SlotCache c = cache == null ? null : cache.get();
+
+		if (c != null) {
+			int slot = c.take();
+			if (slot >= 0) return slot;
+		}
+
+		int slot = available.pop();
+		if (slot >= 0) return slot;
+
+		exhaustions.incrementAndGet();
+		gc();
+		drainCaches();
+
+		slot = available.pop();
+		if (slot >= 0 || !wait) return slot;
 
-			return o;
-		} catch (Exception e) {
-			throw new RuntimeException("Pool exhausted", e);
+		try {
+			Reference<?> ref = queue.remove(exhaustionTimeout);
+			if (ref != null) reclaim(ref);
+		} catch (InterruptedException e) {
+			Thread.currentThread().interrupt();
 		}
+
+		slot = available.pop();
+		if (slot >= 0) return slot;
+
+		throw new RuntimeException("Pool exhausted");
 	}
 
 	@Override
 	public synchronized void destroy() {
 		destroying = true;
-		owners.forEach(o -> {
-			T target = o.reference.get();
+
+		for (int i = 0; i < owners.length(); i++) {
+			Owner<T> o = owners.getAndSet(i, null);
+			T target = o == null ? null : o.get();
 			if (target != null) target.destroy();
-		});
-		owners.clear();
+		}
+
+		caches.removeIf(c -> c.stack == available);
 		available.clear();
 		super.destroy();
 	}
 
-	public synchronized void gc() { gc(defaultGc); }
+	/**
+	 * Return every segment whose owner has been collected to its pool.
+	 */
+	public void gc() { gc(Integer.MAX_VALUE); }
 
-	public synchronized void gc(int demand) {
+	/**
+	 * Return every segment whose owner has been collected to its pool,
+	 * without logging on behalf of any one pool.
+	 *
+	 * @return  The number of segments which were returned.
+	 */
+	public static int gcAll() {
 		int freed = 0;
 
-		Iterator<Owner> itr = owners.iterator();
-		w: while (itr.hasNext()) {
-			Owner o = itr.next();
-			if (o.reference.get() != null) continue w;
+		Reference<?> ref;
+		while ((ref = queue.poll()) != null) {
+			if (reclaim(ref)) freed++;
+		}
 
-			itr.remove();
-			available.add(o.offset);
-			freed++;
+		return freed;
+	}
 
-			if (freed >= demand) break w;
+	/**
+	 * Return segments whose owners have been collected to their pools,
+	 * stopping after the specified number. The queue is shared, so the
+	 * segments may belong to any pool.
+	 */
+	public void gc(int demand) {
+		int freed = 0;
+
+		while (freed < demand) {
+			Reference<?> ref = queue.poll();
+			if (ref == null) break;
+			if (reclaim(ref)) freed++;
 		}
 
 		if (enableLog) System.out.println(gcLog(freed, demand));
 	}
 
+	/**
+	 * Return the segments held by every thread cache of this pool to the stack.
+	 */
+	private void drainCaches() {
+		for (SlotCache c : caches) {
+			if (c.stack == available) c.drain();
+		}
+	}
+
+	@SuppressWarnings("unchecked")
+	private static boolean reclaim(Reference<?> ref) {
+		Owner<?> o = (Owner<?>) ref;
+		return o.pool.release((Owner) o);
+	}
+
+	private boolean release(Owner<T> o) {
+		if (destroying || !owners.compareAndSet(o.slot, o, null)) return false;
+
+		reserved.decrementAndGet();
+		reclaimed.incrementAndGet();
+		available.push(o.slot);
+		return true;
+	}
+
+	/** The number of segments in this pool. */
+	public int getCapacity() { return getCount(); }
+
+	/** The number of segments which are currently reserved. */
+	public long getReserved() { return reserved.get(); }
+
+	/** The largest number of segments which have been reserved at once. */
+	public long getPeakReserved() { return peak.get(); }
+
+	/** The fraction of the segments in this pool which are currently reserved. */
+	public double getOccupancy() { return getCount() == 0 ? 0.0 : reserved.get() / (double) getCount(); }
+
+	/** The total number of reservations which have been made. */
+	public long getReservations() { return reservations.get(); }
+
+	/** The total number of segments which have been returned to the pool. */
+	public long getReclaimed() { return reclaimed.get(); }
+
+	/** The number of reservations which found no segment available without reclaiming one. */
+	public long getExhaustions() { return exhaustions.get(); }
+
 	private String gcLog(int freed, int demand) {
-		return getClass().getSimpleName() + ": Freed " + freed + "/" + demand;
+		return getClass().getSimpleName() + ": Freed " + freed + "/" + demand +
+				" (" + reserved.get() + "/" + getCount() + " reserved)";
 	}
 
-	private void startGcThread() {
-		Thread t = new Thread(() -> {
-			try {
-				Thread.sleep(30000);
-			} catch (InterruptedException e) {
-				e.printStackTrace();
+	/**
+	 * Start the thread which returns segments to their pools as the owners are
+	 * collected, if it is not already running. There is only one thread for all
+	 * pools, and it also returns the segments held by the caches of threads
+	 * which have ended.
+	 */
+	private static synchronized void startReclaimer() {
+		if (reclaimer != null) return;
+
+		reclaimer = new Thread(() -> {
+			while (true) {
+				try {
+					Reference<?> ref = queue.remove(TimeUnit.SECONDS.toMillis(1));
+
+					if (ref == null) {
+						caches.removeIf(c -> c.isAbandoned() && c.drain());
+					} else {
+						reclaim(ref);
+					}
+				} catch (InterruptedException e) {
+					return;
+				}
 			}
+		}, "MemoryPool GC Thread");
+		reclaimer.setDaemon(true);
+		reclaimer.start();
+	}
+
+	private static class Owner<T> extends WeakReference<T> {
+		private final MemoryPool<?> pool;
+		private final int slot;
+
+		public Owner(T referent, MemoryPool<?> pool, int slot) {
+			super(referent, queue);
+			this.pool = pool;
+			this.slot = slot;
+		}
+	}
+
+	/**
+	 * A batch of slots taken from the {@link SlotStack} by one thread. The batch
+	 * can be returned to the stack by any thread.
+	 */
+	private static class SlotCache {
+		private final SlotStack stack;
+		private final WeakReference<Thread> thread;
+		private final int slots[] = new int[THREAD_CACHE_SIZE];
+		private int size;
+
+		public SlotCache(SlotStack stack) {
+			this.stack = stack;
+			this.thread = new WeakReference<>(Thread.currentThread());
+		}
 
-			if (destroying) {
-				return;
+		public synchronized int take() {
+			if (size == 0) {
+				while (size < slots.length) {
+					int slot = stack.pop();
+					if (slot < 0) break;
+					slots[size++] = slot;
+				}
 			}
 
-			gc();
-		}, getClass().getSimpleName() + " GC Thread");
-		t.setDaemon(true);
-		t.start();
+			return size > 0 ? slots[--size] : -1;
+		}
+
+		/** Return every slot in this cache to the stack, and always return true. */
+		public synchronized boolean drain() {
+			while (size > 0) stack.push(slots[--size]);
+			return true;
+		}
+
+		public boolean isAbandoned() {
+			Thread t = thread.get();
+			return t == null || !t.isAlive();
+		}
 	}
 
-	private class Owner {
-		public WeakReference<T> reference;
-		public Integer offset;
+	/**
+	 * A lock free stack of slot indices, each of which is linked to the next
+	 * one using an array. The head includes a version number which changes
+	 * every time it is replaced, so that a pop can not succeed using a next
+	 * slot that was read before the stack was changed by another thread.
+	 */
+	private static class SlotStack {
+		private static final long SLOT_MASK = 0xFFFFFFFFL;
+
+		private final AtomicIntegerArray next;
+		private final AtomicLong head;
+
+		public SlotStack(int size) {
+			next = new AtomicIntegerArray(size);
+			IntStream.range(0, size).forEach(i -> next.set(i, i + 1 < size ? i + 1 : -1));
+			head = new AtomicLong(head(0, size > 0 ? 0 : -1));
+		}
+
+		public int pop() {
+			while (true) {
+				long h = head.get();
+				int slot = slot(h);
+				if (slot < 0) return -1;
+
+				if (head.compareAndSet(h, head(version(h) + 1, next.get(slot)))) {
+					return slot;
+				}
+			}
+		}
+
+		public void push(int slot) {
+			while (true) {
+				long h = head.get();
+				next.set(slot, slot(h));
+
+				if (head.compareAndSet(h, head(version(h) + 1, slot))) {
+					return;
+				}
+			}
+		}
+
+		public void clear() {
+			while (true) {
+				long h = head.get();
+				if (head.compareAndSet(h, head(version(h) + 1, -1))) return;
+			}
+		}
+
+		private static long head(int version, int slot) {
+			return ((long) version << 32) | ((slot + 1) & SLOT_MASK);
+		}
+
+		private static int version(long head) { return (int) (head >>> 32); }
+
+		private static int slot(long head) { return (int) (head & SLOT_MASK) - 1; }
 	}
 }
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.mem;
+
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.ctx.ContextSpecific;
+import org.almostrealism.hardware.ctx.DefaultContextSpecific;
+
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Optional;
+
+/**
+ * A {@link MemoryPoolAllocator} provides the memory for {@link MemoryData}s which
+ * do not have a delegate by reserving a segment of a much larger {@link Slab}, so
+ * that the {@link io.almostrealism.code.MemoryProvider} is only asked to allocate
+ * a new region of memory occasionally. Every request is rounded up to a power of
+ * two, and each of these size classes has its own list of slabs, which are added
+ * as they are needed until the total size of the slabs reaches the
+ * {@link Hardware#getPoolBudget() pool budget}. Requests which are too large for
+ * any size class, or which can not be satisfied within the budget, are left to
+ * the provider.
+ *
+ * Segments are returned to their slab when the {@link MemoryData} is destroyed
+ * or collected. Every reservation adds its size to a debt, and when the debt
+ * reaches a quarter of the budget it is repaid by destroying the slabs that have
+ * no reservations, so that memory which was needed for a burst of activity is
+ * eventually returned to the provider.
+ *
+ * There is one allocator for each data context, and it is not used with external
+ * execution, which transfers the whole of the root memory of every argument.
+ */
+public class MemoryPoolAllocator {
+	public static boolean enableVerbose = false;
+
+	/** The smallest size class, in numbers. */
+	public static final int MIN_SIZE = 4;
+
+	/** The largest size class, in numbers. */
+	public static final int MAX_SIZE = 1 << 20;
+
+	/** The size, in numbers, of the slabs for all of the size classes smaller than it. */
+	public static final int SLAB_SIZE = 1 << 20;
+
+	private static volatile ContextSpecific<MemoryPoolAllocator> local;
+	private static volatile boolean initialized;
+
+	private final long budget;
+	private final int numberSize;
+	private final SizeClass classes[];
+
+	private long allocated;
+	private long debt;
+
+	/**
+	 * Create a {@link MemoryPoolAllocator} which will not allocate more than
+	 * the specified number of bytes for its slabs.
+	 */
+	public MemoryPoolAllocator(long budget, int numberSize) {
+		this.budget = budget;
+		this.numberSize = numberSize;
+		this.classes = new SizeClass[Integer.numberOfTrailingZeros(MAX_SIZE / MIN_SIZE) + 1];
+		for (int i = 0; i < classes.length; i++) classes[i] = new SizeClass(MIN_SIZE << i);
+	}
+
+	/**
+	 * Reserve memory for the specified {@link MemoryData}, assigning it a segment
+	 * of one of the slabs as its delegate.
+	 *
+	 * @return  True if the memory was reserved, or false if the provider should
+	 *          allocate the memory instead.
+	 */
+	public boolean reserve(MemoryData owner) {
+		return reserve(owner, true);
+	}
+
+	private boolean reserve(MemoryData owner, boolean retry) {
+		int size = owner.getMemLength();
+		if (size <= 0 || size > MAX_SIZE) return false;
+
+		SizeClass c = classes[sizeClass(size)];
+		Slab slab = null;
+		int offset = -1;
+
+		synchronized (c) {
+			Iterator<Slab> itr = c.slabs.iterator();
+
+			while (offset < 0 && itr.hasNext()) {
+				slab = itr.next();
+				offset = slab.tryReserveOffset(owner);
+			}
+
+			if (offset < 0) {
+				slab = addSlab(c);
+				if (slab != null) offset = slab.tryReserveOffset(owner);
+			}
+		}
+
+		if (offset < 0) {
+			if (!retry) return false;
+
+			// The budget is exhausted, so remove the slabs
+			// of other size classes that are no longer used
+			trim();
+			return reserve(owner, false);
+		}
+
+		owner.setDelegate(slab, offset);
+		if (addDebt(c.size)) trim();
+		return true;
+	}
+
+	/**
+	 * Return the segment reserved for the specified {@link MemoryData}, if it
+	 * was reserved by {@link #reserve(MemoryData)}.
+	 */
+	public static boolean release(MemoryData owner) {
+		if (!(owner.getDelegate() instanceof Slab)) return false;
+		return ((Slab) owner.getDelegate()).release(owner, owner.getDelegateOffset());
+	}
+
+	/**
+	 * Destroy every slab which has no reservations.
+	 */
+	public void trim() {
+		int freed = 0;
+
+		// The slabs share one reference queue, so
+		// it only needs to be drained once
+		MemoryPool.gcAll();
+
+		for (SizeClass c : classes) {
+			synchronized (c) {
+				Iterator<Slab> itr = c.slabs.iterator();
+
+				while (itr.hasNext()) {
+					Slab s = itr.next();
+
+					if (s.getReserved() == 0) {
+						itr.remove();
+						s.destroy();
+						free(s);
+						freed++;
+					}
+				}
+			}
+		}
+
+		if (enableVerbose) {
+			System.out.println("MemoryPoolAllocator: Destroyed " + freed + " slabs (" + getAllocated() / 1024 / 1024 + "MB allocated)");
+		}
+	}
+
+	/** Destroy every slab, regardless of whether it has reservations. */
+	public void destroy() {
+		for (SizeClass c : classes) {
+			synchronized (c) {
+				c.slabs.forEach(s -> {
+					s.destroy();
+					free(s);
+				});
+				c.slabs.clear();
+			}
+		}
+	}
+
+	/** The total number of bytes of the slabs which currently exist. */
+	public synchronized long getAllocated() { return allocated; }
+
+	/** The total number of bytes of the segments which are currently reserved. */
+	public long getReserved() {
+		long reserved = 0;
+
+		for (SizeClass c : classes) {
+			synchronized (c) {
+				for (Slab s : c.slabs) reserved += s.getReserved() * c.size * (long) numberSize;
+			}
+		}
+
+		return reserved;
+	}
+
+	public long getBudget() { return budget; }
+
+	protected Slab addSlab(SizeClass c) {
+		int count = Math.max(1, SLAB_SIZE / c.size);
+		long bytes = (long) count * c.size * numberSize;
+
+		if (!allocate(bytes)) return null;
+
+		Slab s = new Slab(c.size, count);
+		c.slabs.add(s);
+		if (enableVerbose) System.out.println("MemoryPoolAllocator: Added slab of " + count + " x " + c.size);
+		return s;
+	}
+
+	private synchronized boolean allocate(long bytes) {
+		if (allocated + bytes > budget) return false;
+		allocated += bytes;
+		return true;
+	}
+
+	private synchronized void free(Slab s) {
+		allocated -= (long) s.getMemLength() * numberSize;
+	}
+
+	private synchronized boolean addDebt(int size) {
+		debt += (long) size * numberSize;
+		if (debt < budget / 4) return false;
+		debt = 0;
+		return true;
+	}
+
+	protected static int sizeClass(int size) {
+		int c = 0;
+		while ((MIN_SIZE << c) < size) c++;
+		return c;
+	}
+
+	/**
+	 * Returns the {@link MemoryPoolAllocator} for the current data context, or
+	 * null if there is no pool budget.
+	 */
+	public static MemoryPoolAllocator getLocal() {
+		initAllocator();
+		return Optional.ofNullable(local).map(ContextSpecific::getValue).orElse(null);
+	}
+
+	private static void initAllocator() {
+		// When there is no budget, this is the only check on the
+		// allocation path, so it must not require the lock
+		if (initialized) return;
+		doInitAllocator();
+	}
+
+	private static synchronized void doInitAllocator() {
+		if (initialized) return;
+
+		Hardware hardware = Hardware.getLocalHardware();
+
+		if (hardware.getPoolBudget() > 0 && !hardware.isExternalNative()) {
+			ContextSpecific<MemoryPoolAllocator> allocator =
+					new DefaultContextSpecific<>(() -> new MemoryPoolAllocator(hardware.getPoolBudget(), hardware.getNumberSize()),
+							MemoryPoolAllocator::destroy);
+			allocator.init();
+			local = allocator;
+		}
+
+		initialized = true;
+	}
+
+	protected static class SizeClass {
+		private final int size;
+		private final List<Slab> slabs;
+
+		public SizeClass(int size) {
+			this.size = size;
+			this.slabs = new ArrayList<>();
+		}
+	}
+
+	/**
+	 * A single region of memory allocated by the provider, which is divided into
+	 * segments that are all the size of one size class. Slabs do not have their
+	 * own threads; the segments of every slab are reclaimed by the thread which
+	 * is shared by all {@link MemoryPool}s.
+	 */
+	public static class Slab extends MemoryPool<MemoryData> {
+		public Slab(int memLength, int size) {
+			super(memLength, size);
+		}
+	}
+}
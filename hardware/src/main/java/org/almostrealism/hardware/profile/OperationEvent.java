@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.profile;
+
+import jdk.jfr.Category;
+import jdk.jfr.DataAmount;
+import jdk.jfr.Description;
+import jdk.jfr.Label;
+import jdk.jfr.Name;
+import jdk.jfr.StackTrace;
+import jdk.jfr.Timespan;
+
+/**
+ * A Java Flight Recorder event for one run of an operation recorded by the {@link Profiler}.
+ */
+@Name("org.almostrealism.hardware.Operation")
+@Label("Operation")
+@Category("Almost Realism")
+@Description("A run of an accelerated operation")
+@StackTrace(false)
+public class OperationEvent extends jdk.jfr.Event {
+	@Label("Category")
+	public String category;
+
+	@Label("Operation")
+	public String operation;
+
+	@Label("Duration")
+	@Timespan(Timespan.NANOSECONDS)
+	public long duration;
+
+	@Label("Bytes")
+	@DataAmount
+	public long bytes;
+}
@@ -16,32 +16,118 @@
 
 package org.almostrealism.hardware.profile;
 
-import java.util.ArrayList;
-import java.util.List;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.AtomicLongArray;
+import java.util.concurrent.atomic.LongAdder;
 
+/**
+ * Statistics for the runs of one operation. Runs can be added from any number
+ * of threads without locking, and the memory used does not grow with the number
+ * of runs: durations are kept in a fixed histogram with four buckets for each
+ * power of two, so percentiles are accurate to within 25%.
+ */
 public class ProfileData {
-	private List<RunData> runs;
+	private static final int SUB_BUCKET_BITS = 2;
+	private static final int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	private static final int BUCKETS = 64 * SUB_BUCKETS;
+
+	private final LongAdder runs;
+	private final LongAdder totalNanos;
+	private final LongAdder totalBytes;
+	private final AtomicLong maxNanos;
+	private final AtomicLongArray histogram;
 
 	public ProfileData() {
-		this.runs = new ArrayList<>();
+		this.runs = new LongAdder();
+		this.totalNanos = new LongAdder();
+		this.totalBytes = new LongAdder();
+		this.maxNanos = new AtomicLong();
+		this.histogram = new AtomicLongArray(BUCKETS);
+	}
+
+	public void addRun(RunData run) { addRun(run.getDurationNanos(), run.getBytes()); }
+
+	public void addRun(long durationNanos, long bytes) {
+		long d = Math.max(0, durationNanos);
+		runs.increment();
+		totalNanos.add(d);
+		if (bytes > 0) totalBytes.add(bytes);
+		histogram.incrementAndGet(bucket(d));
+		maxNanos.accumulateAndGet(d, Math::max);
 	}
 
-	public void addRun(RunData run) { runs.add(run); }
+	public int getTotalRuns() { return (int) Math.min(Integer.MAX_VALUE, runs.sum()); }
 
-	public int getTotalRuns() { return runs.size(); }
+	public long getRuns() { return runs.sum(); }
 
 	public double getAverageRuntimeNanos() {
-		return getTotalRuntimeNanos() / runs.size();
+		long count = runs.sum();
+		return count == 0 ? 0 : totalNanos.sum() / (double) count;
 	}
 
-	public double getTotalRuntimeNanos() {
-		return runs.stream().mapToDouble(RunData::getDurationNanos).sum();
+	public double getTotalRuntimeNanos() { return totalNanos.sum(); }
+
+	public long getTotalBytes() { return totalBytes.sum(); }
+
+	public long getMaxRuntimeNanos() { return maxNanos.get(); }
+
+	/**
+	 * An estimate of the specified percentile (between 0 and 100) of the
+	 * durations of the runs, which is the upper bound of the histogram
+	 * bucket that contains it.
+	 */
+	public long getPercentileNanos(double percentile) {
+		long counts[] = new long[BUCKETS];
+		long total = 0;
+
+		for (int i = 0; i < BUCKETS; i++) {
+			counts[i] = histogram.get(i);
+			total += counts[i];
+		}
+
+		if (total == 0) return 0;
+
+		long rank = (long) Math.ceil(total * Math.min(100, Math.max(0, percentile)) / 100.0);
+		long seen = 0;
+
+		for (int i = 0; i < BUCKETS; i++) {
+			seen += counts[i];
+			if (seen >= rank && counts[i] > 0) return Math.min(upperBound(i), getMaxRuntimeNanos());
+		}
+
+		return getMaxRuntimeNanos();
+	}
+
+	public void reset() {
+		runs.reset();
+		totalNanos.reset();
+		totalBytes.reset();
+		maxNanos.set(0);
+		for (int i = 0; i < BUCKETS; i++) histogram.set(i, 0);
 	}
 
 	public String getSummaryString() {
-		int count = runs.size();
-		double totalSeconds = getTotalRuntimeNanos() * Math.pow(10, -6);
+		long count = runs.sum();
+		double totalSeconds = getTotalRuntimeNanos() * Math.pow(10, -9);
 		double averageNanos = getAverageRuntimeNanos();
-		return averageNanos + " nanoseconds average - " + count + " executions for " + totalSeconds + " seconds total";
+		return averageNanos + " nanoseconds average (p50 " + getPercentileNanos(50) + ", p99 " + getPercentileNanos(99) +
+				") - " + count + " executions for " + totalSeconds + " seconds total";
+	}
+
+	private static int bucket(long nanos) {
+		if (nanos < SUB_BUCKETS) return (int) nanos;
+
+		int exp = 63 - Long.numberOfLeadingZeros(nanos);
+		int sub = (int) (nanos >>> (exp - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+		return (exp - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+	}
+
+	private static long upperBound(int bucket) {
+		if (bucket < SUB_BUCKETS) return bucket;
+
+		int exp = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+		long width = 1L << (exp - SUB_BUCKET_BITS);
+		long lower = (SUB_BUCKETS + bucket % SUB_BUCKETS) * width;
+		return lower + width - 1;
 	}
 }
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.profile;
+
+import org.almostrealism.io.SystemUtils;
+
+import javax.management.ObjectName;
+import java.lang.management.ManagementFactory;
+import java.util.Collections;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+
+/**
+ * A registry of {@link ProfileData} for the operations of every backend, which
+ * includes OpenCL kernels (when the queue is created with profiling enabled,
+ * regardless of {@link #enableProfiling}),
+ * JNI invocations, external executable runs, transfers of memory, and the time
+ * spent compiling native code. The results are available from {@link #getProfiles()},
+ * from JMX (see {@link ProfilerMXBean}), and as {@link OperationEvent}s in Java
+ * Flight Recorder. When profiling is disabled, recording costs a single check of
+ * {@link #enableProfiling}.
+ */
+public class Profiler {
+	public static boolean enableProfiling = SystemUtils.isEnabled("AR_HARDWARE_PROFILING").orElse(false);
+
+	/** If enabled, the {@link ProfilerMXBean} is registered when profiling data is first recorded. */
+	public static boolean enableJmx = SystemUtils.isEnabled("AR_HARDWARE_PROFILING_JMX").orElse(true);
+
+	public static final String JMX_NAME = "org.almostrealism.hardware:type=Profiler";
+
+	public enum Category {
+		CL, NATIVE, EXTERNAL, TRANSFER, COMPILE
+	}
+
+	private static final Map<String, ProfileData> profiles = new ConcurrentHashMap<>();
+	private static volatile boolean registered;
+
+	private Profiler() { }
+
+	/**
+	 * The start time to provide to {@link #record(Category, String, long, long)},
+	 * or 0 if profiling is disabled.
+	 */
+	public static long start() {
+		return enableProfiling ? System.nanoTime() : 0;
+	}
+
+	/**
+	 * Record a run of the specified operation that began at the specified
+	 * time, obtained from {@link #start()}.
+	 */
+	public static void record(Category category, String name, long start, long bytes) {
+		if (!enableProfiling || start == 0) return;
+		recordDuration(category, name, System.nanoTime() - start, bytes);
+	}
+
+	/** Record a run of the specified operation with a known duration. */
+	public static void recordDuration(Category category, String name, long durationNanos, long bytes) {
+		if (!enableProfiling) return;
+
+		get(category, name).addRun(durationNanos, bytes);
+		event(category, name, durationNanos, bytes);
+	}
+
+	/**
+	 * Emit an {@link OperationEvent} for a run which has already been added
+	 * to its {@link ProfileData}, if the event is enabled in a recording.
+	 */
+	public static void event(Category category, String name, long durationNanos, long bytes) {
+		OperationEvent event = new OperationEvent();
+
+		if (event.isEnabled()) {
+			event.category = category.name();
+			event.operation = name;
+			event.duration = durationNanos;
+			event.bytes = bytes;
+			event.commit();
+		}
+	}
+
+	/** The {@link ProfileData} for the specified operation, which is created if necessary. */
+	public static ProfileData get(Category category, String name) {
+		if (!registered) register();
+
+		String key = key(category, name);
+		ProfileData data = profiles.get(key);
+		return data == null ? profiles.computeIfAbsent(key, k -> new ProfileData()) : data;
+	}
+
+	/** All of the {@link ProfileData}, identified by category and operation name. */
+	public static Map<String, ProfileData> getProfiles() {
+		return Collections.unmodifiableMap(profiles);
+	}
+
+	public static void reset() {
+		profiles.values().forEach(ProfileData::reset);
+	}
+
+	public static String key(Category category, String name) {
+		return category.name() + ":" + name;
+	}
+
+	private static synchronized void register() {
+		if (registered) return;
+		registered = true;
+
+		if (!enableJmx) return;
+
+		try {
+			ManagementFactory.getPlatformMBeanServer().registerMBean(new Bean(), new ObjectName(JMX_NAME));
+		} catch (Exception e) {
+			System.out.println("WARN: Unable to register " + JMX_NAME + " (" + e.getMessage() + ")");
+		}
+	}
+
+	private static class Bean implements ProfilerMXBean {
+		@Override
+		public String[] getOperations() { return profiles.keySet().toArray(new String[0]); }
+
+		@Override
+		public long getCount(String operation) { return profile(operation).getRuns(); }
+
+		@Override
+		public double getTotalNanos(String operation) { return profile(operation).getTotalRuntimeNanos(); }
+
+		@Override
+		public long getTotalBytes(String operation) { return profile(operation).getTotalBytes(); }
+
+		@Override
+		public long getPercentileNanos(String operation, double percentile) {
+			return profile(operation).getPercentileNanos(percentile);
+		}
+
+		@Override
+		public String getSummary(String operation) { return profile(operation).getSummaryString(); }
+
+		@Override
+		public void reset() { Profiler.reset(); }
+
+		private ProfileData profile(String operation) {
+			ProfileData data = profiles.get(operation);
+			if (data == null) throw new IllegalArgumentException("Unknown operation " + operation);
+			return data;
+		}
+	}
+}
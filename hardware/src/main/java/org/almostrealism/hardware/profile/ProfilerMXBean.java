@@ -0,0 +1,37 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.profile;
+
+/**
+ * The JMX interface of the {@link Profiler}. Operations are identified by
+ * their category and name, as returned by {@link Profiler#key}.
+ */
+public interface ProfilerMXBean {
+	String[] getOperations();
+
+	long getCount(String operation);
+
+	double getTotalNanos(String operation);
+
+	long getTotalBytes(String operation);
+
+	long getPercentileNanos(String operation, double percentile);
+
+	String getSummary(String operation);
+
+	void reset();
+}
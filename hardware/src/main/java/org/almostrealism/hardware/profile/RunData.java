@@ -18,9 +18,15 @@ package org.almostrealism.hardware.profile;
 
 public class RunData {
 	private long durationNanos;
+	private long bytes;
 
 	public RunData(long durationNanos) {
+		this(durationNanos, 0);
+	}
+
+	public RunData(long durationNanos, long bytes) {
 		setDurationNanos(durationNanos);
+		setBytes(bytes);
 	}
 
 	public long getDurationNanos() {
@@ -30,4 +36,9 @@ public class RunData {
 	public void setDurationNanos(long durationNanos) {
 		this.durationNanos = durationNanos;
 	}
+
+	/** The number of bytes transferred by the run, or 0 if it is not known. */
+	public long getBytes() { return bytes; }
+
+	public void setBytes(long bytes) { this.bytes = bytes; }
 }
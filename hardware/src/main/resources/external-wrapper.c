@@ -1,13 +1,52 @@
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+
+
+/*
+ * Every file exchanged with Java begins with an 8 byte header:
+ *
+ *     uint32 magic, uint8 version, uint8 flags, uint8 numberSize, uint8 reserved
+ *
+ * where bit 0 of the flags indicates a big endian file and the number size
+ * is 4 (fp32 or uint32 values) or 8 (fp64 values). Java writes files in the
+ * native byte order, so values are normally copied without any conversion;
+ * byte reversal is only needed if a file was produced on another machine.
+ */
+#define AR_DATA_MAGIC 0x41525844
+#define AR_DATA_VERSION 1
+#define AR_DATA_HEADER_SIZE 8
+
+/*
+ * The type of value used by the generated function. This is defined by
+ * ExternalComputeContext to match the precision of the Hardware.
+ */
+#ifndef AR_NUMBER
+#define AR_NUMBER double
+#endif
+
+typedef struct {
+    int swap;
+    int numberSize;
+} DataFormat;
+
+int hostBigEndian() {
+    uint16_t value = 1;
+    return *((uint8_t *) &value) == 0;
+}
 
-void reverse(uint8_t* dbuffer, uint8_t* buffer, int len) {
-    uint8_t out[len];
-
-    for (int i = 0; i < len; i++) {
-        dbuffer[len - i - 1] = buffer[i];
+void reverse(uint8_t* buffer, int len) {
+    for (int i = 0; i < len / 2; i++) {
+        uint8_t b = buffer[i];
+        buffer[i] = buffer[len - i - 1];
+        buffer[len - i - 1] = b;
     }
 }
 
-FILE* open(char* f, char* a) {
+FILE* fileOpen(char* f, char* a) {
     FILE *fp;
     fp = fopen(f, a);
 
@@ -22,118 +61,558 @@ FILE* open(char* f, char* a) {
 FILE* ropen(char* dir, char* f) {
     char l[250];
     sprintf(l, "%s/%s", dir, f);
-    return open(l, "rb");
+    return fileOpen(l, "rb");
 }
 
 FILE* ropeni(char* dir, int f) {
     char l[250];
     sprintf(l, "%s/%i", dir, f);
-    return open(l, "rb");
+    return fileOpen(l, "rb");
 }
 
 FILE* wopeni(char* dir, int f) {
     char l[250];
     sprintf(l, "%s/%i", dir, f);
-    return open(l, "wb");
+    return fileOpen(l, "wb");
 }
 
-uint32_t readInt(uint8_t* buffer) {
-    // return buffer[0] + (buffer[1] << 8) + (buffer[2] << 16) + (buffer[3] << 24);
-    return (buffer[0] << 24) + (buffer[1] << 16) + (buffer[2] << 8) + buffer[3];
+int parseHeader(uint8_t* header, DataFormat* format) {
+    format->swap = (header[5] & 1) != hostBigEndian();
+    format->numberSize = header[6];
+
+    uint8_t m[4];
+    memcpy(m, header, 4);
+    if (format->swap) reverse(m, 4);
+
+    uint32_t magic;
+    memcpy(&magic, m, 4);
+
+    if (magic != AR_DATA_MAGIC) {
+        fprintf(stderr, "Invalid data header\n");
+        return EXIT_FAILURE;
+    }
+
+    if (header[4] != AR_DATA_VERSION) {
+        fprintf(stderr, "Unsupported data version %i\n", header[4]);
+        return EXIT_FAILURE;
+    }
+
+    if (format->numberSize != 4 && format->numberSize != 8) {
+        fprintf(stderr, "Unsupported number size %i\n", format->numberSize);
+        return EXIT_FAILURE;
+    }
+
+    return 0;
 }
 
-double readDouble(uint8_t* buffer) {
-    double out;
-    uint8_t dbuffer[8];
-    reverse(dbuffer, buffer, 8);
-    memcpy(&out, dbuffer, sizeof(double));
-    return out;
+void writeHeader(uint8_t* header, int numberSize) {
+    uint32_t magic = AR_DATA_MAGIC;
+    memcpy(header, &magic, 4);
+    header[4] = AR_DATA_VERSION;
+    header[5] = hostBigEndian() ? 1 : 0;
+    header[6] = (uint8_t) numberSize;
+    header[7] = 0;
 }
 
-void writeDouble(uint8_t* buffer, double value) {
-    double out;
-    uint8_t dbuffer[8];
-    memcpy(dbuffer, &value, sizeof(double));
-    reverse(buffer, dbuffer, 8);
+/*
+ * Read the header and all of the values in the file, returning a buffer
+ * holding the values as they were stored along with the number of them.
+ */
+uint8_t* readValues(FILE* fp, DataFormat* format, size_t* count) {
+    uint8_t header[AR_DATA_HEADER_SIZE];
+
+    if (fread(header, sizeof(header), 1, fp) != 1 || parseHeader(header, format) != 0) {
+        fprintf(stderr, "Unable to read data header\n");
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0) {
+        perror("Error while reading file size\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = (size_t) st.st_size - AR_DATA_HEADER_SIZE;
+    *count = len / format->numberSize;
+
+    uint8_t* values = (uint8_t *) malloc(len > 0 ? len : 1);
+
+    if (len > 0 && fread(values, len, 1, fp) != 1) {
+        fprintf(stderr, "Unable to read data\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (format->swap) {
+        for (size_t i = 0; i < *count; i++) reverse(values + i * format->numberSize, format->numberSize);
+    }
+
+    return values;
 }
 
-int main(int argc, char **argv) {
-    char* dir;
-    dir = argv[1];
+uint32_t* readInts(char* dir, char* file, uint32_t* count) {
+    FILE* fp = ropen(dir, file);
 
-    uint8_t buffer[4];
-    FILE *fp;
+    DataFormat format;
+    size_t len;
+    uint32_t* values = (uint32_t *) readValues(fp, &format, &len);
+    fclose(fp);
 
-    fp = ropen(dir, "count");
+    if (format.numberSize != 4) {
+        fprintf(stderr, "Invalid integer size %i in %s\n", format.numberSize, file);
+        exit(EXIT_FAILURE);
+    }
 
-    fread(buffer, sizeof(buffer), 1, fp);
+    *count = (uint32_t) len;
+    return values;
+}
+
+/*
+ * Read the values of an argument as AR_NUMBER. Values which were stored in
+ * a different precision are converted, and their size is recorded so that
+ * they can be written back in the same precision.
+ */
+AR_NUMBER* readArgument(char* dir, int index, size_t* count, int* numberSize) {
+    FILE* fp = ropeni(dir, index);
+
+    DataFormat format;
+    uint8_t* values = readValues(fp, &format, count);
     fclose(fp);
 
-    uint32_t count = readInt(buffer);
-    // printf("Reading %i arguments...\n", count);
+    *numberSize = format.numberSize;
+    if (format.numberSize == sizeof(AR_NUMBER)) return (AR_NUMBER *) values;
+
+    AR_NUMBER* out = (AR_NUMBER *) malloc((*count > 0 ? *count : 1) * sizeof(AR_NUMBER));
 
-    uint32_t sizes[count];
+    for (size_t i = 0; i < *count; i++) {
+        out[i] = format.numberSize == 8 ? (AR_NUMBER) ((double *) values)[i] : (AR_NUMBER) ((float *) values)[i];
+    }
 
-    fp = ropen(dir, "sizes");
+    free(values);
+    return out;
+}
 
-    for (int i = 0; i < count; i++) {
-        fread(buffer, sizeof(buffer), 1, fp);
-        sizes[i] = readInt(buffer);
-        // printf("Argument %i size = %i\n", i, sizes[i]);
+void writeArgument(char* dir, int index, AR_NUMBER* values, size_t count, int numberSize) {
+    FILE* fp = wopeni(dir, index);
+
+    uint8_t header[AR_DATA_HEADER_SIZE];
+    writeHeader(header, numberSize);
+    fwrite(header, sizeof(header), 1, fp);
+
+    if (numberSize == sizeof(AR_NUMBER)) {
+        fwrite(values, sizeof(AR_NUMBER), count, fp);
+    } else if (numberSize == 8) {
+        double* out = (double *) malloc((count > 0 ? count : 1) * sizeof(double));
+        for (size_t i = 0; i < count; i++) out[i] = (double) values[i];
+        fwrite(out, sizeof(double), count, fp);
+        free(out);
+    } else {
+        float* out = (float *) malloc((count > 0 ? count : 1) * sizeof(float));
+        for (size_t i = 0; i < count; i++) out[i] = (float) values[i];
+        fwrite(out, sizeof(float), count, fp);
+        free(out);
     }
 
-    // printf("Read argument sizes\n");
     fclose(fp);
+}
 
-    uint32_t offsets[count];
+size_t mappedWorkPosition(uint32_t count, uint32_t blockCount) {
+    size_t len = AR_DATA_HEADER_SIZE + sizeof(uint32_t) * (2 + 3 * (size_t) count + (size_t) blockCount);
+    return (len + 7) & ~((size_t) 7);
+}
 
-    fp = ropen(dir, "offsets");
+size_t mappedHeaderSize(uint32_t count, uint32_t blockCount) {
+    return mappedWorkPosition(count, blockCount) + 2 * sizeof(uint64_t);
+}
 
-    for (int i = 0; i < count; i++) {
-        fread(buffer, sizeof(buffer), 1, fp);
-        offsets[i] = readInt(buffer);
-        // printf("Argument %i offset = %i\n", i, offsets[i]);
+#ifdef AR_KERNEL
+#ifndef AR_KERNEL_CHUNK
+#define AR_KERNEL_CHUNK 64
+#endif
+
+/*
+ * CPU kernel mode: the generated function is applied once for each global
+ * id in the work range, with ar_global_id (which get_global_id refers to)
+ * set for the thread applying it. Chunks of AR_KERNEL_CHUNK ids are handed
+ * out dynamically to OpenMP threads, when compiled with OpenMP, or to a
+ * pool of pthreads, so that each thread works through a contiguous block
+ * of the arguments.
+ */
+typedef struct {
+    long* args;
+    uint32_t* offsets;
+    uint32_t* sizes;
+    uint32_t count;
+    uint64_t next;
+    uint64_t end;
+} KernelRange;
+
+void applyKernelChunk(KernelRange* range, uint64_t start, uint64_t end) {
+    for (uint64_t id = start; id < end; id++) {
+        ar_global_id = id;
+        apply(range->args, range->offsets, range->sizes, range->count);
     }
+}
 
-    // printf("Read argument offsets\n");
-    fclose(fp);
+void* applyKernelTask(void* arg) {
+    KernelRange* range = (KernelRange *) arg;
+
+    while (1) {
+        uint64_t start = __atomic_fetch_add(&range->next, AR_KERNEL_CHUNK, __ATOMIC_RELAXED);
+        if (start >= range->end) break;
+
+        uint64_t end = start + AR_KERNEL_CHUNK;
+        if (end > range->end) end = range->end;
+        applyKernelChunk(range, start, end);
+    }
+
+    return NULL;
+}
+
+void applyKernel(long* args, uint32_t* offsets, uint32_t* sizes, uint32_t count, uint64_t workOffset, uint64_t workSize) {
+    KernelRange range = { args, offsets, sizes, count, workOffset, workOffset + workSize };
+
+    if (workSize <= AR_KERNEL_CHUNK) {
+        applyKernelChunk(&range, range.next, range.end);
+        return;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, AR_KERNEL_CHUNK)
+    for (int64_t id = (int64_t) range.next; id < (int64_t) range.end; id++) {
+        ar_global_id = (uint64_t) id;
+        apply(args, offsets, sizes, count);
+    }
+#else
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    char* env = getenv("AR_KERNEL_THREADS");
+    if (env != NULL) threads = atol(env);
+
+    uint64_t chunks = (workSize + AR_KERNEL_CHUNK - 1) / AR_KERNEL_CHUNK;
+    if (threads > chunks) threads = (long) chunks;
+    if (threads < 1) threads = 1;
 
-    uint8_t dbuffer[8];
+    pthread_t ids[threads];
+    int started[threads];
+
+    for (long t = 1; t < threads; t++) {
+        started[t] = pthread_create(&ids[t], NULL, applyKernelTask, &range) == 0;
+    }
+
+    applyKernelTask(&range);
+
+    for (long t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(ids[t], NULL);
+    }
+#endif
+}
+#endif
+
+uint8_t* mapFile(char* file, size_t* len) {
+    int fd = open(file, O_RDWR);
+
+    if (fd < 0) {
+        perror("Error while opening exchange file\n");
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        perror("Error while reading exchange file size\n");
+        close(fd);
+        return NULL;
+    }
+
+    *len = (size_t) st.st_size;
+    uint8_t* map = (uint8_t *) mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        perror("Error while mapping exchange file\n");
+        return NULL;
+    }
+
+    return map;
+}
+
+int applyExchange(uint8_t* map, size_t len) {
+    if (len < AR_DATA_HEADER_SIZE + sizeof(uint32_t)) {
+        fprintf(stderr, "Exchange is truncated (%zu bytes)\n", len);
+        return EXIT_FAILURE;
+    }
+
+    DataFormat format;
+    if (parseHeader(map, &format) != 0) return EXIT_FAILURE;
+
+    if (format.swap || format.numberSize != sizeof(AR_NUMBER)) {
+        fprintf(stderr, "Exchange must use native values of %zu bytes\n", sizeof(AR_NUMBER));
+        return EXIT_FAILURE;
+    }
+
+    uint32_t count = ((uint32_t *) (map + AR_DATA_HEADER_SIZE))[0];
+
+    if (len < mappedHeaderSize(count, 0)) {
+        fprintf(stderr, "Exchange is truncated (%zu bytes)\n", len);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t* sizes = ((uint32_t *) (map + AR_DATA_HEADER_SIZE)) + 1;
+    uint32_t* offsets = sizes + count;
+    uint32_t* blocks = offsets + count;
+    uint32_t blockCount = blocks[count];
+    uint32_t* lengths = blocks + count + 1;
+
+    size_t total = mappedHeaderSize(count, blockCount);
+    for (uint32_t i = 0; i < blockCount; i++) {
+        total += (size_t) lengths[i] * sizeof(AR_NUMBER);
+    }
+
+    if (total > len) {
+        fprintf(stderr, "Exchange is truncated (%zu < %zu bytes)\n", len, total);
+        return EXIT_FAILURE;
+    }
+
+    AR_NUMBER* blockData[blockCount > 0 ? blockCount : 1];
+    AR_NUMBER* data = (AR_NUMBER *) (map + mappedHeaderSize(count, blockCount));
+
+    for (uint32_t i = 0; i < blockCount; i++) {
+        blockData[i] = data;
+        data += lengths[i];
+    }
 
     long args[count];
 
-    for (int i = 0; i < count; i++) {
-        fp = ropeni(dir, i);
+    for (uint32_t i = 0; i < count; i++) {
+        if (blocks[i] >= blockCount) {
+            fprintf(stderr, "Invalid block %u for argument %u\n", blocks[i], i);
+            return EXIT_FAILURE;
+        }
 
-        args[i] = (long) malloc((size_t) (sizes[i] * 8));
-        double* output = (double *) args[i];
+        args[i] = (long) blockData[blocks[i]];
+    }
 
-        for (int j = 0; j < sizes[i]; j++) {
-            fread(dbuffer, sizeof(dbuffer), 1, fp);
-            output[j] = readDouble(dbuffer);
-            // printf("(%i,%i): %f\n", i, j, output[j]);
+#ifdef AR_KERNEL
+    uint64_t* work = (uint64_t *) (map + mappedWorkPosition(count, blockCount));
+    applyKernel(args, offsets, sizes, count, work[0], work[1]);
+#else
+    apply(args, offsets, sizes, count);
+#endif
+    return 0;
+}
+
+int applyMapped(char* file) {
+    size_t len;
+    uint8_t* map = mapFile(file, &len);
+    if (map == NULL) return EXIT_FAILURE;
+
+    int result = applyExchange(map, len);
+    munmap(map, len);
+    return result;
+}
+
+/*
+ * A batch is a series of exchanges, with the layout
+ *
+ *     header (number size 8)
+ *     uint32 n
+ *     uint32 (reserved)
+ *     uint64 offsets[n]
+ *     exchange 0 ... exchange n - 1
+ *
+ * where the offset of each exchange is measured from the start of the
+ * batch. The exchanges are independent, so they may be applied by any
+ * number of threads.
+ */
+typedef struct {
+    uint8_t* map;
+    size_t len;
+    uint32_t n;
+    uint64_t* offsets;
+    uint32_t thread;
+    uint32_t threads;
+    int result;
+} BatchTask;
+
+void* applyBatchTask(void* arg) {
+    BatchTask* task = (BatchTask *) arg;
+    task->result = 0;
+
+    for (uint32_t i = task->thread; i < task->n; i += task->threads) {
+        size_t end = i + 1 < task->n ? (size_t) task->offsets[i + 1] : task->len;
+
+        if (task->offsets[i] > end || end > task->len) {
+            fprintf(stderr, "Invalid offset for batch item %u\n", i);
+            task->result = EXIT_FAILURE;
+            return NULL;
         }
 
-        // printf("Read argument %i data\n", i);
+        int result = applyExchange(task->map + task->offsets[i], end - (size_t) task->offsets[i]);
+        if (result != 0) task->result = result;
+    }
+
+    return NULL;
+}
+
+int applyBatch(char* file, int threads) {
+    size_t len;
+    uint8_t* map = mapFile(file, &len);
+    if (map == NULL) return EXIT_FAILURE;
+
+    size_t start = AR_DATA_HEADER_SIZE + 8;
 
-        fclose(fp);
+    if (len < start) {
+        fprintf(stderr, "Batch is truncated (%zu bytes)\n", len);
+        munmap(map, len);
+        return EXIT_FAILURE;
     }
 
-    double* result = (double *) args[0];
+    DataFormat format;
 
-    apply(args, offsets, sizes, count);
+    if (parseHeader(map, &format) != 0 || format.swap) {
+        fprintf(stderr, "Batch must have a native data header\n");
+        munmap(map, len);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t n = ((uint32_t *) (map + AR_DATA_HEADER_SIZE))[0];
+
+    if (len < start + 8 * (size_t) n) {
+        fprintf(stderr, "Batch is truncated (%zu bytes)\n", len);
+        munmap(map, len);
+        return EXIT_FAILURE;
+    }
 
-    for (int i = 0; i < count; i++) {
-        fp = wopeni(dir, i);
+    if (threads < 1) threads = 1;
+    if ((uint32_t) threads > n) threads = n > 0 ? (int) n : 1;
 
-        double* output = (double *) args[i];
+    BatchTask tasks[threads];
+    pthread_t ids[threads];
+    int started[threads];
 
-        for (int j = 0; j < sizes[i]; j++) {
-            writeDouble(dbuffer, output[j]);
-            fwrite(dbuffer, sizeof(dbuffer), 1, fp);
+    for (int t = 0; t < threads; t++) {
+        tasks[t].map = map;
+        tasks[t].len = len;
+        tasks[t].n = n;
+        tasks[t].offsets = (uint64_t *) (map + start);
+        tasks[t].thread = t;
+        tasks[t].threads = threads;
+    }
+
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&ids[t], NULL, applyBatchTask, &tasks[t]) == 0;
+
+        if (!started[t]) {
+            perror("Error while starting batch thread\n");
+            tasks[t].result = EXIT_FAILURE;
         }
+    }
 
-        free(output);
-        fclose(fp);
+    applyBatchTask(&tasks[0]);
+
+    int result = tasks[0].result;
+
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(ids[t], NULL);
+        if (tasks[t].result != 0) result = tasks[t].result;
+    }
+
+    munmap(map, len);
+    return result;
+}
+
+/*
+ * Resident worker mode: each line read from stdin is a request of the form
+ * "<function id> <exchange file>", or "batch <threads> <batch file>", which
+ * is answered on stdout with a line "ar-worker-result <status>" once the
+ * mapped exchange (or every exchange in the batch) has been applied. The
+ * worker exits when stdin is closed.
+ */
+int runWorker() {
+    char line[4096];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line[strcspn(line, "\r\n")] = 0;
+
+        int batch = strncmp(line, "batch ", 6) == 0;
+        char* request = batch ? line + 6 : line;
+
+        char* file;
+        long function = strtol(request, &file, 10);
+        while (*file == ' ') file++;
+
+        int result;
+
+        if (file == request || *file == 0) {
+            fprintf(stderr, "Invalid worker request: %s\n", line);
+            result = EXIT_FAILURE;
+        } else if (batch) {
+            result = applyBatch(file, (int) function);
+        } else if (function != 0) {
+            fprintf(stderr, "Unknown function %ld\n", function);
+            result = EXIT_FAILURE;
+        } else {
+            result = applyMapped(file);
+        }
+
+        fflush(stdout);
+        printf("ar-worker-result %i\n", result);
+        fflush(stdout);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    char* dir;
+    dir = argv[1];
+
+    if (argc > 1 && strcmp(argv[1], "worker") == 0) {
+        return runWorker();
+    }
+
+    if (argc > 2 && strcmp(argv[2], "mmap") == 0) {
+        return applyMapped(dir);
     }
-}
\ No newline at end of file
+
+    if (argc > 2 && strcmp(argv[2], "batch") == 0) {
+        return applyBatch(dir, argc > 3 ? atoi(argv[3]) : 1);
+    }
+
+    uint32_t n;
+    uint32_t* countValues = readInts(dir, "count", &n);
+    uint32_t count = n > 0 ? countValues[0] : 0;
+    free(countValues);
+
+    uint32_t* sizes = readInts(dir, "sizes", &n);
+
+    if (n < count) {
+        fprintf(stderr, "Expected %u sizes but found %u\n", count, n);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t* offsets = readInts(dir, "offsets", &n);
+
+    if (n < count) {
+        fprintf(stderr, "Expected %u offsets but found %u\n", count, n);
+        return EXIT_FAILURE;
+    }
+
+    long args[count > 0 ? count : 1];
+    size_t lengths[count > 0 ? count : 1];
+    int numberSizes[count > 0 ? count : 1];
+
+    for (uint32_t i = 0; i < count; i++) {
+        args[i] = (long) readArgument(dir, i, &lengths[i], &numberSizes[i]);
+    }
+
+    apply(args, offsets, sizes, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        writeArgument(dir, i, (AR_NUMBER *) args[i], lengths[i], numberSizes[i]);
+        free((AR_NUMBER *) args[i]);
+    }
+
+    free(sizes);
+    free(offsets);
+    return 0;
+}
@@ -1,111 +1,67 @@
 #pragma OPENCL EXTENSION cl_khr_fp64 : enable
 
 __kernel void scalarCopy_local(__local double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
+    vstore2(vload2(0, m + mOffset), 0, res + resOffset);
 }
 
 __kernel void scalarCopy_localToGlobal(__global double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
+    vstore2(vload2(0, m + mOffset), 0, res + resOffset);
 }
 
 __kernel void scalarCopy_globalToLocal(__local double *res, __global const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
+    vstore2(vload2(0, m + mOffset), 0, res + resOffset);
 }
 
 __kernel void rayCopy_local(__local double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore2(vload2(0, m + mOffset + 4), 0, res + resOffset + 4);
 }
 
 __kernel void rayCopy_localToGlobal(__global double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore2(vload2(0, m + mOffset + 4), 0, res + resOffset + 4);
 }
 
 __kernel void rayCopy_globalToLocal(__local double *res, __global const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore2(vload2(0, m + mOffset + 4), 0, res + resOffset + 4);
 }
 
 __kernel void matrixCopy_local(__local double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
-    res[resOffset + 6] = m[mOffset + 6];
-    res[resOffset + 7] = m[mOffset + 7];
-
-    res[resOffset + 8]  = m[mOffset + 8];
-    res[resOffset + 9]  = m[mOffset + 9];
-    res[resOffset + 10] = m[mOffset + 10];
-    res[resOffset + 11] = m[mOffset + 11];
-
-    res[resOffset + 12] = m[mOffset + 12];
-    res[resOffset + 13] = m[mOffset + 13];
-    res[resOffset + 14] = m[mOffset + 14];
-    res[resOffset + 15] = m[mOffset + 15];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore4(vload4(1, m + mOffset), 1, res + resOffset);
+    vstore4(vload4(2, m + mOffset), 2, res + resOffset);
+    vstore4(vload4(3, m + mOffset), 3, res + resOffset);
 }
 
 __kernel void matrixCopy_localToGlobal(__global double *res, __local const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
-    res[resOffset + 6] = m[mOffset + 6];
-    res[resOffset + 7] = m[mOffset + 7];
-
-    res[resOffset + 8]  = m[mOffset + 8];
-    res[resOffset + 9]  = m[mOffset + 9];
-    res[resOffset + 10] = m[mOffset + 10];
-    res[resOffset + 11] = m[mOffset + 11];
-
-    res[resOffset + 12] = m[mOffset + 12];
-    res[resOffset + 13] = m[mOffset + 13];
-    res[resOffset + 14] = m[mOffset + 14];
-    res[resOffset + 15] = m[mOffset + 15];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore4(vload4(1, m + mOffset), 1, res + resOffset);
+    vstore4(vload4(2, m + mOffset), 2, res + resOffset);
+    vstore4(vload4(3, m + mOffset), 3, res + resOffset);
 }
 
 __kernel void matrixCopy_globalToLocal(__local double *res, __global const double *m, const int resOffset, const int mOffset) {
-    res[resOffset]     = m[mOffset];
-    res[resOffset + 1] = m[mOffset + 1];
-    res[resOffset + 2] = m[mOffset + 2];
-    res[resOffset + 3] = m[mOffset + 3];
-
-    res[resOffset + 4] = m[mOffset + 4];
-    res[resOffset + 5] = m[mOffset + 5];
-    res[resOffset + 6] = m[mOffset + 6];
-    res[resOffset + 7] = m[mOffset + 7];
-
-    res[resOffset + 8]  = m[mOffset + 8];
-    res[resOffset + 9]  = m[mOffset + 9];
-    res[resOffset + 10] = m[mOffset + 10];
-    res[resOffset + 11] = m[mOffset + 11];
-
-    res[resOffset + 12] = m[mOffset + 12];
-    res[resOffset + 13] = m[mOffset + 13];
-    res[resOffset + 14] = m[mOffset + 14];
-    res[resOffset + 15] = m[mOffset + 15];
+    vstore4(vload4(0, m + mOffset), 0, res + resOffset);
+    vstore4(vload4(1, m + mOffset), 1, res + resOffset);
+    vstore4(vload4(2, m + mOffset), 2, res + resOffset);
+    vstore4(vload4(3, m + mOffset), 3, res + resOffset);
+}
+
+/*
+ * Copy one element of len values for each work item, from a bank whose elements
+ * are mStride values apart to a bank whose elements are resStride values apart.
+ */
+__kernel void
+bankCopy(__global double *res, __global const double *m,
+         const int resOffset, const int mOffset,
+         const int resStride, const int mStride, const int len) {
+    __global double *r = res + resOffset + get_global_id(0) * resStride;
+    __global const double *s = m + mOffset + get_global_id(0) * mStride;
+
+    int i = 0;
+    for (; i + 4 <= len; i += 4) vstore4(vload4(0, s + i), 0, r + i);
+    for (; i < len; i++) r[i] = s[i];
 }
 
 __kernel void
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.almostrealism.optimize;
+
+import org.almostrealism.heredity.Genome;
+import org.almostrealism.time.Temporal;
+
+import java.util.List;
+
+/**
+ * A {@link HealthComputation} which can also compute the health of many {@link Genome}s
+ * at once. Rather than building and compiling an operation for each genome, an
+ * implementation should compile one operation whose parameters are an input, and
+ * provide the parameters of every genome in the batch together (for example, as the
+ * elements of a {@link org.almostrealism.hardware.MemoryBank}), so that the whole
+ * batch is evaluated by a single kernel. When the {@link HealthComputation} used by a
+ * {@link PopulationOptimizer} is a {@link BatchHealthComputation}, the optimizer
+ * evaluates its population in batches, while the next generation is still being bred.
+ */
+public interface BatchHealthComputation<G, T extends Temporal, S extends HealthScore> extends HealthComputation<T, S> {
+	/**
+	 * Compute the health of each of the specified {@link Genome}s, returning
+	 * the scores in the same order. This may be called by several threads at
+	 * once, each using its own {@link BatchHealthComputation}.
+	 */
+	List<S> computeHealth(List<Genome<G>> genomes);
+}
@@ -18,24 +18,35 @@ package org.almostrealism.optimize;
 
 import java.time.Instant;
 import java.util.ArrayList;
+import java.util.Collections;
 import java.util.HashMap;
+import java.util.IdentityHashMap;
 import java.util.Iterator;
 import java.util.List;
+import java.util.Map;
 import java.util.OptionalInt;
+import java.util.Set;
 import java.util.TreeSet;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.ExecutionException;
 import java.util.concurrent.ExecutorCompletionService;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.LinkedBlockingQueue;
 import java.util.function.BiConsumer;
 import java.util.function.Function;
 import java.util.function.Supplier;
 import java.util.stream.IntStream;
 
+import io.almostrealism.code.ComputeRequirement;
 import io.almostrealism.relation.Generated;
 import org.almostrealism.heredity.Genome;
 import org.almostrealism.heredity.GenomeBreeder;
 import org.almostrealism.io.Console;
+import org.almostrealism.io.SystemUtils;
 
 import org.almostrealism.time.Temporal;
 import org.almostrealism.CodeFeatures;
@@ -49,6 +60,27 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 	public static boolean enableDisplayGenomes = false;
 	public static boolean enableBreeding = true;
 
+	/**
+	 * If enabled, and the {@link HealthComputation} is a {@link BatchHealthComputation},
+	 * genomes are evaluated in batches of {@link #batchSize} by up to {@link #batchThreads}
+	 * workers, starting as soon as each batch of children has been bred.
+	 */
+	public static boolean enableBatchEvaluation = SystemUtils.isEnabled("AR_OPTIMIZE_BATCH_EVALUATION").orElse(true);
+	public static int batchSize = Integer.parseInt(SystemUtils.getProperty("AR_OPTIMIZE_BATCH_SIZE", "16"));
+
+	/**
+	 * The largest number of batches that are evaluated at once. Unlike {@link #THREADS},
+	 * this can be more than one, because each worker obtains its own computation.
+	 */
+	public static int batchThreads = Integer.parseInt(SystemUtils.getProperty("AR_OPTIMIZE_BATCH_THREADS", "2"));
+
+	/**
+	 * If specified, the {@link ComputeRequirement}s for each batch worker in turn, so
+	 * that the workers can use different devices. Otherwise, every worker uses the
+	 * {@link HealthCallable#computeRequirements}.
+	 */
+	public static ComputeRequirement batchRequirements[][];
+
 	public static OptionalInt targetGenome = OptionalInt.empty();
 
 	public static int popSize = 100;
@@ -72,6 +104,10 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 	private BiConsumer<String, S> healthListener;
 	private HealthScoring scoring;
 
+	private ExecutorService batchExecutor;
+	private BatchWorkers batchWorkers;
+	private BatchEvaluation batch;
+
 	public PopulationOptimizer(Supplier<HealthComputation<O, S>> h,
 							   Function<List<Genome<G>>, Population> children,
 							   Supplier<GenomeBreeder<G>> breeder, Supplier<Supplier<Genome<G>>> generator) {
@@ -92,8 +128,19 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 
 	public Population<G, T, O> getPopulation() { return this.population; }
 
-	public void resetHealth() {
+	public synchronized void resetHealth() {
 		health = null;
+		batchWorkers = null;
+	}
+
+	/**
+	 * Stop the threads which evaluate batches. They are started
+	 * again if the optimizer is used after it is destroyed.
+	 */
+	public synchronized void destroy() {
+		if (batchExecutor != null) batchExecutor.shutdown();
+		batchExecutor = null;
+		batchWorkers = null;
 	}
 
 	public HealthComputation<?, ?> getHealthComputation() {
@@ -131,6 +178,9 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 		List<Genome<G>> sorted = population.getGenomes();
 
 		if (enableBreeding) {
+			// Children are evaluated while the rest are still being bred
+			if (isBatchEvaluation()) batch = new BatchEvaluation();
+
 			// Fresh genetic material
 			List<Genome<G>> genomes = new ArrayList<>();
 
@@ -201,44 +251,99 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 	public void breedingComplete() { }
 
 	public void breed(List<Genome<G>> genomes, Genome g1, Genome g2) {
-		genomes.add(breeder.get().combine(g1, g2));
+		Genome<G> child = breeder.get().combine(g1, g2);
+		genomes.add(child);
+		if (batch != null) batch.submit(child);
+	}
+
+	/**
+	 * Returns true if the population will be evaluated using a {@link BatchHealthComputation}.
+	 */
+	public boolean isBatchEvaluation() {
+		return enableBatchEvaluation && !targetGenome.isPresent()
+				&& getHealthComputation() instanceof BatchHealthComputation;
 	}
 
 	private synchronized void orderByHealth(Population<G, T, O> pop) {
-		if (THREADS > 1) throw new UnsupportedOperationException();
+		final HashMap<Genome, Double> healthTable = new HashMap<>();
 
-		ExecutorService s = Executors.newFixedThreadPool(THREADS);
-		ExecutorCompletionService<S> executor = new ExecutorCompletionService<S>(s);
+		scoring = new HealthScoring(pop.size());
 
-		try {
-			final HashMap<Genome, Double> healthTable = new HashMap<>();
+		console.print("[" + Instant.now() + "] Calculating health");
+		if (enableVerbose) {
+			console.println("...");
+		} else {
+			console.print(".");
+		}
 
-			scoring = new HealthScoring(pop.size());
+		if (batch != null || isBatchEvaluation()) {
+			BatchEvaluation evaluation = batch == null ? new BatchEvaluation() : batch;
+			batch = null;
 
-			console.print("[" + Instant.now() + "] Calculating health");
-			if (enableVerbose) {
-				console.println("...");
-			} else {
-				console.print(".");
+			Map<Genome<G>, S> scores = evaluation.finish(pop.getGenomes());
+
+			for (int i = 0; i < pop.size(); i++) {
+				Genome<G> g = pop.getGenomes().get(i);
+				S h = scores.get(g);
+
+				scoring.pushScore(h);
+				healthTable.put(g, h.getScore());
+				healthComputed(g, i, h);
 			}
+		} else {
+			computeHealth(pop, healthTable);
+		}
+
+		if (!enableVerbose) console.println();
+
+		console.println("Average health for this round is " +
+				percent(scoring.getAverageScore()) + ", max " + percent(scoring.getMaxScore()));
+		TreeSet<Genome<G>> sorted = new TreeSet<>((g1, g2) -> {
+			double h1 = healthTable.get(g1);
+			double h2 = healthTable.get(g2);
 
+			int i = (int) ((h2 - h1) * 10000000);
+
+			if (i == 0) {
+				if (h1 > h2) {
+					return -1;
+				} else {
+					return 1;
+				}
+			}
+
+			return i;
+		});
+
+		for (int i = 0; i < pop.size(); i++) {
+			Genome g = pop.getGenomes().get(i);
+			if (healthTable.get(g) >= lowestHealth) sorted.add(g);
+		}
+
+		pop.getGenomes().clear();
+		pop.getGenomes().addAll(sorted);
+	}
+
+	private void computeHealth(Population<G, T, O> pop, Map<Genome, Double> healthTable) {
+		if (THREADS > 1) {
+			// Every genome shares one computation, so only
+			// batch evaluation can use more than one thread
+			throw new UnsupportedOperationException("Use a BatchHealthComputation to evaluate with " + THREADS + " threads");
+		}
+
+		ExecutorService s = Executors.newFixedThreadPool(THREADS);
+		ExecutorCompletionService<S> executor = new ExecutorCompletionService<S>(s);
+
+		try {
 			int count = pop.size();
 
 			for (int i = 0; i < count; i++) {
 				int fi = i;
 
 				executor.submit(new HealthCallable<O, S>(() -> pop.enableGenome(targetGenome.orElse(fi)), health, scoring, h -> {
-					healthTable.put(pop.getGenomes().get(targetGenome.orElse(fi)), h.getScore());
-
-					if (healthListener != null)
-						healthListener.accept(pop.getGenomes().get(targetGenome.orElse(fi)).signature(), h);
-
-					if (enableVerbose) {
-						console.println();
-						console.println("[" + Instant.now().toString() + "] Health of Network " + fi + " is " + percent(h.getScore()));
-					} else {
-						console.print(".");
-					}
+					Genome<G> g = pop.getGenomes().get(targetGenome.orElse(fi));
+					healthTable.put(g, h.getScore());
+					healthComputed(g, fi, h);
 				}, pop::disableGenome));
 			}
 
@@ -248,46 +353,53 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 				} catch (InterruptedException e) {
 					e.printStackTrace();
 				} catch (ExecutionException e) {
-					if (e.getCause() instanceof RuntimeException) {
-						throw (RuntimeException) e.getCause();
-					} else if (e.getCause() != null) {
-						throw new RuntimeException(e.getCause());
-					} else {
-						throw new RuntimeException(e);
-					}
+					throw failure(e);
 				}
 			}
+		} finally {
+			s.shutdown();
+		}
+	}
 
-			if (!enableVerbose) console.println();
+	private void healthComputed(Genome<G> g, int index, S h) {
+		if (healthListener != null)
+			healthListener.accept(g.signature(), h);
 
-			console.println("Average health for this round is " +
-					percent(scoring.getAverageScore()) + ", max " + percent(scoring.getMaxScore()));
-			TreeSet<Genome<G>> sorted = new TreeSet<>((g1, g2) -> {
-				double h1 = healthTable.get(g1);
-				double h2 = healthTable.get(g2);
+		if (enableVerbose) {
+			console.println();
+			console.println("[" + Instant.now().toString() + "] Health of Network " + index + " is " + percent(h.getScore()));
+		} else {
+			console.print(".");
+		}
+	}
 
-				int i = (int) ((h2 - h1) * 10000000);
+	private synchronized ExecutorService getBatchExecutor() {
+		if (batchExecutor == null) {
+			batchExecutor = Executors.newFixedThreadPool(Math.max(1, batchThreads), r -> {
+				Thread t = new Thread(r, "PopulationOptimizer Batch Worker");
+				t.setDaemon(true);
+				return t;
+			});
+		}
 
-				if (i == 0) {
-					if (h1 > h2) {
-						return -1;
-					} else {
-						return 1;
-					}
-				}
+		return batchExecutor;
+	}
 
-				return i;
-			});
+	private synchronized BatchWorkers getBatchWorkers() {
+		if (batchWorkers == null) {
+			batchWorkers = new BatchWorkers((BatchHealthComputation<G, O, S>) getHealthComputation());
+		}
 
-			for (int i = 0; i < pop.size(); i++) {
-				Genome g = pop.getGenomes().get(i);
-				if (healthTable.get(g) >= lowestHealth) sorted.add(g);
-			}
+		return batchWorkers;
+	}
 
-			pop.getGenomes().clear();
-			pop.getGenomes().addAll(sorted);
-		} finally {
-			s.shutdown();
+	private static RuntimeException failure(ExecutionException e) {
+		if (e.getCause() instanceof RuntimeException) {
+			return (RuntimeException) e.getCause();
+		} else if (e.getCause() != null) {
+			return new RuntimeException(e.getCause());
+		} else {
+			return new RuntimeException(e);
 		}
 	}
 
@@ -301,4 +413,137 @@ public class PopulationOptimizer<G, T, O extends Temporal, S extends HealthScore
 		if (decimalString.length() < 2) decimalString = "0" + decimalString;
 		return cents + "." + decimalString + "%";
 	}
+
+	/**
+	 * Evaluates genomes in batches as they are submitted, each batch being computed by
+	 * one of the workers using its own {@link BatchHealthComputation}. Because every
+	 * batch uses the same computation, the operation it compiles is reused, and workers
+	 * which finish early take the next batch.
+	 */
+	private class BatchEvaluation {
+		private final Map<Genome<G>, S> scores = new ConcurrentHashMap<>();
+		private final Set<Genome<G>> submitted = Collections.newSetFromMap(new IdentityHashMap<>());
+		private final List<Future<?>> tasks = new ArrayList<>();
+		private List<Genome<G>> pending = new ArrayList<>();
+
+		public void submit(Genome<G> genome) {
+			if (!submitted.add(genome)) return;
+
+			pending.add(genome);
+			if (pending.size() >= Math.max(1, batchSize)) flush();
+		}
+
+		public void flush() {
+			if (pending.isEmpty()) return;
+
+			List<Genome<G>> genomes = pending;
+			pending = new ArrayList<>();
+
+			BatchWorkers workers = getBatchWorkers();
+			tasks.add(getBatchExecutor().submit(() -> evaluate(workers, genomes)));
+		}
+
+		/**
+		 * Evaluate any of the specified genomes which have not been submitted,
+		 * and wait for every batch to complete.
+		 */
+		public Map<Genome<G>, S> finish(List<Genome<G>> genomes) {
+			genomes.forEach(this::submit);
+			flush();
+
+			for (Future<?> task : tasks) {
+				try {
+					task.get();
+				} catch (InterruptedException e) {
+					e.printStackTrace();
+				} catch (ExecutionException e) {
+					throw failure(e);
+				}
+			}
+
+			return scores;
+		}
+
+		private Void evaluate(BatchWorkers workers, List<Genome<G>> genomes) throws Exception {
+			BatchWorker worker = workers.take();
+
+			Callable<Void> call = () -> {
+				BatchHealthComputation<G, O, S> computation = worker.computation;
+
+				try {
+					List<S> results = computation.computeHealth(genomes);
+
+					if (results.size() != genomes.size()) {
+						throw new IllegalArgumentException(results.size() + " scores computed for " + genomes.size() + " genomes");
+					}
+
+					for (int i = 0; i < genomes.size(); i++) {
+						scores.put(genomes.get(i), results.get(i));
+					}
+				} finally {
+					computation.reset();
+				}
+
+				return null;
+			};
+
+			try {
+				if (worker.requirements == null || worker.requirements.length <= 0) {
+					return call.call();
+				} else {
+					return cc(call, worker.requirements);
+				}
+			} finally {
+				workers.release(worker);
+			}
+		}
+	}
+
+	/**
+	 * The {@link BatchHealthComputation}s available to evaluate batches. A batch obtains
+	 * one which is not in use, and returns it when the batch is complete, so that the
+	 * computations are kept regardless of which thread runs the batch. The first is the
+	 * existing computation, and more are only obtained while every other computation is
+	 * in use, up to {@link #batchThreads}.
+	 */
+	private class BatchWorkers {
+		private final BlockingQueue<BatchWorker> idle = new LinkedBlockingQueue<>();
+		private int created;
+
+		public BatchWorkers(BatchHealthComputation<G, O, S> first) {
+			idle.add(new BatchWorker(first, created++));
+		}
+
+		public BatchWorker take() throws InterruptedException {
+			BatchWorker worker = idle.poll();
+			if (worker != null) return worker;
+
+			synchronized (this) {
+				if (created < Math.max(1, batchThreads)) {
+					return new BatchWorker((BatchHealthComputation<G, O, S>) healthSupplier.get(), created++);
+				}
+			}
+
+			return idle.take();
+		}
+
+		public void release(BatchWorker worker) {
+			idle.add(worker);
+		}
+	}
+
+	private class BatchWorker {
+		private final BatchHealthComputation<G, O, S> computation;
+		private final ComputeRequirement requirements[];
+
+		public BatchWorker(BatchHealthComputation<G, O, S> computation, int index) {
+			this.computation = computation;
+
+			if (batchRequirements == null || batchRequirements.length <= 0) {
+				this.requirements = HealthCallable.computeRequirements;
+			} else {
+				this.requirements = batchRequirements[index % batchRequirements.length];
+			}
+		}
+	}
 }
@@ -0,0 +1,408 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.space;
+
+import org.almostrealism.algebra.Pair;
+import org.almostrealism.collect.PackedCollection;
+import org.almostrealism.geometry.Intersection;
+import org.almostrealism.geometry.Ray;
+import org.almostrealism.graph.mesh.TriangleDataBank;
+import org.almostrealism.hardware.KernelizedEvaluable;
+import org.almostrealism.hardware.PassThroughEvaluable;
+
+import java.util.Arrays;
+
+/**
+ * A bounding volume hierarchy for the triangles of a {@link TriangleDataBank},
+ * built using the surface area heuristic over a small number of bins along
+ * the widest axis of the centroids of each node.
+ *
+ * The nodes are stored in depth first order in a {@link PackedCollection},
+ * with {@link #NODE_SIZE} values for each: the minimum and maximum of the
+ * bounds, followed by two values that describe the children. For a leaf,
+ * these are the position of its first triangle in {@link #getIndices()}
+ * and the number of triangles. For any other node, the left child is the
+ * next node, and they are the position of the right child and the negation
+ * of one more than the axis it was split along. The triangles themselves
+ * are not reordered, so that the hierarchy can be used with the bank they
+ * came from, and when they move, {@link #refit()} updates the bounds without
+ * rebuilding the hierarchy.
+ *
+ * @see  BVHIntersectAt
+ */
+public class BVH {
+	/** The number of values stored for each node. */
+	public static final int NODE_SIZE = 8;
+
+	/** The maximum depth of the hierarchy, which limits the traversal stack. */
+	public static final int MAX_DEPTH = 48;
+
+	public static int bins = 12;
+	public static int maxLeafSize = 8;
+
+	private static final double TRAVERSAL_COST = 1.0;
+
+	private final TriangleDataBank triangles;
+	private final int count;
+
+	private double data[];
+	private double nodeData[];
+	private int nodeCount;
+	private int order[];
+
+	private PackedCollection<?> nodes;
+	private PackedCollection<?> indices;
+	private KernelizedEvaluable<Pair<?>> kernel;
+
+	public BVH(TriangleDataBank triangles) {
+		this.triangles = triangles;
+		this.count = triangles.getCount();
+		build();
+	}
+
+	public TriangleDataBank getTriangles() { return triangles; }
+
+	/** The nodes of the hierarchy, {@link #NODE_SIZE} values each. */
+	public PackedCollection<?> getNodes() { return nodes; }
+
+	/** The index of the triangle at each position referenced by the leaves. */
+	public PackedCollection<?> getIndices() { return indices; }
+
+	public int getNodeCount() { return nodeCount; }
+
+	/**
+	 * Build the hierarchy for the current positions of the triangles.
+	 */
+	public synchronized void build() {
+		data = count == 0 ? new double[0] : triangles.toArray(0, count * 12);
+		order = new int[count];
+		for (int i = 0; i < count; i++) order[i] = i;
+
+		double bounds[] = new double[count * 6];
+		double centroids[] = new double[count * 3];
+
+		for (int i = 0; i < count; i++) {
+			triangleBounds(i, bounds, i * 6);
+
+			for (int j = 0; j < 3; j++) {
+				centroids[i * 3 + j] = 0.5 * (bounds[i * 6 + j] + bounds[i * 6 + 3 + j]);
+			}
+		}
+
+		nodeData = new double[NODE_SIZE * Math.max(1, 2 * count - 1)];
+		nodeCount = 0;
+		build(bounds, centroids, 0, count, 0);
+
+		if (nodes == null || nodes.getMemLength() != nodeCount * NODE_SIZE) {
+			nodes = new PackedCollection<>(nodeCount * NODE_SIZE);
+			indices = new PackedCollection<>(Math.max(1, count));
+			kernel = null;
+		}
+
+		nodes.setMem(0, nodeData, 0, nodeCount * NODE_SIZE);
+		indices.setMem(0, Arrays.stream(order).asDoubleStream().toArray(), 0, count);
+	}
+
+	/**
+	 * Recompute the bounds of every node from the current positions of the triangles,
+	 * keeping the structure of the hierarchy. This is much faster than {@link #build()},
+	 * but the hierarchy becomes less efficient as the triangles move further from the
+	 * positions it was built for.
+	 */
+	public synchronized void refit() {
+		if (count == 0) return;
+		data = triangles.toArray(0, count * 12);
+
+		double b[] = new double[6];
+
+		// Children always follow their parent, so every child is
+		// refit before the parent when working backwards
+		for (int n = nodeCount - 1; n >= 0; n--) {
+			int p = n * NODE_SIZE;
+			clear(nodeData, p);
+
+			if (nodeData[p + 7] >= 0) {
+				int first = (int) nodeData[p + 6];
+				int last = first + (int) nodeData[p + 7];
+
+				for (int i = first; i < last; i++) {
+					triangleBounds(order[i], b, 0);
+					union(nodeData, p, b, 0);
+				}
+			} else {
+				union(nodeData, p, nodeData, p + NODE_SIZE);
+				union(nodeData, p, nodeData, (int) nodeData[p + 6] * NODE_SIZE);
+			}
+		}
+
+		nodes.setMem(0, nodeData, 0, nodeCount * NODE_SIZE);
+	}
+
+	/**
+	 * Returns the compiled kernel which finds the closest intersection for each
+	 * of a bank of {@link Ray}s, provided as its only argument.
+	 *
+	 * @see  BVHIntersectAt
+	 */
+	public synchronized KernelizedEvaluable<Pair<?>> getIntersectionKernel() {
+		if (kernel == null) {
+			kernel = new BVHIntersectAt(this, PassThroughEvaluable.of(Ray.class, 0)).get();
+		}
+
+		return kernel;
+	}
+
+	/**
+	 * Find the closest intersection of the specified {@link Ray} with the triangles,
+	 * without using a kernel. The result is the distance along the ray followed by
+	 * the index of the triangle, both of which are -1 if there is no intersection.
+	 */
+	public synchronized Pair<?> intersect(Ray r) {
+		double ray[] = r.toArray(0, 6);
+		double inv[] = { 1.0 / ray[3], 1.0 / ray[4], 1.0 / ray[5] };
+
+		double best = -1.0;
+		int bestIndex = -1;
+
+		int stack[] = new int[MAX_DEPTH + 2];
+		int sp = 0;
+		if (nodeCount > 0 && count > 0) stack[sp++] = 0;
+
+		while (sp > 0) {
+			int p = stack[--sp] * NODE_SIZE;
+
+			double tmin = Double.NEGATIVE_INFINITY, tmax = Double.POSITIVE_INFINITY;
+
+			for (int j = 0; j < 3; j++) {
+				double t1 = (nodeData[p + j] - ray[j]) * inv[j];
+				double t2 = (nodeData[p + 3 + j] - ray[j]) * inv[j];
+				tmin = Math.max(tmin, Math.min(t1, t2));
+				tmax = Math.min(tmax, Math.max(t1, t2));
+			}
+
+			if (tmax < Math.max(tmin, 0.0) || (best >= 0.0 && tmin > best)) continue;
+
+			if (nodeData[p + 7] >= 0) {
+				int first = (int) nodeData[p + 6];
+				int last = first + (int) nodeData[p + 7];
+
+				for (int i = first; i < last; i++) {
+					double t = intersect(order[i], ray);
+
+					if (t >= Intersection.e && (best < 0.0 || t < best)) {
+						best = t;
+						bestIndex = order[i];
+					}
+				}
+			} else {
+				int axis = (int) -nodeData[p + 7] - 1;
+				int left = p / NODE_SIZE + 1;
+				int right = (int) nodeData[p + 6];
+
+				// Visit the child nearer to the origin first
+				if (ray[3 + axis] < 0) {
+					stack[sp++] = left;
+					stack[sp++] = right;
+				} else {
+					stack[sp++] = right;
+					stack[sp++] = left;
+				}
+			}
+		}
+
+		return new Pair(best, bestIndex);
+	}
+
+	/**
+	 * Returns the distance along the ray to the specified triangle, using the same
+	 * test as {@link org.almostrealism.graph.mesh.TriangleIntersectAt}, or -1.
+	 */
+	private double intersect(int tri, double ray[]) {
+		int t = tri * 12;
+
+		// h = direction x def
+		double hx = ray[4] * data[t + 5] - ray[5] * data[t + 4];
+		double hy = ray[5] * data[t + 3] - ray[3] * data[t + 5];
+		double hz = ray[3] * data[t + 4] - ray[4] * data[t + 3];
+
+		double f = data[t] * hx + data[t + 1] * hy + data[t + 2] * hz;
+		if (f > -Intersection.e && f < Intersection.e) return -1.0;
+
+		double sx = ray[0] - data[t + 6];
+		double sy = ray[1] - data[t + 7];
+		double sz = ray[2] - data[t + 8];
+
+		double u = (sx * hx + sy * hy + sz * hz) / f;
+		if (u < 0.0 || u > 1.0) return -1.0;
+
+		// q = s x abc
+		double qx = sy * data[t + 2] - sz * data[t + 1];
+		double qy = sz * data[t] - sx * data[t + 2];
+		double qz = sx * data[t + 1] - sy * data[t];
+
+		double v = (ray[3] * qx + ray[4] * qy + ray[5] * qz) / f;
+		if (v < 0.0 || u + v > 1.0) return -1.0;
+
+		return (data[t + 3] * qx + data[t + 4] * qy + data[t + 5] * qz) / f;
+	}
+
+	/**
+	 * Add the node for the triangles from start to end in the order, and all of
+	 * its children, returning the index of the node.
+	 */
+	private int build(double bounds[], double centroids[], int start, int end, int depth) {
+		int node = nodeCount++;
+		int p = node * NODE_SIZE;
+
+		clear(nodeData, p);
+		for (int i = start; i < end; i++) union(nodeData, p, bounds, order[i] * 6);
+
+		int n = end - start;
+		if (n <= 1 || depth >= MAX_DEPTH) return leaf(p, start, n);
+
+		// The axis with the widest spread of centroids
+		double cmin[] = new double[3], cmax[] = new double[3];
+		Arrays.fill(cmin, Double.POSITIVE_INFINITY);
+		Arrays.fill(cmax, Double.NEGATIVE_INFINITY);
+
+		for (int i = start; i < end; i++) {
+			for (int j = 0; j < 3; j++) {
+				cmin[j] = Math.min(cmin[j], centroids[order[i] * 3 + j]);
+				cmax[j] = Math.max(cmax[j], centroids[order[i] * 3 + j]);
+			}
+		}
+
+		int axis = 0;
+		for (int j = 1; j < 3; j++) {
+			if (cmax[j] - cmin[j] > cmax[axis] - cmin[axis]) axis = j;
+		}
+
+		double extent = cmax[axis] - cmin[axis];
+		if (!(extent > 0)) {
+			return n <= maxLeafSize ? leaf(p, start, n) : split(bounds, centroids, p, start, start + n / 2, end, axis, depth);
+		}
+
+		// Accumulate the triangles into bins along the axis
+		int binCount[] = new int[bins];
+		double binBounds[] = new double[bins * 6];
+		for (int b = 0; b < bins; b++) clear(binBounds, b * 6);
+
+		for (int i = start; i < end; i++) {
+			int b = bin(centroids[order[i] * 3 + axis], cmin[axis], extent);
+			binCount[b]++;
+			union(binBounds, b * 6, bounds, order[i] * 6);
+		}
+
+		// The cost of splitting after each bin, from the areas of both sides
+		double cost[] = new double[bins - 1];
+		double acc[] = new double[6];
+
+		clear(acc, 0);
+		int left = 0;
+		for (int b = 0; b < bins - 1; b++) {
+			union(acc, 0, binBounds, b * 6);
+			left += binCount[b];
+			cost[b] = left * area(acc, 0);
+		}
+
+		clear(acc, 0);
+		int right = 0;
+		for (int b = bins - 1; b > 0; b--) {
+			union(acc, 0, binBounds, b * 6);
+			right += binCount[b];
+			cost[b - 1] += right * area(acc, 0);
+		}
+
+		int best = 0;
+		for (int b = 1; b < bins - 1; b++) {
+			if (cost[b] < cost[best]) best = b;
+		}
+
+		double nodeArea = area(nodeData, p);
+		double splitCost = TRAVERSAL_COST + (nodeArea > 0 ? cost[best] / nodeArea : n);
+		if (n <= maxLeafSize && splitCost >= n) return leaf(p, start, n);
+
+		// Partition the order by the chosen bin
+		int i = start, j = end - 1;
+		while (i <= j) {
+			if (bin(centroids[order[i] * 3 + axis], cmin[axis], extent) <= best) {
+				i++;
+			} else {
+				int t = order[i];
+				order[i] = order[j];
+				order[j] = t;
+				j--;
+			}
+		}
+
+		int mid = (i == start || i == end) ? start + n / 2 : i;
+		return split(bounds, centroids, p, start, mid, end, axis, depth);
+	}
+
+	private int split(double bounds[], double centroids[], int p, int start, int mid, int end, int axis, int depth) {
+		build(bounds, centroids, start, mid, depth + 1);
+		int right = build(bounds, centroids, mid, end, depth + 1);
+		nodeData[p + 6] = right;
+		nodeData[p + 7] = -(axis + 1);
+		return p / NODE_SIZE;
+	}
+
+	private int leaf(int p, int start, int n) {
+		nodeData[p + 6] = start;
+		nodeData[p + 7] = n;
+		return p / NODE_SIZE;
+	}
+
+	private int bin(double centroid, double min, double extent) {
+		return Math.min(bins - 1, (int) (bins * (centroid - min) / extent));
+	}
+
+	private void triangleBounds(int tri, double out[], int offset) {
+		int t = tri * 12;
+
+		for (int j = 0; j < 3; j++) {
+			double a = data[t + 6 + j];
+			double b = a + data[t + j];
+			double c = a + data[t + 3 + j];
+			out[offset + j] = Math.min(a, Math.min(b, c));
+			out[offset + 3 + j] = Math.max(a, Math.max(b, c));
+		}
+	}
+
+	private static void clear(double b[], int offset) {
+		for (int j = 0; j < 3; j++) {
+			b[offset + j] = Double.POSITIVE_INFINITY;
+			b[offset + 3 + j] = Double.NEGATIVE_INFINITY;
+		}
+	}
+
+	private static void union(double b[], int offset, double other[], int otherOffset) {
+		for (int j = 0; j < 3; j++) {
+			b[offset + j] = Math.min(b[offset + j], other[otherOffset + j]);
+			b[offset + 3 + j] = Math.max(b[offset + 3 + j], other[otherOffset + 3 + j]);
+		}
+	}
+
+	private static double area(double b[], int offset) {
+		double x = b[offset + 3] - b[offset];
+		double y = b[offset + 4] - b[offset + 1];
+		double z = b[offset + 5] - b[offset + 2];
+		if (!(x >= 0) || !(y >= 0) || !(z >= 0)) return 0;
+		return 2.0 * (x * y + y * z + z * x);
+	}
+}
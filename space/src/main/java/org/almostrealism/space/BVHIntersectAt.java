@@ -0,0 +1,211 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.space;
+
+import io.almostrealism.code.HybridScope;
+import io.almostrealism.code.OperationMetadata;
+import io.almostrealism.code.PhysicalScope;
+import io.almostrealism.code.ProducerComputationAdapter;
+import io.almostrealism.relation.Evaluable;
+import io.almostrealism.relation.Provider;
+import io.almostrealism.scope.ArrayVariable;
+import io.almostrealism.scope.Scope;
+import org.almostrealism.algebra.Pair;
+import org.almostrealism.algebra.PairBank;
+import org.almostrealism.algebra.computations.DefaultPairEvaluable;
+import org.almostrealism.geometry.Intersection;
+import org.almostrealism.geometry.Ray;
+import org.almostrealism.hardware.AcceleratedComputationEvaluable;
+import org.almostrealism.hardware.ComputerFeatures;
+import org.almostrealism.hardware.DefaultComputer;
+import org.almostrealism.hardware.DestinationSupport;
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.KernelizedEvaluable;
+import org.almostrealism.hardware.KernelizedProducer;
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.mem.MemoryDataDestination;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.function.Consumer;
+import java.util.function.Supplier;
+
+/**
+ * Finds the closest intersection of a {@link Ray} with the triangles of a {@link BVH},
+ * producing the distance along the ray and the index of the triangle, both of which
+ * are -1 if there is no intersection. When it is evaluated as a kernel, each ray of
+ * the input bank traverses the hierarchy with its own stack, visiting the nearer
+ * child of each node first and skipping nodes which are further than the closest
+ * intersection found so far.
+ */
+public class BVHIntersectAt extends ProducerComputationAdapter<MemoryData, Pair<?>>
+		implements KernelizedProducer<Pair<?>>, DestinationSupport<Pair<?>>, ComputerFeatures {
+	private final int count;
+	private Supplier<Pair<?>> destination;
+
+	public BVHIntersectAt(BVH bvh, Supplier<Evaluable<? extends Ray>> ray) {
+		this.count = bvh.getTriangles().getCount();
+		this.destination = Pair::new;
+
+		List inputs = new ArrayList();
+		inputs.add(new MemoryDataDestination(this, PairBank::new));
+		inputs.add(ray);
+		inputs.add(fixed(bvh.getNodes()));
+		inputs.add(fixed(bvh.getIndices()));
+		inputs.add(fixed(bvh.getTriangles()));
+		setInputs(inputs);
+
+		init();
+	}
+
+	/** @return  GLOBAL */
+	@Override
+	public PhysicalScope getDefaultPhysicalScope() { return PhysicalScope.GLOBAL; }
+
+	@Override
+	public void setDestination(Supplier<Pair<?>> destination) { this.destination = destination; }
+
+	@Override
+	public Supplier<Pair<?>> getDestination() { return destination; }
+
+	@Override
+	public Scope<Pair<?>> getScope() {
+		HybridScope<Pair<?>> scope = new HybridScope<>(this);
+		scope.setMetadata(new OperationMetadata(getFunctionName(), "BVHIntersectAt"));
+		Consumer<String> code = scope.code();
+
+		String type = Hardware.getLocalHardware().getNumberTypeName();
+		String zero = stringForDouble(0.0);
+		String one = stringForDouble(1.0);
+		String e = stringForDouble(Intersection.e);
+		String v = getVariablePrefix() + "_";
+
+		ArrayVariable<?> output = getArgument(0, 2);
+		ArrayVariable<?> ray = getArgument(1, 6);
+		ArrayVariable<?> nodes = getArgument(2);
+		ArrayVariable<?> indices = getArgument(3);
+		ArrayVariable<?> triangles = getArgument(4);
+
+		for (int j = 0; j < 3; j++) {
+			code.accept(type + " " + v + "o" + j + " = " + ray.valueAt(j).getExpression() + ";\n");
+			code.accept(type + " " + v + "d" + j + " = " + ray.valueAt(3 + j).getExpression() + ";\n");
+			code.accept(type + " " + v + "inv" + j + " = " + one + " / " + v + "d" + j + ";\n");
+		}
+
+		code.accept(type + " " + v + "best = -" + one + ";\n");
+		code.accept(type + " " + v + "bestIndex = -" + one + ";\n");
+		code.accept("int " + v + "stack[" + (BVH.MAX_DEPTH + 2) + "];\n");
+		code.accept("int " + v + "sp = 0;\n");
+		if (count > 0) code.accept(v + "stack[" + v + "sp++] = 0;\n");
+
+		code.accept("while (" + v + "sp > 0) {\n");
+		code.accept("    int " + v + "n = " + v + "stack[--" + v + "sp];\n");
+		code.accept("    int " + v + "b = " + v + "n * " + BVH.NODE_SIZE + ";\n");
+
+		// Slab test for the bounds of the node
+		for (int j = 0; j < 3; j++) {
+			code.accept("    " + type + " " + v + "lo" + j + " = (" + nodes.get(v + "b + " + j).getExpression() +
+					" - " + v + "o" + j + ") * " + v + "inv" + j + ";\n");
+			code.accept("    " + type + " " + v + "hi" + j + " = (" + nodes.get(v + "b + " + (3 + j)).getExpression() +
+					" - " + v + "o" + j + ") * " + v + "inv" + j + ";\n");
+		}
+
+		code.accept("    " + type + " " + v + "tmin = fmax(fmax(fmin(" + v + "lo0, " + v + "hi0), fmin(" + v + "lo1, " + v + "hi1)), fmin(" + v + "lo2, " + v + "hi2));\n");
+		code.accept("    " + type + " " + v + "tmax = fmin(fmin(fmax(" + v + "lo0, " + v + "hi0), fmax(" + v + "lo1, " + v + "hi1)), fmax(" + v + "lo2, " + v + "hi2));\n");
+		code.accept("    if (" + v + "tmax < fmax(" + v + "tmin, " + zero + ") || (" + v + "best >= " + zero +
+				" && " + v + "tmin > " + v + "best)) continue;\n");
+
+		String first = nodes.get(v + "b + 6").getExpression();
+		String size = nodes.get(v + "b + 7").getExpression();
+
+		// Leaf, intersect each of its triangles
+		code.accept("    if (" + size + " >= " + zero + ") {\n");
+		code.accept("        int " + v + "first = (int) " + first + ";\n");
+		code.accept("        int " + v + "last = " + v + "first + (int) " + size + ";\n");
+		code.accept("        for (int " + v + "k = " + v + "first; " + v + "k < " + v + "last; " + v + "k++) {\n");
+		code.accept("            int " + v + "tri = (int) " + indices.get(v + "k").getExpression() + ";\n");
+		code.accept("            int " + v + "t = " + v + "tri * 12;\n");
+
+		String t[] = new String[9];
+		for (int j = 0; j < t.length; j++) {
+			t[j] = triangles.get(v + "t + " + j).getExpression();
+		}
+
+		String i = "            ";
+		code.accept(i + type + " " + v + "hx = " + v + "d1 * " + t[5] + " - " + v + "d2 * " + t[4] + ";\n");
+		code.accept(i + type + " " + v + "hy = " + v + "d2 * " + t[3] + " - " + v + "d0 * " + t[5] + ";\n");
+		code.accept(i + type + " " + v + "hz = " + v + "d0 * " + t[4] + " - " + v + "d1 * " + t[3] + ";\n");
+		code.accept(i + type + " " + v + "f = " + t[0] + " * " + v + "hx + " + t[1] + " * " + v + "hy + " + t[2] + " * " + v + "hz;\n");
+		code.accept(i + "if (" + v + "f > -" + e + " && " + v + "f < " + e + ") continue;\n");
+		code.accept(i + type + " " + v + "sx = " + v + "o0 - " + t[6] + ";\n");
+		code.accept(i + type + " " + v + "sy = " + v + "o1 - " + t[7] + ";\n");
+		code.accept(i + type + " " + v + "sz = " + v + "o2 - " + t[8] + ";\n");
+		code.accept(i + type + " " + v + "u = (" + v + "sx * " + v + "hx + " + v + "sy * " + v + "hy + " + v + "sz * " + v + "hz) / " + v + "f;\n");
+		code.accept(i + "if (" + v + "u < " + zero + " || " + v + "u > " + one + ") continue;\n");
+		code.accept(i + type + " " + v + "qx = " + v + "sy * " + t[2] + " - " + v + "sz * " + t[1] + ";\n");
+		code.accept(i + type + " " + v + "qy = " + v + "sz * " + t[0] + " - " + v + "sx * " + t[2] + ";\n");
+		code.accept(i + type + " " + v + "qz = " + v + "sx * " + t[1] + " - " + v + "sy * " + t[0] + ";\n");
+		code.accept(i + type + " " + v + "v = (" + v + "d0 * " + v + "qx + " + v + "d1 * " + v + "qy + " + v + "d2 * " + v + "qz) / " + v + "f;\n");
+		code.accept(i + "if (" + v + "v < " + zero + " || " + v + "u + " + v + "v > " + one + ") continue;\n");
+		code.accept(i + type + " " + v + "dist = (" + t[3] + " * " + v + "qx + " + t[4] + " * " + v + "qy + " + t[5] + " * " + v + "qz) / " + v + "f;\n");
+		code.accept(i + "if (" + v + "dist >= " + e + " && (" + v + "best < " + zero + " || " + v + "dist < " + v + "best)) {\n");
+		code.accept(i + "    " + v + "best = " + v + "dist;\n");
+		code.accept(i + "    " + v + "bestIndex = " + v + "tri;\n");
+		code.accept(i + "}\n");
+		code.accept("        }\n");
+
+		// Otherwise, visit the nearer child first
+		code.accept("    } else {\n");
+		code.accept("        int " + v + "axis = (int) (-" + size + ") - 1;\n");
+		code.accept("        int " + v + "right = (int) " + first + ";\n");
+		code.accept("        " + type + " " + v + "dir = " + v + "axis == 0 ? " + v + "d0 : (" + v + "axis == 1 ? " + v + "d1 : " + v + "d2);\n");
+		code.accept("        if (" + v + "dir < " + zero + ") {\n");
+		code.accept("            " + v + "stack[" + v + "sp++] = " + v + "n + 1;\n");
+		code.accept("            " + v + "stack[" + v + "sp++] = " + v + "right;\n");
+		code.accept("        } else {\n");
+		code.accept("            " + v + "stack[" + v + "sp++] = " + v + "right;\n");
+		code.accept("            " + v + "stack[" + v + "sp++] = " + v + "n + 1;\n");
+		code.accept("        }\n");
+		code.accept("    }\n");
+		code.accept("}\n");
+
+		code.accept(output.valueAt(0).getExpression() + " = " + v + "best;\n");
+		code.accept(output.valueAt(1).getExpression() + " = " + v + "bestIndex;\n");
+		return scope;
+	}
+
+	@Override
+	public KernelizedEvaluable<Pair<?>> get() {
+		DefaultComputer computer = (DefaultComputer) Hardware.getLocalHardware().getComputeContext().getComputer();
+
+		AcceleratedComputationEvaluable ev;
+
+		if (computer.isNative()) {
+			ev = (AcceleratedComputationEvaluable) computer.compileProducer(this);
+		} else {
+			ev = new DefaultPairEvaluable(this);
+		}
+
+		ev.compile();
+		return ev;
+	}
+
+	private static Supplier<Evaluable<? extends MemoryData>> fixed(MemoryData data) {
+		return () -> new Provider<>(data);
+	}
+}
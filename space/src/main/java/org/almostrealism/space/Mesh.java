@@ -364,6 +364,7 @@ public class Mesh extends SpacePartition<Triangle> implements Automata<Vector, T
 		MeshData tdata = new MeshData(tcache.length);
 		MeshPointData points = getMeshPointData();
 		Triangle.dataProducer.kernelEvaluate(tdata, new MemoryBank[] { points });
+		tdata.modified();
   		return tdata;
 	}
 
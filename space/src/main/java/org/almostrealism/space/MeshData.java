@@ -22,6 +22,7 @@ import org.almostrealism.algebra.PairBank;
 import org.almostrealism.algebra.ScalarBank;
 import org.almostrealism.geometry.Ray;
 import org.almostrealism.geometry.RayBank;
+import org.almostrealism.graph.mesh.TriangleData;
 import org.almostrealism.graph.mesh.TriangleDataBank;
 import org.almostrealism.hardware.KernelizedOperation;
 import org.almostrealism.hardware.KernelizedEvaluable;
@@ -31,7 +32,16 @@ import org.almostrealism.hardware.mem.MemoryBankAdapter;
 import io.almostrealism.relation.Evaluable;
 import org.almostrealism.geometry.computations.RankedChoiceEvaluable;
 import org.almostrealism.hardware.mem.MemoryBankAdapter.CacheLevel;
-
+import org.almostrealism.io.SystemUtils;
+
+/**
+ * The triangles of a {@link Mesh}, with the ability to find their intersection with
+ * {@link Ray}s. When {@link #enableBVH} is set, intersections are found using a
+ * {@link BVH} that is refit whenever the triangles have changed. Writes made with
+ * {@link #set(int, TriangleData)} or any of the setMem methods are detected, but
+ * anything that writes the memory directly, such as a kernel which uses this as
+ * its destination, must call {@link #modified()} afterwards.
+ */
 public class MeshData extends TriangleDataBank {
 	/**
 	 * If there is not enough RAM to run the entire kernel at once,
@@ -39,14 +49,71 @@ public class MeshData extends TriangleDataBank {
 	 */
 	public static boolean enablePartialKernel = true;
 
+	/**
+	 * If enabled, intersections are found by traversing a {@link BVH} for the
+	 * triangles, rather than by testing every triangle.
+	 */
+	public static boolean enableBVH = SystemUtils.isEnabled("AR_MESH_BVH").orElse(true);
+
 	private ScalarBank distances;
+	private BVH bvh;
+	private long version, bvhVersion;
 
 	public MeshData(int triangles) {
 		super(triangles);
 		distances = new ScalarBank(getCount());
 	}
 
+	/**
+	 * Returns the {@link BVH} for these triangles, building it the first time,
+	 * and refitting it if {@link #modified()} has been called since it was last
+	 * used. The triangles are never read back to check whether they changed.
+	 */
+	public synchronized BVH getBVH() {
+		if (bvh == null) {
+			bvh = new BVH(this);
+		} else if (bvhVersion != version) {
+			bvh.refit();
+		}
+
+		bvhVersion = version;
+		return bvh;
+	}
+
+	/**
+	 * Indicate that the triangles have been written, so that the {@link BVH}
+	 * is refit before it is next used. This is done by every setMem method,
+	 * which includes {@link #set(int, TriangleData)} and writes made through
+	 * the {@link TriangleData} of this bank, but anything else which writes
+	 * the triangles, such as a kernel, must call it.
+	 */
+	public synchronized void modified() { version++; }
+
+	@Override
+	public void setMem(int offset, double[] source, int srcOffset, int length) {
+		super.setMem(offset, source, srcOffset, length);
+		modified();
+	}
+
+	@Override
+	public void setMem(int offset, MemoryData src, int srcOffset, int length) {
+		super.setMem(offset, src, srcOffset, length);
+		modified();
+	}
+
+	/**
+	 * Update the bounds of the {@link BVH}, if there is one, after the triangles
+	 * have moved, without rebuilding it.
+	 *
+	 * @see  BVH#refit()
+	 */
+	public synchronized void refitBVH() {
+		if (bvh != null) bvh.refit();
+	}
+
 	public synchronized Pair evaluateIntersection(Evaluable<Ray> ray, Object args[]) {
+		if (enableBVH) return getBVH().intersect(ray.evaluate(args));
+
 		RayBank in = new RayBank(1);
 		PairBank out = new PairBank(1);
 
@@ -74,6 +141,13 @@ public class MeshData extends TriangleDataBank {
 
 		if (KernelizedOperation.enableKernelLog) System.out.println("MeshData: Evaluated ray kernel in " + (System.currentTimeMillis() - startTime) + " msec");
 
+		if (enableBVH) {
+			BVH bvh = getBVH();
+			bvh.getIntersectionKernel().kernelEvaluate(destination, rays);
+			if (KernelizedOperation.enableKernelLog) System.out.println(rays.getCount() + " rays traversed " + bvh.getNodeCount() + " node BVH");
+			return;
+		}
+
 		PairBank dim = new PairBank(1);
 		dim.set(0, new Pair(this.getCount(), rays.getCount()));
 
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.time;
+
+import io.almostrealism.uml.Lifecycle;
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.mem.MemoryBankAdapter.CacheLevel;
+import org.almostrealism.io.SystemUtils;
+
+import java.util.Map;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.LinkedBlockingQueue;
+
+/**
+ * A {@link ChunkedTimeSeries} stores {@link TemporalScalar}s in a ring of fixed size
+ * {@link TemporalScalarBank}s, rather than in one bank of a fixed capacity like
+ * {@link AcceleratedTimeSeries}. Chunks are added as the series grows, and when
+ * {@link #purge(double)} moves past the end of a chunk it is released whole, to be
+ * recycled by the next series that needs a chunk of the same size.
+ *
+ * The time of the first and last entry of every chunk is kept in host memory, so
+ * that the entry for a cursor can be located using a binary search over the chunks
+ * and then over the entries of a single chunk. Entries must be added in order of
+ * time. Interpolation follows {@link AcceleratedTimeSeries#valueAt(double)}.
+ */
+public class ChunkedTimeSeries implements Lifecycle {
+	public static int defaultChunkSize = Integer.parseInt(SystemUtils.getProperty("AR_TIME_SERIES_CHUNK_SIZE", "8192"));
+	public static int maxRecycledChunks = Integer.parseInt(SystemUtils.getProperty("AR_TIME_SERIES_RECYCLED_CHUNKS", "256"));
+
+	private static final Map<Integer, BlockingQueue<TemporalScalarBank>> recycled = new ConcurrentHashMap<>();
+
+	private final int chunkSize;
+
+	private TemporalScalarBank chunks[];
+	private double firstTimes[], lastTimes[];
+	private int head, chunkCount;
+
+	/** Index of the first entry in the first chunk, and number of entries in the last chunk. */
+	private int begin, end;
+	private int length;
+
+	public ChunkedTimeSeries() {
+		this(defaultChunkSize);
+	}
+
+	public ChunkedTimeSeries(int chunkSize) {
+		if (chunkSize <= 0) throw new IllegalArgumentException("Chunk size must be positive");
+		this.chunkSize = chunkSize;
+		this.chunks = new TemporalScalarBank[4];
+		this.firstTimes = new double[4];
+		this.lastTimes = new double[4];
+	}
+
+	public int getChunkSize() { return chunkSize; }
+
+	public int getChunkCount() { return chunkCount; }
+
+	public int getLength() { return length; }
+
+	public boolean isEmpty() { return length == 0; }
+
+	public void add(TemporalScalar value) {
+		add(value.getTime(), value.getValue());
+	}
+
+	public void add(double time, double value) {
+		if (chunkCount > 0 && time < lastTimes[slot(chunkCount - 1)]) {
+			throw new IllegalArgumentException("Entries must be added in order of time");
+		}
+
+		if (chunkCount == 0 || end == chunkSize) {
+			if (chunkCount == chunks.length) grow();
+			int s = slot(chunkCount++);
+			chunks[s] = acquire(chunkSize);
+			firstTimes[s] = time;
+			end = 0;
+		}
+
+		int s = slot(chunkCount - 1);
+		chunks[s].set(end++, time, value);
+		lastTimes[s] = time;
+		length++;
+	}
+
+	/**
+	 * Returns the entry at the specified position, counting from the first
+	 * entry which has not been purged.
+	 */
+	public TemporalScalar get(int index) {
+		if (index < 0 || index >= length) throw new IndexOutOfBoundsException(String.valueOf(index));
+		int i = begin + index;
+		return chunks[slot(i / chunkSize)].get(i % chunkSize);
+	}
+
+	/**
+	 * Remove all the entries before the last entry whose time is earlier than the
+	 * specified time, which is kept so that values up to that time can still be
+	 * interpolated. This is the same behaviour as {@link AcceleratedTimeSeries#purge}.
+	 * Every chunk which no longer contains any entries is released.
+	 */
+	public void purge(double time) {
+		int position = search(time, null);
+		if (position <= 1) return;
+
+		begin += position - 1;
+		length -= position - 1;
+
+		while (begin >= chunkSize) {
+			release(chunks[head]);
+			chunks[head] = null;
+			head = (head + 1) % chunks.length;
+			chunkCount--;
+			begin -= chunkSize;
+		}
+
+		firstTimes[head] = chunks[head].toDouble(2 * begin);
+	}
+
+	/**
+	 * Returns the interpolated value of the series at the specified time, or null
+	 * if the time is outside of the entries of the series.
+	 */
+	public TemporalScalar valueAt(double time) {
+		double v = valueAt(time, null);
+		return Double.isNaN(v) ? null : new TemporalScalar(time, v);
+	}
+
+	/**
+	 * Interpolate the value of the series for every time in the specified {@link MemoryData},
+	 * storing the results in the destination. Times which are outside of the entries of the
+	 * series produce 0, like {@link org.almostrealism.time.computations.AcceleratedTimeSeriesValueAt}.
+	 * The times are read, and the results written, in one transfer, and each chunk that is
+	 * needed is read only once.
+	 */
+	public void valueAt(MemoryData times, MemoryData destination) {
+		int count = times.getMemLength();
+		if (destination.getMemLength() < count) {
+			throw new IllegalArgumentException("Destination is too small for " + count + " values");
+		}
+
+		double t[] = times.toArray(0, count);
+		double out[] = new double[count];
+		double cache[][] = new double[chunkCount][];
+
+		for (int i = 0; i < count; i++) {
+			double v = valueAt(t[i], cache);
+			out[i] = Double.isNaN(v) ? 0.0 : v;
+		}
+
+		destination.setMem(0, out, 0, count);
+	}
+
+	/**
+	 * Returns the interpolated value at the specified time, or NaN. If a cache
+	 * is provided, the entries of each chunk are read into it the first time
+	 * they are needed, rather than being read from the chunk one at a time.
+	 */
+	protected double valueAt(double time, double cache[][]) {
+		int right = search(time, cache);
+		if (right >= length) return Double.NaN;
+
+		double rt = time(right, cache);
+		double rv = value(right, cache);
+
+		if (right == 0) {
+			return rt == time ? rv : Double.NaN;
+		}
+
+		double lt = time(right - 1, cache);
+		double lv = value(right - 1, cache);
+		if (lt > time) return Double.NaN;
+
+		double t2 = rt - lt;
+		return t2 == 0 ? lv : lv + ((time - lt) / t2) * (rv - lv);
+	}
+
+	/**
+	 * Returns the position of the first entry whose time is not earlier than the
+	 * specified time, or the length of the series if there is no such entry.
+	 */
+	protected int search(double time, double cache[][]) {
+		if (length == 0) return 0;
+
+		// Find the first chunk which ends at or after the time
+		int lo = 0, hi = chunkCount;
+		while (lo < hi) {
+			int mid = (lo + hi) >>> 1;
+			if (lastTimes[slot(mid)] < time) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		if (lo == chunkCount) return length;
+		if (firstTimes[slot(lo)] >= time) return Math.max(0, lo * chunkSize - begin);
+
+		// Then the first entry of that chunk which is at or after the time
+		int first = Math.max(0, lo * chunkSize - begin);
+		int last = Math.min(length, (lo + 1) * chunkSize - begin);
+
+		while (first < last) {
+			int mid = (first + last) >>> 1;
+			if (time(mid, cache) < time) {
+				first = mid + 1;
+			} else {
+				last = mid;
+			}
+		}
+
+		return first;
+	}
+
+	protected double time(int position, double cache[][]) {
+		return entry(position, cache, 0);
+	}
+
+	protected double value(int position, double cache[][]) {
+		return entry(position, cache, 1);
+	}
+
+	private double entry(int position, double cache[][], int component) {
+		int i = begin + position;
+		int k = i / chunkSize;
+		int offset = 2 * (i % chunkSize) + component;
+
+		if (cache == null) return chunks[slot(k)].toDouble(offset);
+
+		if (cache[k] == null) {
+			cache[k] = chunks[slot(k)].toArray(0, 2 * (k == chunkCount - 1 ? end : chunkSize));
+		}
+
+		return cache[k][offset];
+	}
+
+	private int slot(int chunk) {
+		return (head + chunk) % chunks.length;
+	}
+
+	private void grow() {
+		int capacity = 2 * chunks.length;
+		TemporalScalarBank c[] = new TemporalScalarBank[capacity];
+		double f[] = new double[capacity];
+		double l[] = new double[capacity];
+
+		for (int k = 0; k < chunkCount; k++) {
+			c[k] = chunks[slot(k)];
+			f[k] = firstTimes[slot(k)];
+			l[k] = lastTimes[slot(k)];
+		}
+
+		chunks = c;
+		firstTimes = f;
+		lastTimes = l;
+		head = 0;
+	}
+
+	/** Release every chunk, leaving the series empty. */
+	@Override
+	public void reset() {
+		Lifecycle.super.reset();
+
+		for (int k = 0; k < chunkCount; k++) {
+			int s = slot(k);
+			release(chunks[s]);
+			chunks[s] = null;
+		}
+
+		head = 0;
+		chunkCount = 0;
+		begin = 0;
+		end = 0;
+		length = 0;
+	}
+
+	/** Release every chunk, after which the series should no longer be used. */
+	public void destroy() {
+		reset();
+	}
+
+	protected static TemporalScalarBank acquire(int size) {
+		TemporalScalarBank chunk = queue(size).poll();
+		return chunk == null ? new TemporalScalarBank(size, CacheLevel.NONE) : chunk;
+	}
+
+	protected static void release(TemporalScalarBank chunk) {
+		if (!queue(chunk.getCount()).offer(chunk)) chunk.destroy();
+	}
+
+	private static BlockingQueue<TemporalScalarBank> queue(int size) {
+		return recycled.computeIfAbsent(size, s -> new LinkedBlockingQueue<>(Math.max(1, maxRecycledChunks)));
+	}
+}
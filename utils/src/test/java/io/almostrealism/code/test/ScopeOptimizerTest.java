@@ -0,0 +1,188 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package io.almostrealism.code.test;
+
+import io.almostrealism.code.ExplicitScope;
+import io.almostrealism.code.ScopeInputManager;
+import io.almostrealism.code.ScopeOptimizer;
+import io.almostrealism.expression.Expression;
+import io.almostrealism.expression.InstanceReference;
+import io.almostrealism.expression.Product;
+import io.almostrealism.expression.Sum;
+import io.almostrealism.relation.Evaluable;
+import io.almostrealism.scope.Argument;
+import io.almostrealism.scope.Argument.Expectation;
+import io.almostrealism.scope.Scope;
+import io.almostrealism.scope.Variable;
+import org.almostrealism.CodeFeatures;
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.hardware.AcceleratedComputationOperation;
+import org.almostrealism.hardware.DynamicOperationComputationAdapter;
+import org.almostrealism.hardware.HardwareFeatures;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.util.Arrays;
+import java.util.List;
+import java.util.function.Supplier;
+import java.util.stream.Collectors;
+
+public class ScopeOptimizerTest implements HardwareFeatures, CodeFeatures {
+	@Test
+	public void eliminate() {
+		Scope<Double> scope = new Scope<>("eliminate");
+		scope.getVariables().add(pure(new Variable<>("a", Double.class, "(x * y) + z")));
+		scope.getVariables().add(pure(new Variable<>("b", Double.class, "(x * y) + z")));
+
+		// Expressions which are not marked as pure are never combined
+		scope.getVariables().add(new Variable<>("c", Double.class, "rand(x)"));
+		scope.getVariables().add(new Variable<>("d", Double.class, "rand(x)"));
+
+		Variable<Double, ?> assignment = new Variable<>("x", Double.class, "x + 1.0");
+		assignment.setDeclaration(false);
+		scope.getVariables().add(assignment);
+		scope.getVariables().add(pure(new Variable<>("e", Double.class, "(x * y) + z")));
+
+		ScopeOptimizer optimizer = new ScopeOptimizer();
+		optimizer.optimize(scope);
+
+		Assert.assertEquals(1, optimizer.getEliminated());
+		Assert.assertEquals("a", scope.getVariables().get(1).getExpression().getExpression());
+		Assert.assertEquals("rand(x)", scope.getVariables().get(3).getExpression().getExpression());
+		Assert.assertEquals("(x * y) + z", scope.getVariables().get(5).getExpression().getExpression());
+	}
+
+	@Test
+	public void prune() {
+		ExplicitScope<Double> scope = new ExplicitScope<>("prune", "out[0] = in[0] * 2.0;\n");
+		scope.setArguments(Arrays.asList(argument("out"), argument("in"), argument("unused")));
+
+		ScopeOptimizer optimizer = new ScopeOptimizer();
+		optimizer.optimize(scope);
+
+		List<String> names = scope.getDependencies().stream().map(Argument::getName).collect(Collectors.toList());
+		Assert.assertEquals(1, optimizer.getPruned());
+		Assert.assertEquals(Arrays.asList("out", "in"), names);
+	}
+
+	@Test
+	public void eliminateInKernel() {
+		boolean optimization = AcceleratedComputationOperation.enableScopeOptimization;
+		AcceleratedComputationOperation.enableScopeOptimization = true;
+
+		try {
+			Scalar out = new Scalar();
+			SquareSum computation = new SquareSum(p(out), p(new Scalar(3.0)));
+			AcceleratedComputationOperation<Void> op = (AcceleratedComputationOperation<Void>) compileRunnable(computation);
+
+			Scope<Void> scope = op.compile();
+			Variable<?, ?> first = variable(scope, computation.getVariableName(0));
+			Variable<?, ?> second = variable(scope, computation.getVariableName(1));
+			Assert.assertTrue(first.getExpression().getExpression().contains("*"));
+			Assert.assertEquals(first.getName(), second.getExpression().getExpression());
+
+			op.run();
+			Assert.assertEquals(18.0, out.getValue(), 1e-5);
+		} finally {
+			AcceleratedComputationOperation.enableScopeOptimization = optimization;
+		}
+	}
+
+	@Test
+	public void purity() {
+		Assert.assertTrue(new Expression<>(Double.class, "(_arg1[_arg1Offset] * 2.0) + 1e-5").isPure());
+		Assert.assertTrue(new Expression<>(Double.class, "pow((double) x, 2.0) > 0.0 ? x : -x").isPure());
+		Assert.assertTrue(new Product(new Expression<>(Double.class, "x"), new Expression<>(Double.class, "sqrt(y)")).isPure());
+		Assert.assertFalse(new Expression<>(Double.class, "rand(x)").isPure());
+		Assert.assertFalse(new Expression<>(Double.class, "x = 1.0").isPure());
+		Assert.assertFalse(new Expression<>(Double.class, "x++").isPure());
+		Assert.assertFalse(new Sum(new Expression<>(Double.class, "x"), new Expression<>(Double.class, "rand(x)")).isPure());
+
+		Expression<Double> marked = new Expression<>(Double.class, "x");
+		marked.setPure(false);
+		Assert.assertFalse(marked.isPure());
+	}
+
+	@Test
+	public void pruneSimilarNames() {
+		ExplicitScope<Double> scope = new ExplicitScope<>("pruneSimilarNames",
+				"out[0] = _arg10[0] * _arg2[_arg3Offset];\n");
+		scope.setArguments(Arrays.asList(argument("out"), argument("_arg1"),
+				argument("_arg10"), argument("_arg2"), argument("_arg3")));
+
+		ScopeOptimizer optimizer = new ScopeOptimizer();
+		optimizer.optimize(scope);
+
+		List<String> names = scope.getDependencies().stream().map(Argument::getName).collect(Collectors.toList());
+		Assert.assertEquals(1, optimizer.getPruned());
+		Assert.assertEquals(Arrays.asList("out", "_arg10", "_arg2", "_arg3"), names);
+	}
+
+	@Test
+	public void pruneOnly() {
+		Scope<Double> scope = new Scope<>("pruneOnly");
+		scope.getVariables().add(pure(new Variable<>("a", Double.class, "(x * y) + z")));
+		scope.getVariables().add(pure(new Variable<>("b", Double.class, "(x * y) + z")));
+
+		ScopeOptimizer optimizer = new ScopeOptimizer(false, true);
+		optimizer.optimize(scope);
+
+		Assert.assertEquals(0, optimizer.getEliminated());
+		Assert.assertEquals("(x * y) + z", scope.getVariables().get(1).getExpression().getExpression());
+	}
+
+	private static Variable<?, ?> variable(Scope<?> scope, String name) {
+		return scope.getVariables().stream()
+				.filter(v -> name.equals(v.getName()))
+				.findFirst().orElseThrow(() -> new AssertionError(name + " was not declared"));
+	}
+
+	private static <T> Variable<T, ?> pure(Variable<T, ?> v) {
+		v.getExpression().setPure(true);
+		return v;
+	}
+
+	private static Argument<Double> argument(String name) {
+		return new Argument<>(new Variable<>(name, Double.class, (String) null), Expectation.EVALUATE_AHEAD);
+	}
+
+	/** Declares the square of its input twice, as the value of each element of a generated kernel may be. */
+	private static class SquareSum extends DynamicOperationComputationAdapter {
+		private boolean prepared = false;
+
+		public SquareSum(Supplier<Evaluable<? extends Scalar>> result, Supplier<Evaluable<? extends Scalar>> value) {
+			super(new Supplier[] { result, value });
+		}
+
+		@Override
+		public void prepareScope(ScopeInputManager manager) {
+			super.prepareScope(manager);
+			if (prepared) return;
+
+			Variable first = new Variable(getVariableName(0), true,
+					new Product(getArgument(1).valueAt(0), getArgument(1).valueAt(0)), this);
+			Variable second = new Variable(getVariableName(1), true,
+					new Product(getArgument(1).valueAt(0), getArgument(1).valueAt(0)), this);
+
+			addVariable(first);
+			addVariable(second);
+			addVariable(getArgument(0).valueAt(0).assign(new Sum(new InstanceReference(first), new InstanceReference(second))));
+			prepared = true;
+		}
+	}
+}
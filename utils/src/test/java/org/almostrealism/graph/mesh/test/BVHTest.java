@@ -0,0 +1,135 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.graph.mesh.test;
+
+import org.almostrealism.algebra.Pair;
+import org.almostrealism.algebra.PairBank;
+import org.almostrealism.algebra.Vector;
+import org.almostrealism.geometry.Ray;
+import org.almostrealism.geometry.RayBank;
+import org.almostrealism.graph.mesh.TriangleDataBank;
+import org.almostrealism.space.BVH;
+import org.almostrealism.space.MeshData;
+import org.almostrealism.util.TestFeatures;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.util.Random;
+
+public class BVHTest implements TestFeatures {
+	private static final int GRID = 20;
+
+	/** Two triangles for each cell of a grid covering [0, GRID] in x and y, at the specified z. */
+	protected TriangleDataBank grid(double z) {
+		return grid(new TriangleDataBank(GRID * GRID * 2), z);
+	}
+
+	protected <T extends TriangleDataBank> T grid(T bank, double z) {
+		for (int x = 0; x < GRID; x++) {
+			for (int y = 0; y < GRID; y++) {
+				int i = 2 * (x * GRID + y);
+				bank.setMem(i * 12, 1, 0, 0, 0, 1, 0, x, y, z, 0, 0, 1);
+				bank.setMem((i + 1) * 12, -1, 0, 0, 0, -1, 0, x + 1, y + 1, z, 0, 0, 1);
+			}
+		}
+
+		return bank;
+	}
+
+	@Test
+	public void intersect() {
+		TriangleDataBank triangles = grid(0.0);
+		BVH bvh = new BVH(triangles);
+		Assert.assertTrue(bvh.getNodeCount() > 1);
+
+		Random random = new Random(3);
+
+		for (int n = 0; n < 200; n++) {
+			double x = random.nextDouble() * GRID, y = random.nextDouble() * GRID;
+			Pair<?> hit = bvh.intersect(new Ray(new Vector(x, y, 1.0), new Vector(0.0, 0.0, -1.0)));
+			Assert.assertEquals(1.0, hit.getA(), 1e-9);
+
+			int cell = (int) hit.getB() / 2;
+			Assert.assertEquals((int) x, cell / GRID);
+			Assert.assertEquals((int) y, cell % GRID);
+		}
+
+		Pair<?> miss = bvh.intersect(new Ray(new Vector(-5.0, -5.0, 1.0), new Vector(0.0, 0.0, -1.0)));
+		Assert.assertEquals(-1.0, miss.getB(), 0.0);
+	}
+
+	@Test
+	public void refit() {
+		TriangleDataBank triangles = grid(0.0);
+		BVH bvh = new BVH(triangles);
+		int nodes = bvh.getNodeCount();
+
+		for (int i = 0; i < triangles.getCount(); i++) {
+			triangles.setMem(i * 12 + 8, -0.5);
+		}
+
+		bvh.refit();
+		Assert.assertEquals(nodes, bvh.getNodeCount());
+
+		Pair<?> hit = bvh.intersect(new Ray(new Vector(3.25, 7.5, 1.0), new Vector(0.0, 0.0, -1.0)));
+		Assert.assertEquals(1.5, hit.getA(), 1e-9);
+	}
+
+	@Test
+	public void kernel() {
+		MeshData data = grid(new MeshData(GRID * GRID * 2), 0.0);
+
+		Random random = new Random(5);
+		RayBank rays = new RayBank(64);
+
+		for (int i = 0; i < rays.getCount(); i++) {
+			// Some of the rays start outside the grid and miss it
+			double x = random.nextDouble() * (GRID + 4) - 2, y = random.nextDouble() * (GRID + 4) - 2;
+			rays.set(i, new Ray(new Vector(x, y, 1.0), new Vector(0.1, -0.05, -1.0)));
+		}
+
+		PairBank kernel = new PairBank(rays.getCount());
+		data.getBVH().getIntersectionKernel().kernelEvaluate(kernel, rays);
+		assertMatchesBruteForce(data, rays, kernel);
+
+		// The BVH should be refit when the triangles are written with setMem
+		for (int i = 0; i < data.getCount(); i++) {
+			data.setMem(i * 12 + 8, -0.5);
+		}
+
+		data.getBVH().getIntersectionKernel().kernelEvaluate(kernel, rays);
+		assertMatchesBruteForce(data, rays, kernel);
+	}
+
+	protected void assertMatchesBruteForce(MeshData data, RayBank rays, PairBank kernel) {
+		boolean bvh = MeshData.enableBVH;
+		MeshData.enableBVH = false;
+
+		try {
+			for (int i = 0; i < rays.getCount(); i++) {
+				Ray r = rays.get(i);
+				Pair<?> expected = data.evaluateIntersection(args -> r, new Object[0]);
+
+				Assert.assertEquals(expected.getB(), kernel.get(i).getB(), 0.0);
+				if (expected.getB() >= 0) Assert.assertEquals(expected.getA(), kernel.get(i).getA(), 1e-4);
+			}
+		} finally {
+			MeshData.enableBVH = bvh;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.graph.test;
+
+import org.almostrealism.graph.FlatKdTree;
+import org.almostrealism.graph.KdTree;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.util.Arrays;
+import java.util.Random;
+
+public class FlatKdTreeTest {
+	@Test
+	public void nearestNeighbors() {
+		Random random = new Random(7);
+		int count = 5000, queries = 2000, k = 5;
+
+		KdTree.SqrEuclid<Integer> tree = new KdTree.SqrEuclid<>(3, null);
+		double points[][] = new double[count][];
+
+		for (int i = 0; i < count; i++) {
+			points[i] = new double[] { random.nextDouble(), random.nextDouble(), random.nextDouble() };
+			tree.addPoint(points[i], i);
+		}
+
+		FlatKdTree<Integer> flat = tree.flatten();
+		Assert.assertEquals(count, flat.size());
+
+		double locations[] = new double[queries * 3];
+		for (int i = 0; i < locations.length; i++) locations[i] = random.nextDouble();
+
+		int indices[] = new int[queries * k];
+		double distances[] = new double[queries * k];
+		flat.nearestNeighbors(locations, queries, k, indices, distances);
+
+		for (int q = 0; q < queries; q++) {
+			double expected[] = new double[count];
+
+			for (int i = 0; i < count; i++) {
+				double dx = points[i][0] - locations[3 * q];
+				double dy = points[i][1] - locations[3 * q + 1];
+				double dz = points[i][2] - locations[3 * q + 2];
+				expected[i] = dx * dx + dy * dy + dz * dz;
+			}
+
+			double sorted[] = expected.clone();
+			Arrays.sort(sorted);
+
+			for (int j = 0; j < k; j++) {
+				Assert.assertEquals(sorted[j], distances[q * k + j], 1e-12);
+
+				int value = flat.getValue(indices[q * k + j]);
+				Assert.assertEquals(sorted[j], expected[value], 1e-12);
+			}
+		}
+	}
+
+	@Test
+	public void fewerPoints() {
+		FlatKdTree<String> flat = new FlatKdTree<>(new double[][] { { 0, 0 }, { 1, 1 } }, Arrays.asList("a", "b"));
+
+		int indices[] = new int[3];
+		double distances[] = new double[3];
+		flat.nearestNeighbors(new double[] { 0.9, 0.9 }, 3, indices, distances);
+
+		Assert.assertEquals("b", flat.getValue(indices[0]));
+		Assert.assertEquals("a", flat.getValue(indices[1]));
+		Assert.assertEquals(-1, indices[2]);
+		Assert.assertEquals(Double.POSITIVE_INFINITY, distances[2], 0.0);
+	}
+}
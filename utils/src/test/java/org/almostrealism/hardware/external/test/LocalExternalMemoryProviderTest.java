@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.hardware.external.test;
+
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.algebra.ScalarBank;
+import org.almostrealism.hardware.MemoryData;
+import org.almostrealism.hardware.external.LocalExternalMemoryProvider;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.io.File;
+import java.io.IOException;
+
+public class LocalExternalMemoryProviderTest {
+	@Test
+	public void offsetRoundTrip() throws IOException {
+		boolean lazy = LocalExternalMemoryProvider.enableLazyReading;
+		LocalExternalMemoryProvider.enableLazyReading = false;
+
+		File file = File.createTempFile("offsetRoundTrip", ".bin");
+
+		try {
+			ScalarBank bank = new ScalarBank(5);
+			for (int i = 0; i < bank.getCount(); i++) bank.set(i, 2 * i, 2 * i + 1);
+
+			Scalar view = bank.get(2);
+			Assert.assertEquals(4, view.getOffset());
+
+			Files.write(file, view);
+			view.setMem(0, 0.0, 0.0);
+			Files.read(file, view);
+
+			Assert.assertEquals(4.0, view.getValue(), 1e-6);
+			Assert.assertEquals(5.0, view.getCertainty(), 1e-6);
+			Assert.assertEquals(2.0, bank.get(1).getValue(), 1e-6);
+		} finally {
+			LocalExternalMemoryProvider.enableLazyReading = lazy;
+			file.delete();
+		}
+	}
+
+	/** Provides access to the files used for the arguments of external operations. */
+	private static class Files extends LocalExternalMemoryProvider {
+		private Files() { super(null); }
+
+		public static void write(File dest, MemoryData mem) throws IOException { writeBinary(dest, mem); }
+
+		public static void read(File src, MemoryData mem) throws IOException { readBinary(src, mem); }
+	}
+}
@@ -8,8 +8,11 @@ import org.almostrealism.hardware.HardwareFeatures;
 import org.almostrealism.CodeFeatures;
 import org.almostrealism.hardware.PassThroughEvaluable;
 import io.almostrealism.relation.Evaluable;
+import org.junit.Assert;
 import org.junit.Test;
 
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.AtomicReference;
 import java.util.function.Supplier;
 
 public class AcceleratedComputationOperationTest implements HardwareFeatures, CodeFeatures {
@@ -20,4 +23,43 @@ public class AcceleratedComputationOperationTest implements HardwareFeatures, Co
 
 		AcceleratedComputationEvaluable<Vector> s = (AcceleratedComputationEvaluable) compileProducer(new VectorSum(v, in));
 	}
+
+	@Test
+	public void concurrentEvaluation() throws InterruptedException {
+		VectorProducer v = vector(1.0, 2.0, 3.0);
+		Supplier<Evaluable<? extends Vector>> in = PassThroughEvaluable.of(Vector.class, 0);
+
+		AcceleratedComputationEvaluable<Vector> s = (AcceleratedComputationEvaluable) compileProducer(new VectorSum(v, in));
+		AtomicReference<Throwable> failure = new AtomicReference<>();
+		CountDownLatch start = new CountDownLatch(1);
+		Thread threads[] = new Thread[8];
+
+		for (int i = 0; i < threads.length; i++) {
+			int t = i;
+
+			threads[i] = new Thread(() -> {
+				try {
+					start.await();
+
+					for (int n = 0; n < 100; n++) {
+						// Releasing while other threads are evaluating must not affect them
+						if (t == 0 && n % 10 == 0) s.releaseInstructions();
+
+						Vector result = s.evaluate(new Vector(t, n, 0.0));
+						Assert.assertEquals(1.0 + t, result.getX(), 1e-5);
+						Assert.assertEquals(2.0 + n, result.getY(), 1e-5);
+						Assert.assertEquals(3.0, result.getZ(), 1e-5);
+					}
+				} catch (Throwable e) {
+					failure.compareAndSet(null, e);
+				}
+			});
+			threads[i].start();
+		}
+
+		start.countDown();
+		for (Thread t : threads) t.join();
+
+		if (failure.get() != null) throw new AssertionError(failure.get());
+	}
 }
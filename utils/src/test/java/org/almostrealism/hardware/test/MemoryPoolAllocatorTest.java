@@ -0,0 +1,131 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.test;
+
+import org.almostrealism.hardware.Hardware;
+import org.almostrealism.hardware.mem.MemoryDataAdapter;
+import org.almostrealism.hardware.mem.MemoryPoolAllocator;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class MemoryPoolAllocatorTest {
+	private final int numberSize = Hardware.getLocalHardware().getNumberSize();
+
+	@Test
+	public void sizeClasses() {
+		MemoryPoolAllocator allocator = new MemoryPoolAllocator(64L * MemoryPoolAllocator.SLAB_SIZE * numberSize, numberSize);
+
+		try {
+			Assert.assertFalse(allocator.reserve(new Owner(0)));
+			Assert.assertEquals(MemoryPoolAllocator.MIN_SIZE, segmentSize(allocator, 1));
+			Assert.assertEquals(MemoryPoolAllocator.MIN_SIZE, segmentSize(allocator, MemoryPoolAllocator.MIN_SIZE));
+			Assert.assertEquals(8, segmentSize(allocator, 5));
+			Assert.assertEquals(1024, segmentSize(allocator, 1000));
+			Assert.assertEquals(MemoryPoolAllocator.MAX_SIZE, segmentSize(allocator, MemoryPoolAllocator.MAX_SIZE));
+			Assert.assertFalse(allocator.reserve(new Owner(MemoryPoolAllocator.MAX_SIZE + 1)));
+		} finally {
+			allocator.destroy();
+		}
+	}
+
+	@Test
+	public void budget() {
+		int size = MemoryPoolAllocator.MAX_SIZE / 2;
+		MemoryPoolAllocator allocator = new MemoryPoolAllocator((long) MemoryPoolAllocator.MAX_SIZE * numberSize, numberSize);
+
+		try {
+			Owner first = new Owner(size);
+			Owner second = new Owner(size);
+			Assert.assertTrue(allocator.reserve(first));
+			Assert.assertTrue(allocator.reserve(second));
+			Assert.assertEquals(allocator.getBudget(), allocator.getAllocated());
+
+			// Every slab is in use, so these must be left to the provider
+			Owner third = new Owner(size);
+			Assert.assertFalse(allocator.reserve(third));
+			Assert.assertNull(third.getDelegate());
+			Assert.assertFalse(allocator.reserve(new Owner(1)));
+			Assert.assertEquals(allocator.getBudget(), allocator.getAllocated());
+		} finally {
+			allocator.destroy();
+		}
+	}
+
+	@Test
+	public void releaseOnDestroy() {
+		MemoryPoolAllocator allocator = new MemoryPoolAllocator(4L * MemoryPoolAllocator.SLAB_SIZE * numberSize, numberSize);
+
+		try {
+			Owner owner = new Owner(3);
+			Assert.assertTrue(allocator.reserve(owner));
+			Assert.assertTrue(owner.getDelegate() instanceof MemoryPoolAllocator.Slab);
+
+			MemoryPoolAllocator.Slab slab = (MemoryPoolAllocator.Slab) owner.getDelegate();
+			Assert.assertEquals(1, slab.getReserved());
+			Assert.assertEquals((long) MemoryPoolAllocator.MIN_SIZE * numberSize, allocator.getReserved());
+
+			owner.destroy();
+			Assert.assertEquals(0, slab.getReserved());
+			Assert.assertEquals(0, allocator.getReserved());
+			Assert.assertFalse(MemoryPoolAllocator.release(owner));
+		} finally {
+			allocator.destroy();
+		}
+	}
+
+	@Test
+	public void trim() {
+		long slabBytes = (long) MemoryPoolAllocator.SLAB_SIZE * numberSize;
+		MemoryPoolAllocator allocator = new MemoryPoolAllocator(4 * slabBytes, numberSize);
+
+		try {
+			Owner released = new Owner(4);
+			Owner kept = new Owner(8);
+			Assert.assertTrue(allocator.reserve(released));
+			Assert.assertTrue(allocator.reserve(kept));
+			Assert.assertEquals(2 * slabBytes, allocator.getAllocated());
+
+			released.destroy();
+			allocator.trim();
+
+			Assert.assertEquals(slabBytes, allocator.getAllocated());
+			Assert.assertEquals(8L * numberSize, allocator.getReserved());
+			Assert.assertTrue(kept.getDelegate() instanceof MemoryPoolAllocator.Slab);
+			Assert.assertEquals(1, ((MemoryPoolAllocator.Slab) kept.getDelegate()).getReserved());
+		} finally {
+			allocator.destroy();
+		}
+	}
+
+	private int segmentSize(MemoryPoolAllocator allocator, int size) {
+		Owner owner = new Owner(size);
+		Assert.assertTrue(allocator.reserve(owner));
+		return owner.getDelegate().getAtomicMemLength();
+	}
+
+	/** A {@link org.almostrealism.hardware.MemoryData} which only obtains memory from the allocator under test. */
+	private static class Owner extends MemoryDataAdapter {
+		private final int memLength;
+
+		public Owner(int memLength) {
+			this.memLength = memLength;
+		}
+
+		@Override
+		public int getMemLength() { return memLength; }
+	}
+}
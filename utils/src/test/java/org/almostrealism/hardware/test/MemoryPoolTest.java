@@ -0,0 +1,189 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.test;
+
+import org.almostrealism.algebra.Scalar;
+import org.almostrealism.hardware.mem.MemoryPool;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.AtomicReference;
+
+public class MemoryPoolTest {
+	@Test
+	public void reclaimAfterCollection() {
+		long timeout = MemoryPool.exhaustionTimeout;
+		MemoryPool.exhaustionTimeout = 5000;
+
+		MemoryPool<Scalar> pool = new MemoryPool<>(2, 16);
+
+		try {
+			for (int i = 0; i < pool.getCapacity(); i++) {
+				pool.reserveOffset(new Scalar(false));
+			}
+
+			Assert.assertEquals(pool.getCapacity(), pool.getReserved());
+
+			System.gc();
+
+			Scalar owner = new Scalar(false);
+			int offset = pool.reserveOffset(owner);
+			Assert.assertTrue(offset >= 0);
+			Assert.assertTrue(pool.getReclaimed() > 0);
+		} finally {
+			MemoryPool.exhaustionTimeout = timeout;
+			pool.destroy();
+		}
+	}
+
+	@Test
+	public void concurrentReservations() throws InterruptedException {
+		MemoryPool<Scalar> pool = new MemoryPool<>(2, 64);
+		Set<Integer> reserved = ConcurrentHashMap.newKeySet();
+		AtomicReference<Throwable> failure = new AtomicReference<>();
+
+		CountDownLatch start = new CountDownLatch(1);
+		Thread threads[] = new Thread[8];
+
+		for (int i = 0; i < threads.length; i++) {
+			threads[i] = new Thread(() -> {
+				try {
+					start.await();
+
+					Scalar owners[] = new Scalar[4];
+					int offsets[] = new int[owners.length];
+
+					for (int n = 0; n < 1000; n++) {
+						for (int j = 0; j < owners.length; j++) {
+							owners[j] = new Scalar(false);
+							offsets[j] = pool.reserveOffset(owners[j]);
+							if (!reserved.add(offsets[j]))
+								throw new AssertionError("Offset " + offsets[j] + " was reserved twice");
+						}
+
+						for (int j = 0; j < owners.length; j++) {
+							reserved.remove(offsets[j]);
+							if (!pool.release(owners[j], offsets[j]))
+								throw new AssertionError("Offset " + offsets[j] + " was not released");
+						}
+					}
+				} catch (Throwable e) {
+					failure.compareAndSet(null, e);
+				}
+			});
+			threads[i].start();
+		}
+
+		start.countDown();
+		for (Thread t : threads) t.join();
+
+		try {
+			if (failure.get() != null) throw new AssertionError(failure.get());
+			Assert.assertEquals(0, pool.getReserved());
+		} finally {
+			pool.destroy();
+		}
+	}
+
+	@Test
+	public void tryReserveAndRelease() {
+		MemoryPool<Scalar> pool = new MemoryPool<>(2, 2);
+
+		try {
+			Scalar first = new Scalar(false);
+			Scalar second = new Scalar(false);
+			Scalar third = new Scalar(false);
+
+			int a = pool.tryReserveOffset(first);
+			int b = pool.tryReserveOffset(second);
+			Assert.assertTrue(a >= 0);
+			Assert.assertTrue(b >= 0);
+			Assert.assertNotEquals(a, b);
+			Assert.assertEquals(-1, pool.tryReserveOffset(third));
+
+			Assert.assertFalse(pool.release(third, b));
+			Assert.assertTrue(pool.release(first, a));
+			Assert.assertFalse(pool.release(first, a));
+			Assert.assertEquals(1, pool.getReserved());
+
+			Assert.assertEquals(a, pool.tryReserveOffset(third));
+			Assert.assertEquals(-1, pool.tryReserveOffset(first));
+		} finally {
+			pool.destroy();
+		}
+
+		Assert.assertEquals(-1, pool.tryReserveOffset(new Scalar(false)));
+	}
+
+	@Test
+	public void reserveFromOtherThreadCache() throws InterruptedException {
+		boolean threadCache = MemoryPool.enableThreadCache;
+		MemoryPool.enableThreadCache = true;
+
+		MemoryPool<Scalar> pool;
+
+		try {
+			pool = new MemoryPool<>(2, 1024);
+		} finally {
+			MemoryPool.enableThreadCache = threadCache;
+		}
+
+		CountDownLatch reserved = new CountDownLatch(1);
+		CountDownLatch done = new CountDownLatch(1);
+		Scalar parked = new Scalar(false);
+
+		// This thread takes a batch of segments into its cache, and
+		// remains alive so that they are not returned when it ends
+		Thread other = new Thread(() -> {
+			pool.reserveOffset(parked);
+			reserved.countDown();
+
+			try {
+				done.await();
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
+		});
+		other.start();
+
+		try {
+			reserved.await();
+
+			List<Scalar> owners = new ArrayList<>();
+			Set<Integer> offsets = new HashSet<>();
+
+			for (int i = 0; i < pool.getCapacity() - 1; i++) {
+				Scalar owner = new Scalar(false);
+				owners.add(owner);
+				Assert.assertTrue(offsets.add(pool.reserveOffset(owner)));
+			}
+
+			Assert.assertEquals(pool.getCapacity(), pool.getReserved());
+			Assert.assertEquals(pool.getCapacity() - 1, owners.size());
+		} finally {
+			done.countDown();
+			other.join();
+			pool.destroy();
+		}
+	}
+}
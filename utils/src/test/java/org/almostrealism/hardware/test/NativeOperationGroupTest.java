@@ -0,0 +1,46 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.hardware.test;
+
+import io.almostrealism.scope.Scope;
+import org.almostrealism.hardware.jni.NativeOperationGroup;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class NativeOperationGroupTest {
+	@Test
+	public void sharedRequiredScope() {
+		Scope<?> shared = new Scope<>("shared");
+
+		Scope<?> first = new Scope<>("first");
+		first.getRequiredScopes().add(shared);
+
+		Scope<?> second = new Scope<>("second");
+		second.getRequiredScopes().add(shared);
+
+		NativeOperationGroup group = new NativeOperationGroup(null);
+		group.add(first);
+		group.add(second);
+
+		String code = group.getCode();
+		int definitions = code.split("shared\\(", -1).length - 1;
+		Assert.assertEquals(code, 1, definitions);
+		Assert.assertTrue(code.contains(group.getName() + "_0("));
+		Assert.assertTrue(code.contains(group.getName() + "_1("));
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+package org.almostrealism.hardware.test;
+
+import io.almostrealism.relation.Evaluable;
+import org.almostrealism.hardware.ProducerCache;
+import org.junit.Assert;
+import org.junit.Test;
+
+import java.util.List;
+import java.util.concurrent.CopyOnWriteArrayList;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.function.Supplier;
+
+public class ProducerCacheTest {
+	@Test
+	public void sharedAcrossThreads() throws InterruptedException {
+		boolean shared = ProducerCache.enableSharedEvaluableCache;
+		ProducerCache.enableSharedEvaluableCache = true;
+
+		try {
+			sharedAcrossThreads(8);
+		} finally {
+			ProducerCache.enableSharedEvaluableCache = shared;
+		}
+	}
+
+	private void sharedAcrossThreads(int count) throws InterruptedException {
+		AtomicInteger compiled = new AtomicInteger();
+		Evaluable<Double> value = args -> 1.0;
+
+		Supplier<Evaluable<? extends Double>> producer = () -> {
+			compiled.incrementAndGet();
+			return value;
+		};
+
+		List<Evaluable> results = new CopyOnWriteArrayList<>();
+		CountDownLatch start = new CountDownLatch(1);
+		Thread threads[] = new Thread[count];
+
+		for (int i = 0; i < threads.length; i++) {
+			threads[i] = new Thread(() -> {
+				try {
+					start.await();
+				} catch (InterruptedException e) {
+					return;
+				}
+
+				results.add(ProducerCache.getEvaluableForSupplier(producer));
+			});
+			threads[i].start();
+		}
+
+		start.countDown();
+		for (Thread t : threads) t.join();
+
+		Assert.assertEquals(1, compiled.get());
+		Assert.assertEquals(threads.length, results.size());
+		results.forEach(e -> Assert.assertSame(value, e));
+
+		ProducerCache.purgeEvaluableCache(producer);
+		ProducerCache.getEvaluableForSupplier(producer);
+		Assert.assertEquals(2, compiled.get());
+	}
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+package org.almostrealism.hardware.test;
+
+import org.almostrealism.hardware.profile.ProfileData;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class ProfileDataTest {
+	@Test
+	public void percentiles() {
+		ProfileData data = new ProfileData();
+		for (int i = 1; i <= 1000; i++) data.addRun(i * 1000L, 8);
+
+		Assert.assertEquals(1000, data.getTotalRuns());
+		Assert.assertEquals(8000, data.getTotalBytes());
+		Assert.assertEquals(500500.0, data.getAverageRuntimeNanos(), 0.001);
+
+		long p50 = data.getPercentileNanos(50);
+		long p99 = data.getPercentileNanos(99);
+		Assert.assertTrue(p50 >= 500000 && p50 <= 500000 * 1.25);
+		Assert.assertTrue(p99 >= 990000 && p99 <= 1000000);
+		Assert.assertEquals(1000000, data.getPercentileNanos(100));
+	}
+}
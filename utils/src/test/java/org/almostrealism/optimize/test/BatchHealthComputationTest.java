@@ -0,0 +1,180 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.optimize.test;
+
+import org.almostrealism.graph.Receptor;
+import org.almostrealism.heredity.Chromosome;
+import org.almostrealism.heredity.Genome;
+import org.almostrealism.optimize.BatchHealthComputation;
+import org.almostrealism.optimize.HealthScore;
+import org.almostrealism.optimize.Population;
+import org.almostrealism.optimize.PopulationOptimizer;
+import org.almostrealism.time.Temporal;
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.stream.Collectors;
+
+public class BatchHealthComputationTest {
+	private boolean breeding;
+	private int batchSize, batchThreads;
+
+	private AtomicInteger computations, scored;
+	private boolean fail;
+
+	private PopulationOptimizer<Double, Object, Temporal, HealthScore> optimizer;
+
+	@Before
+	public void init() {
+		breeding = PopulationOptimizer.enableBreeding;
+		batchSize = PopulationOptimizer.batchSize;
+		batchThreads = PopulationOptimizer.batchThreads;
+
+		PopulationOptimizer.batchSize = 4;
+		PopulationOptimizer.batchThreads = 2;
+
+		computations = new AtomicInteger();
+		scored = new AtomicInteger();
+
+		Random random = new Random(7);
+		List<Genome<Double>> genomes = new ArrayList<>();
+		for (int i = 0; i < 20; i++) genomes.add(new ValueGenome(random.nextDouble()));
+
+		optimizer = new PopulationOptimizer<>(new ListPopulation(genomes),
+				() -> {
+					computations.incrementAndGet();
+					return new ValueHealthComputation();
+				},
+				ListPopulation::new,
+				() -> (g1, g2) -> new ValueGenome((value(g1) + value(g2)) / 2),
+				null);
+	}
+
+	@After
+	public void destroy() {
+		optimizer.destroy();
+		PopulationOptimizer.enableBreeding = breeding;
+		PopulationOptimizer.batchSize = batchSize;
+		PopulationOptimizer.batchThreads = batchThreads;
+	}
+
+	@Test
+	public void ordering() {
+		PopulationOptimizer.enableBreeding = false;
+		Assert.assertTrue(optimizer.isBatchEvaluation());
+
+		double max = optimizer.getPopulation().getGenomes().stream().mapToDouble(BatchHealthComputationTest::value).max().getAsDouble();
+		optimizer.iterate();
+
+		Assert.assertEquals(20, scored.get());
+		Assert.assertEquals(20, optimizer.getPopulation().size());
+		Assert.assertEquals(max, optimizer.getMaxScore(), 0.0);
+		assertDescending(optimizer.getPopulation().getGenomes());
+	}
+
+	@Test
+	public void breeding() {
+		PopulationOptimizer.enableBreeding = true;
+		optimizer.iterate();
+
+		int children = optimizer.getPopulation().size();
+		Assert.assertTrue(children > 0);
+		Assert.assertEquals(children, scored.get());
+		Assert.assertTrue(computations.get() <= PopulationOptimizer.batchThreads);
+		assertDescending(optimizer.getPopulation().getGenomes());
+	}
+
+	@Test(expected = IllegalStateException.class)
+	public void failure() {
+		PopulationOptimizer.enableBreeding = false;
+		fail = true;
+		optimizer.iterate();
+	}
+
+	protected void assertDescending(List<Genome<Double>> genomes) {
+		for (int i = 1; i < genomes.size(); i++) {
+			Assert.assertTrue(value(genomes.get(i - 1)) >= value(genomes.get(i)));
+		}
+	}
+
+	protected static double value(Genome<?> genome) {
+		return ((ValueGenome) genome).value;
+	}
+
+	/** Scores each genome with its value, as a single batch. */
+	private class ValueHealthComputation implements BatchHealthComputation<Double, Temporal, HealthScore> {
+		@Override
+		public void setTarget(Temporal target) { }
+
+		@Override
+		public HealthScore computeHealth() { throw new UnsupportedOperationException(); }
+
+		@Override
+		public List<HealthScore> computeHealth(List<Genome<Double>> genomes) {
+			if (fail) throw new IllegalStateException();
+
+			scored.addAndGet(genomes.size());
+			return genomes.stream().map(g -> (HealthScore) () -> value(g)).collect(Collectors.toList());
+		}
+	}
+
+	private static class ValueGenome implements Genome<Double> {
+		private final double value;
+
+		public ValueGenome(double value) { this.value = value; }
+
+		@Override
+		public Genome getHeadSubset() { return null; }
+
+		@Override
+		public Chromosome getLastChromosome() { return null; }
+
+		@Override
+		public int count() { return 0; }
+
+		@Override
+		public Chromosome<Double> valueAt(int pos) { throw new IndexOutOfBoundsException(); }
+	}
+
+	private static class ListPopulation implements Population<Double, Object, Temporal> {
+		private final List<Genome<Double>> genomes;
+
+		public ListPopulation(List<Genome<Double>> genomes) { this.genomes = new ArrayList<>(genomes); }
+
+		@Override
+		public void init(Genome<Double> templateGenome, List<? extends Receptor<Object>> measures, Receptor<Object> output) { }
+
+		@Override
+		public List<Genome<Double>> getGenomes() { return genomes; }
+
+		@Override
+		public int size() { return genomes.size(); }
+
+		@Override
+		public Temporal enableGenome(int index) { throw new UnsupportedOperationException(); }
+
+		@Override
+		public void disableGenome() { }
+	}
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2022 Michael Murray
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+package org.almostrealism.time.test;
+
+import org.almostrealism.collect.PackedCollection;
+import org.almostrealism.time.ChunkedTimeSeries;
+import org.almostrealism.time.TemporalScalar;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class ChunkedTimeSeriesTest {
+	protected ChunkedTimeSeries series() {
+		ChunkedTimeSeries series = new ChunkedTimeSeries(2);
+		series.add(new TemporalScalar(1.0, 10));
+		series.add(new TemporalScalar(2.0, 12));
+		series.add(new TemporalScalar(3.0, 15));
+		series.add(new TemporalScalar(3.5, 16));
+		series.add(new TemporalScalar(5.0, 24));
+		return series;
+	}
+
+	@Test
+	public void valueAt() {
+		ChunkedTimeSeries series = series();
+		Assert.assertEquals(5, series.getLength());
+		Assert.assertEquals(3, series.getChunkCount());
+
+		Assert.assertEquals(10.0, series.valueAt(1.0).getValue(), Math.pow(10, -10));
+		Assert.assertEquals(13.5, series.valueAt(2.5).getValue(), Math.pow(10, -10));
+		Assert.assertEquals(15.5, series.valueAt(3.25).getValue(), Math.pow(10, -10));
+		Assert.assertEquals(20.0, series.valueAt(4.25).getValue(), Math.pow(10, -10));
+		Assert.assertEquals(24.0, series.valueAt(5.0).getValue(), Math.pow(10, -10));
+		Assert.assertNull(series.valueAt(0.5));
+		Assert.assertNull(series.valueAt(5.5));
+	}
+
+	@Test
+	public void purge() {
+		ChunkedTimeSeries series = series();
+		series.purge(3.2);
+
+		Assert.assertEquals(3, series.getLength());
+		Assert.assertEquals(2, series.getChunkCount());
+		Assert.assertEquals(3.0, series.get(0).getTime(), 0.0);
+		Assert.assertEquals(15.5, series.valueAt(3.25).getValue(), Math.pow(10, -10));
+		Assert.assertNull(series.valueAt(2.5));
+
+		series.add(6.0, 30);
+		Assert.assertEquals(27.0, series.valueAt(5.5).getValue(), Math.pow(10, -10));
+	}
+
+	@Test
+	public void batchValueAt() {
+		ChunkedTimeSeries series = series();
+
+		PackedCollection<?> times = new PackedCollection<>(4);
+		times.setMem(0, 2.5, 3.25, 4.25, 6.0);
+		PackedCollection<?> values = new PackedCollection<>(4);
+
+		series.valueAt(times, values);
+		Assert.assertEquals(13.5, values.toDouble(0), Math.pow(10, -10));
+		Assert.assertEquals(15.5, values.toDouble(1), Math.pow(10, -10));
+		Assert.assertEquals(20.0, values.toDouble(2), Math.pow(10, -10));
+		Assert.assertEquals(0.0, values.toDouble(3), 0.0);
+	}
+}